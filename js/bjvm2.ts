@@ -17,10 +17,8 @@ type BovineOSOptions = {
     fetchParams?: RequestInit;
 };
 
-export const DEFAULT_HEAP_SIZE = 1 << 26;  // 64 MB
-
 type VMOptions = {
-    // Fixed at instantiation time and not growable
+    // Maximum heap size in bytes. The heap starts at a few MB and grows up to this as needed.
     heapSize?: number;
     // Colon-separated class path (just like normal Java)
     classpath: string;
@@ -647,7 +645,7 @@ export class BovineVM<Classes> {
         this.boundOnStderr = this.onStderr.bind(this);
         this.boundOnStdout = this.onStdout.bind(this);
 
-        this.ptr = this._module._ffi_create_vm(classpath, options.heapSize ?? DEFAULT_HEAP_SIZE,
+        this.ptr = this._module._ffi_create_vm(classpath, options.heapSize ?? 0,
             this._module.addFunction(this.boundOnStderr, 'viii'), this._module.addFunction(this.boundOnStdout, 'viii'));
         this._module._free(classpath);
         if (this.ptr === 0) {
@@ -5,7 +5,7 @@ interface VMOptions {
     javaHome: string;
     // Colon-separated list of paths or JAR files where classes may be found
     classpath: string;
-    // Valid range: 1 << 14 to 1 << 30
+    // Maximum heap size. Valid range: 1 << 14 to 1 << 30
     heapSize: number;
 }
 
@@ -14,6 +14,6 @@ DECLARE_NATIVE("java/io", FileDescriptor, close0, "()V") {
   s32 fd = LoadFieldInt(obj->obj, "fd");
   if (fd != -1)
     close(fd);
-  StoreFieldInt(obj->obj, "fd", -1);
+  StoreFieldInt(thread, obj->obj, "fd", -1);
   return value_null();
 }
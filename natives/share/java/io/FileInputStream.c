@@ -21,7 +21,7 @@ DECLARE_NATIVE("java/io", FileInputStream, open0, "(Ljava/lang/String;)V") {
   obj_header *fd = LoadFieldObject(obj->obj, "java/io/FileDescriptor", "fd");
   DCHECK(fd);
   s32 unix_fd = open(filename.chars, O_RDONLY);
-  StoreFieldInt(fd, "fd", unix_fd);
+  StoreFieldInt(thread, fd, "fd", unix_fd);
 
   if (unix_fd < 0) {
     // TODO use errno to give a better error message
@@ -119,7 +119,7 @@ DECLARE_NATIVE("java/io", FileInputStream, close0, "()V") {
   s32 unix_fd = LoadFieldInt(fd, "fd");
   if (unix_fd != -1)
     close(unix_fd);
-  StoreFieldInt(fd, "fd", -1);
+  StoreFieldInt(thread, fd, "fd", -1);
 
   return value_null();
 }
@@ -52,7 +52,7 @@ DECLARE_NATIVE("java/io", FileOutputStream, close0, "()V") {
   s32 unix_fd = LoadFieldInt(fd, "fd");
   if (unix_fd != -1)
     close(unix_fd);
-  StoreFieldInt(fd, "fd", -1);
+  StoreFieldInt(thread, fd, "fd", -1);
 
   return value_null();
 }
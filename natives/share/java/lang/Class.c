@@ -67,18 +67,15 @@ DECLARE_NATIVE("java/lang", Class, getEnclosingMethod0, "()[Ljava/lang/Object;")
   }
   handle *array =
       make_handle(thread, CreateObjectArray1D(thread, bootstrap_lookup_class(thread, STR("java/lang/Object")), 3));
-#define data ((obj_header **)ArrayData(array->obj))
-
   int error = resolve_class(thread, enclosing_method.class_info);
   CHECK(!error);
-  data[0] = (void *)enclosing_method.class_info->classdesc->mirror;
+  ReferenceArrayStore(thread, array->obj, 0, (void *)enclosing_method.class_info->classdesc->mirror);
   if (enclosing_method.nat != nullptr) {
     object name = MakeJStringFromModifiedUTF8(thread, enclosing_method.nat->name, true); // todo oom
-    data[1] = name;
+    ReferenceArrayStore(thread, array->obj, 1, name);
     name = MakeJStringFromModifiedUTF8(thread, enclosing_method.nat->descriptor, true);
-    data[2] = name;
+    ReferenceArrayStore(thread, array->obj, 2, name);
   }
-#undef data
   stack_value result = (stack_value){.obj = array->obj};
   drop_handle(thread, array);
   return result;
@@ -141,7 +138,7 @@ DECLARE_NATIVE("java/lang", Class, initClassName, "()Ljava/lang/String;") {
   }
   name.len = classdesc->name.len;
   void *str = MakeJStringFromModifiedUTF8(thread, name, true);
-  StoreFieldObject(obj->obj, "java/lang/String", "name", str);
+  StoreFieldObject(thread, obj->obj, "java/lang/String", "name", str);
   return (stack_value){.obj = str};
 }
 
@@ -224,11 +221,10 @@ DECLARE_NATIVE("java/lang", Class, getDeclaredFields0, "(Z)[Ljava/lang/reflect/F
   obj_header *result = CreateObjectArray1D(thread, Field, fields);
   if (!result)
     return value_null();
-  struct native_Field **data = ArrayData(result);
   for (int i = 0, j = 0; i < class->fields_count; ++i) {
     cp_field *field = class->fields + i;
     if (include_field(field, public_only))
-      data[j++] = field->reflection_field;
+      ReferenceArrayStore(thread, result, j++, (void *)field->reflection_field);
   }
   return (stack_value){.obj = result};
 }
@@ -254,12 +250,11 @@ DECLARE_NATIVE("java/lang", Class, getDeclaredConstructors0, "(Z)[Ljava/lang/ref
   // Then create the array
   classdesc *Ctor = bootstrap_lookup_class(thread, STR("java/lang/reflect/Constructor"));
   obj_header *result = CreateObjectArray1D(thread, Ctor, ctors);
-  struct native_Constructor **data = ArrayData(result);
   int j = 0;
   for (int i = 0; i < class->methods_count; ++i) {
     cp_method *method = class->methods + i;
     if (include_ctor(method, public_only)) {
-      data[j++] = method->reflection_ctor;
+      ReferenceArrayStore(thread, result, j++, (void *)method->reflection_ctor);
     }
   }
   return (stack_value){.obj = result};
@@ -287,11 +282,10 @@ DECLARE_NATIVE("java/lang", Class, getDeclaredMethods0, "(Z)[Ljava/lang/reflect/
   classdesc *Method = bootstrap_lookup_class(thread, STR("java/lang/reflect/Method"));
   link_class(thread, Method);
   obj_header *result = CreateObjectArray1D(thread, Method, methods);
-  struct native_Method **data = ArrayData(result);
   for (int i = 0, j = 0; i < class->methods_count; ++i) {
     cp_method *method = class->methods + i;
     if (include_method(method, public_only))
-      data[j++] = method->reflection_method;
+      ReferenceArrayStore(thread, result, j++, (void *)method->reflection_method);
   }
   return (stack_value){.obj = result};
 }
@@ -405,7 +399,7 @@ DECLARE_NATIVE("java/lang", Class, getInterfaces0, "()[Ljava/lang/Class;") {
     cp_class_info *info = desc->interfaces[i];
     classdesc *iface = info->classdesc;
     obj_header *mirror = (void *)get_class_mirror(thread, iface);
-    *((obj_header **)ArrayData(array->obj) + i) = mirror;
+    ReferenceArrayStore(thread, array->obj, i, mirror);
   }
 
   stack_value result = (stack_value){.obj = array->obj};
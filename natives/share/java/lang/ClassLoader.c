@@ -38,7 +38,7 @@ DECLARE_NATIVE("java/lang", ClassLoader, findBuiltinLib, "(Ljava/lang/String;)Lj
 
 static int incr = 0;
 
-enum { CREATION_ANONYMOUS = 8 };
+enum { HIDDEN_CLASS = 2, STRONG_LOADER_LINK = 4, CREATION_ANONYMOUS = 8 };
 
 stack_value define_class(vm_thread *thread, handle *loader, handle *parent_class, handle *name, u8 *data_bytes,
                          int offset, int length, handle *pd, bool initialize, int flags, handle *source) {
@@ -59,9 +59,20 @@ stack_value define_class(vm_thread *thread, handle *loader, handle *parent_class
 
   // Now append some random stuff to the name
   classdesc *result = define_bootstrap_class(thread, cf_name, data_bytes, length);
+  free_heap_str(name_str);
+  if (!result)
+    return value_null();
   result->classloader = loader->obj;
 
-  free_heap_str(name_str);
+  // Classes defined by a loader live as long as it does. Hidden classes are unloaded on their own unless strongly
+  // linked to their loader, and strongly linked hidden classes of the bootstrap loader are never unloaded.
+  if (flags & HIDDEN_CLASS) {
+    if (loader->obj || !(flags & STRONG_LOADER_LINK))
+      make_class_unloadable(thread->vm, result, flags & STRONG_LOADER_LINK);
+  } else if (loader->obj) {
+    make_class_unloadable(thread->vm, result, true);
+  }
+
   if (initialize) {
     initialize_class_t pox = {.args = {thread, result}};
     thread->stack.synchronous_depth++;
@@ -69,9 +80,7 @@ stack_value define_class(vm_thread *thread, handle *loader, handle *parent_class
     CHECK(fut.status == FUTURE_READY);
     thread->stack.synchronous_depth--;
   }
-  if (result) {
-    return (stack_value){.obj = (void *)get_class_mirror(thread, result)};
-  }
+  return (stack_value){.obj = (void *)get_class_mirror(thread, result)};
 
 on_oom:
   return value_null();
@@ -14,7 +14,8 @@ DECLARE_NATIVE("java/lang", Object, clone, "()Ljava/lang/Object;") {
   case CD_KIND_ORDINARY_ARRAY: {
     obj_header *new_array = CreateObjectArray1D(thread, obj->obj->descriptor->one_fewer_dim, ArrayLength(obj->obj));
     if (new_array) {
-      memcpy(ArrayData(new_array), ArrayData(obj->obj), ArrayLength(obj->obj) * sizeof(void *));
+      memcpy(ArrayData(new_array), ArrayData(obj->obj), ArrayLength(obj->obj) * sizeof(heap_ref));
+      gc_write_barrier(thread->vm, new_array); // a large array may have been allocated directly in the old space
     }
     return (stack_value){.obj = new_array};
   }
@@ -28,6 +29,7 @@ DECLARE_NATIVE("java/lang", Object, clone, "()Ljava/lang/Object;") {
     obj_header *new_obj = new_object(thread, obj->obj->descriptor);
     if (new_obj) {
       memcpy(new_obj + 1, obj->obj + 1, obj->obj->descriptor->instance_bytes - sizeof(obj_header));
+      gc_write_barrier(thread->vm, new_obj);
     }
     return (stack_value){.obj = new_obj};
   }
@@ -0,0 +1,109 @@
+#include <natives-dsl.h>
+#include <simd.h>
+
+DECLARE_INTRINSIC_NATIVE("java/lang", StringLatin1, equals, "([B[B)Z") {
+  DCHECK(argc == 2);
+  obj_header *value = args[0].handle->obj, *other = args[1].handle->obj;
+  if (!value || !other) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  int length = ArrayLength(value);
+  bool equal = length == ArrayLength(other) && simd_mismatch(ArrayData(value), ArrayData(other), length) < 0;
+  return (stack_value){.i = equal};
+}
+
+// private static int indexOfChar(byte[] value, int ch, int fromIndex, int max)
+DECLARE_INTRINSIC_NATIVE("java/lang", StringLatin1, indexOfChar, "([BIII)I") {
+  DCHECK(argc == 4);
+  obj_header *value = args[0].handle->obj;
+  int from = args[2].i, max = args[3].i;
+  if (from >= max)
+    return (stack_value){.i = -1};
+  if (!value) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  int length = ArrayLength(value);
+  if (from < 0) {
+    raise_array_index_oob_exception(thread, from, length);
+    return value_null();
+  }
+  int end = max < length ? max : length;
+  ptrdiff_t found = -1;
+  if (from < end)
+    found = simd_index_of_byte((const u8 *)ArrayData(value) + from, (u8)args[1].i, end - from);
+  if (found >= 0)
+    return (stack_value){.i = from + (int)found};
+  if (max > length) { // the bytecode would run off the end
+    raise_array_index_oob_exception(thread, from > length ? from : length, length);
+    return value_null();
+  }
+  return (stack_value){.i = -1};
+}
+
+// public static int indexOf(byte[] value, int valueCount, byte[] str, int strCount, int fromIndex). Callers pass
+// in-range counts; out-of-range ones throw up front rather than wherever the bytecode would have run off the end.
+DECLARE_INTRINSIC_NATIVE("java/lang", StringLatin1, indexOf, "([BI[BII)I") {
+  DCHECK(argc == 5);
+  obj_header *value = args[0].handle->obj, *str = args[2].handle->obj;
+  int value_count = args[1].i, str_count = args[3].i, from = args[4].i;
+  if (!value || !str) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  int value_length = ArrayLength(value), str_length = ArrayLength(str);
+  if (str_length == 0) { // str[0] is read first
+    raise_array_index_oob_exception(thread, 0, 0);
+    return value_null();
+  }
+  int max = value_count - str_count;
+  if (from > max || str_count <= 0)
+    return (stack_value){.i = -1};
+  if (from < 0 || value_count > value_length || str_count > str_length) {
+    raise_array_index_oob_exception(thread, from < 0 ? from : value_length, value_length);
+    return value_null();
+  }
+
+  const u8 *haystack = ArrayData(value), *needle = ArrayData(str);
+  for (int i = from; i <= max;) {
+    ptrdiff_t found = simd_index_of_byte(haystack + i, needle[0], max - i + 1);
+    if (found < 0)
+      break;
+    i += (int)found;
+    if (simd_mismatch(haystack + i + 1, needle + 1, str_count - 1) < 0)
+      return (stack_value){.i = i};
+    ++i;
+  }
+  return (stack_value){.i = -1};
+}
+
+DECLARE_INTRINSIC_NATIVE("java/lang", StringLatin1, inflate, "([BI[CII)V") {
+  DCHECK(argc == 5);
+  obj_header *src = args[0].handle->obj, *dst = args[2].handle->obj;
+  int src_off = args[1].i, dst_off = args[3].i, len = args[4].i;
+  if (len <= 0)
+    return value_null();
+  if (!src || !dst) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  int src_length = ArrayLength(src), dst_length = ArrayLength(dst);
+  if (src_off < 0 || dst_off < 0) {
+    raise_array_index_oob_exception(thread, src_off < 0 ? src_off : dst_off, src_off < 0 ? src_length : dst_length);
+    return value_null();
+  }
+  // Like the bytecode, convert as much as fits before throwing
+  int n = len;
+  if (n > src_length - src_off)
+    n = src_length - src_off > 0 ? src_length - src_off : 0;
+  if (n > dst_length - dst_off)
+    n = dst_length - dst_off > 0 ? dst_length - dst_off : 0;
+  simd_inflate_latin1((u16 *)ArrayData(dst) + dst_off, (const u8 *)ArrayData(src) + src_off, n);
+  if (n < len) {
+    bool src_ran_out = src_off + n >= src_length;
+    raise_array_index_oob_exception(thread, src_ran_out ? src_off + n : dst_off + n,
+                                    src_ran_out ? src_length : dst_length);
+  }
+  return value_null();
+}
@@ -1,6 +1,70 @@
 #include <natives-dsl.h>
+#include <simd.h>
 
 DECLARE_NATIVE("java/lang", StringUTF16, isBigEndian, "()Z") {
   DCHECK(argc == 0);
   return (stack_value){.i = 0};
 }
+
+// Narrows the chars up to the first one which isn't Latin-1, returning its index (or len if there is none). Like the
+// bytecode, converts as much as fits before throwing if the arrays are too short.
+static int compress(vm_thread *thread, const u16 *src, int src_length, int src_off, obj_header *dst, int dst_off,
+                    int len) {
+  int dst_length = ArrayLength(dst);
+  if (src_off < 0 || dst_off < 0) {
+    raise_array_index_oob_exception(thread, src_off < 0 ? src_off : dst_off, src_off < 0 ? src_length : dst_length);
+    return 0;
+  }
+  int n = len;
+  if (n > src_length - src_off)
+    n = src_length - src_off > 0 ? src_length - src_off : 0;
+  if (n > dst_length - dst_off)
+    n = dst_length - dst_off > 0 ? dst_length - dst_off : 0;
+  int compressed = (int)simd_compress_utf16((u8 *)ArrayData(dst) + dst_off, src + src_off, n);
+  if (compressed < n || n == len)
+    return compressed;
+  if (src_off + n >= src_length) {
+    raise_array_index_oob_exception(thread, src_off + n, src_length);
+  } else if (src[src_off + n] > 0xFF) {
+    return n;
+  } else {
+    raise_array_index_oob_exception(thread, dst_off + n, dst_length);
+  }
+  return 0;
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/lang", StringUTF16, compress, "([CI[BII)I", 0) {
+  DCHECK(argc == 5);
+  obj_header *src = args[0].handle->obj, *dst = args[2].handle->obj;
+  int len = args[4].i;
+  if (len <= 0)
+    return (stack_value){.i = len};
+  if (!src || !dst) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  return (stack_value){.i = compress(thread, ArrayData(src), ArrayLength(src), args[1].i, dst, args[3].i, len)};
+}
+
+// The source is a UTF16 string's byte[], in native byte order
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/lang", StringUTF16, compress, "([BI[BII)I", 1) {
+  DCHECK(argc == 5);
+  obj_header *src = args[0].handle->obj, *dst = args[2].handle->obj;
+  int src_off = args[1].i, len = args[4].i;
+  if (!src) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  int src_length = ArrayLength(src) >> 1;
+  if (src_off < 0 || len < 0 || src_off > src_length - len) { // checkBoundsOffCount
+    raise_vm_exception_no_msg(thread, STR("java/lang/StringIndexOutOfBoundsException"));
+    return value_null();
+  }
+  if (len == 0)
+    return (stack_value){.i = 0};
+  if (!dst) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  return (stack_value){.i = compress(thread, ArrayData(src), src_length, src_off, dst, args[3].i, len)};
+}
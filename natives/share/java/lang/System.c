@@ -74,7 +74,7 @@ DECLARE_NATIVE("java/lang", System, arraycopy, "(Ljava/lang/Object;ILjava/lang/O
   // Otherwise, we need to perform an instanceof check on each element and raise
   // an ArrayStoreException as appropriate.
   if (src_is_1d_primitive || instanceof(src->descriptor->one_fewer_dim, dest->descriptor->one_fewer_dim)) {
-    size_t element_size = sizeof(void *);
+    size_t element_size = sizeof(heap_ref);
 
     if (src_is_1d_primitive) {
       switch (src->descriptor->primitive_component) {
@@ -99,18 +99,20 @@ DECLARE_NATIVE("java/lang", System, arraycopy, "(Ljava/lang/Object;ILjava/lang/O
 
     memmove((char *)ArrayData(dest) + dest_pos * element_size, (char *)ArrayData(src) + src_pos * element_size,
             length * element_size);
+    if (!src_is_1d_primitive)
+      gc_write_barrier(thread->vm, dest);
 
     return value_null();
   }
 
   for (int i = 0; i < length; ++i) {
     // may-alias case handled above
-    obj_header *src_elem = ((obj_header **)ArrayData(src))[src_pos + i];
+    obj_header *src_elem = ReferenceArrayLoad(src, src_pos + i);
     if (src_elem && !instanceof(src_elem->descriptor, dest->descriptor->one_fewer_dim)) {
       raise_array_store_exception(thread, STR("source and destination are not compatible"));
       return value_null();
     }
-    ((obj_header **)ArrayData(dest))[dest_pos + i] = src_elem;
+    ReferenceArrayStore(thread, dest, dest_pos + i, src_elem);
   }
 
   return value_null();
@@ -51,7 +51,7 @@ DECLARE_NATIVE("java/lang", Thread, currentCarrierThread, "()Ljava/lang/Thread;"
 }
 
 DECLARE_NATIVE("java/lang", Thread, interrupt0, "()V") {
-  StoreFieldBoolean(obj->obj, "interrupted", true);
+  StoreFieldBoolean(thread, obj->obj, "interrupted", true);
 
   [[maybe_unused]] rr_scheduler *scheduler = thread->vm->scheduler;
   // todo: inform scheduler of interrupt, cause thread to potentially awake if yielded
@@ -66,14 +66,17 @@ DECLARE_NATIVE("java/lang", Throwable, fillInStackTrace, "(I)Ljava/lang/Throwabl
     if (!o)
       goto oom;
     E->declaringClassObject = o;
+    gc_write_barrier(thread->vm, e->obj);
     o = MakeJStringFromModifiedUTF8(thread, method->my_class->name, true);
     if (!o)
       goto oom;
     E->declaringClass = o;
+    gc_write_barrier(thread->vm, e->obj);
     o = MakeJStringFromModifiedUTF8(thread, method->name, true);
     if (!o)
       goto oom;
     E->methodName = o;
+    gc_write_barrier(thread->vm, e->obj);
     attribute_source_file *sf = method->my_class->source_file;
     if (sf) {
       o = MakeJStringFromModifiedUTF8(thread, sf->name, true);
@@ -82,8 +85,9 @@ DECLARE_NATIVE("java/lang", Throwable, fillInStackTrace, "(I)Ljava/lang/Throwabl
     }
 
     E->fileName = o;
+    gc_write_barrier(thread->vm, e->obj);
     E->lineNumber = line;
-    *((void **)ArrayData(stack_trace->obj) + j) = e->obj;
+    ReferenceArrayStore(thread, stack_trace->obj, j, e->obj);
 
 #if 0
     fprintf(stderr, "Stack trace element %d: %.*s.%.*s (%s:%d)\n", j, fmt_slice(method->my_class->name), fmt_slice(method->name),
@@ -96,6 +100,7 @@ DECLARE_NATIVE("java/lang", Throwable, fillInStackTrace, "(I)Ljava/lang/Throwabl
 
 cleanup:
   *backtrace_object(obj->obj) = stack_trace->obj;
+  gc_write_barrier(thread->vm, obj->obj);
 oom:
   drop_handle(thread, stack_trace);
   return (stack_value){.obj = obj->obj};
@@ -113,7 +118,7 @@ DECLARE_NATIVE("java/lang", Throwable, getStackTraceElement, "(I)Ljava/lang/Stac
   if (index < 0 || index >= ArrayLength(stack_trace)) {
     return value_null();
   }
-  obj_header *element = *((obj_header **)ArrayData(stack_trace) + index);
+  obj_header *element = ReferenceArrayLoad(stack_trace, index);
   return (stack_value){.obj = element};
 }
 
@@ -126,8 +131,8 @@ DECLARE_NATIVE("java/lang", StackTraceElement, initStackTraceElements,
     depth = array_length;
   }
   for (int i = 0; i < depth; ++i) {
-    obj_header *element = *((obj_header **)ArrayData(stack_trace->obj) + i);
-    ReferenceArrayStore(args[0].handle->obj, i, element);
+    obj_header *element = ReferenceArrayLoad(stack_trace->obj, i);
+    ReferenceArrayStore(thread, args[0].handle->obj, i, element);
   }
   return value_null();
 }
\ No newline at end of file
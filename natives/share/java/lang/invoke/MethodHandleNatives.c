@@ -52,7 +52,7 @@ heap_string unparse_method_type(const struct native_MethodType *mt) {
   slice write = desc;
   write = subslice(write, bprintf(write, "(").len);
   for (int i = 0; i < ArrayLength(mt->ptypes); ++i) {
-    struct native_Class *class = *((struct native_Class **)ArrayData(mt->ptypes) + i);
+    struct native_Class *class = (void *)ReferenceArrayLoad(mt->ptypes, i);
     write = subslice(write, unparse_classdesc_to_field_descriptor(write, class->reflected_class).len);
   }
   write = subslice(write, bprintf(write, ")").len);
@@ -75,8 +75,10 @@ void fill_mn_with_field(vm_thread *thread, handle *mn, cp_field *field) {
   M->vmtarget = field;
   object mirror = (void *)get_class_mirror(thread, field_cd);
   M->type = mirror;
+  gc_write_barrier(thread->vm, mn->obj);
   mirror = (void *)get_class_mirror(thread, search_on);
   M->clazz = mirror;
+  gc_write_barrier(thread->vm, mn->obj);
 }
 
 void fill_mn_with_method(vm_thread *thread, handle *mn, cp_method *method, bool dynamic_dispatch) {
@@ -96,9 +98,11 @@ void fill_mn_with_method(vm_thread *thread, handle *mn, cp_method *method, bool
   if (!method->is_signature_polymorphic) {
     object string = MakeJStringFromModifiedUTF8(thread, method->unparsed_descriptor, true);
     M->type = string;
+    gc_write_barrier(thread->vm, mn->obj);
   }
   object mirror = (void *)get_class_mirror(thread, search_on);
   M->clazz = mirror;
+  gc_write_barrier(thread->vm, mn->obj);
 }
 
 typedef enum { METHOD_RESOLVE_OK, METHOD_RESOLVE_NOT_FOUND, METHOD_RESOLVE_EXCEPTION } method_resolve_result;
@@ -199,8 +203,7 @@ DECLARE_ASYNC_NATIVE("java/lang/invoke", MethodHandleNatives, getMemberVMInfo,
   obj_header *array = CreateObjectArray1D(thread, bootstrap_lookup_class(thread, STR("java/lang/Object")), 2);
   // todo check exception (out of memory error)
 
-  obj_header **data = ArrayData(array);
-  data[0] = vmindex_long->obj;
+  ReferenceArrayStore(thread, array, 0, vmindex_long->obj);
   drop_handle(thread, vmindex_long);
 
   // either mn->type or mn itself depending on the kind
@@ -209,14 +212,14 @@ DECLARE_ASYNC_NATIVE("java/lang/invoke", MethodHandleNatives, getMemberVMInfo,
   case MH_KIND_PUT_STATIC:
   case MH_KIND_GET_FIELD:
   case MH_KIND_PUT_FIELD:
-    data[1] = mn->type;
+    ReferenceArrayStore(thread, array, 1, mn->type);
     break;
   case MH_KIND_INVOKE_STATIC:
   case MH_KIND_INVOKE_SPECIAL:
   case MH_KIND_NEW_INVOKE_SPECIAL:
   case MH_KIND_INVOKE_VIRTUAL:
   case MH_KIND_INVOKE_INTERFACE:
-    data[1] = (void *)mn;
+    ReferenceArrayStore(thread, array, 1, (void *)mn);
     break;
   default:
     UNREACHABLE();
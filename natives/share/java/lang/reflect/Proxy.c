@@ -8,9 +8,6 @@ DECLARE_NATIVE("java/lang/reflect", Proxy, defineClass0,
   obj_header *data = args[2].handle->obj;
   int offset = args[3].i;
   int length = args[4].i;
-  obj_header *loader = args[0].handle->obj;
-
-  (void)loader;
 
   heap_string name_str = AsHeapString(name, on_oom);
   u8 *bytes = ArrayData(data) + offset;
@@ -25,6 +22,14 @@ DECLARE_NATIVE("java/lang/reflect", Proxy, defineClass0,
   classdesc *result = define_bootstrap_class(thread, hslc(name_str), bytes, length);
 
   free_heap_str(name_str);
+  if (!result)
+    return value_null();
+  // Like ClassLoader.defineClass, a class with a loader lives as long as the loader does
+  if (args[0].handle->obj) {
+    // classdesc fields are GC roots, not heap slots, so the store needs no write barrier
+    result->classloader = args[0].handle->obj;
+    make_class_unloadable(thread->vm, result, true);
+  }
 
   initialize_class_t pox = {.args = {thread, result}};
   future_t f = initialize_class(&pox); // TODO convert
@@ -0,0 +1,272 @@
+#include <natives-dsl.h>
+
+// BigInteger stores magnitudes as big-endian arrays of 32-bit digits. These replace the arithmetic kernels HotSpot
+// intrinsifies with the same algorithms, step for step, accumulating digit products in 64 bits. The bytecode callers
+// check their arguments first; out-of-range ones throw up front here rather than partway through.
+
+// Raises the exception the bytecode would hit reading digits [0, len) of the array
+static bool check_digits(vm_thread *thread, obj_header *array, int len) {
+  if (!array) {
+    raise_null_pointer_exception(thread);
+    return true;
+  }
+  if (len < 1 || len > ArrayLength(array)) {
+    raise_array_index_oob_exception(thread, len - 1, ArrayLength(array));
+    return true;
+  }
+  return false;
+}
+
+// The array to store a result of the given length in: z if it is long enough, or else a new one (null if that throws)
+static obj_header *result_array(vm_thread *thread, obj_header *z, int length) {
+  if (z && ArrayLength(z) >= length)
+    return z;
+  return CreatePrimitiveArray1D(thread, TYPE_KIND_INT, length);
+}
+
+static u32 *digits(obj_header *array) { return ArrayData(array); }
+
+// BigInteger.implMulAdd: out[...] += in[0, len) * k, aligned offset digits from the end of out. Returns the carry.
+static u32 mul_add(u32 *out, int out_length, const u32 *in, int offset, int len, u32 k) {
+  u64 carry = 0;
+  offset = out_length - offset - 1;
+  for (int j = len - 1; j >= 0; j--) {
+    u64 product = (u64)in[j] * k + out[offset] + carry;
+    out[offset--] = (u32)product;
+    carry = product >> 32;
+  }
+  return (u32)carry;
+}
+
+// BigInteger.addOne: adds carry to a at the digit mlen + offset from the end, propagating upwards
+static int add_one(u32 *a, int a_length, int offset, int mlen, u32 carry) {
+  offset = a_length - 1 - mlen - offset;
+  u64 t = (u64)a[offset] + carry;
+  a[offset] = (u32)t;
+  if ((t >> 32) == 0)
+    return 0;
+  while (--mlen >= 0) {
+    if (--offset < 0) // carry out of the number
+      return 1;
+    if (++a[offset] != 0)
+      return 0;
+  }
+  return 1;
+}
+
+// BigInteger.subN: a[0, len) -= b[0, len), returning the borrow (0 or -1)
+static int sub_n(u32 *a, const u32 *b, int len) {
+  s64 sum = 0;
+  while (--len >= 0) {
+    sum = (s64)a[len] - b[len] + (sum >> 32);
+    a[len] = (u32)sum;
+  }
+  return (int)(sum >> 32);
+}
+
+// BigInteger.intArrayCmpToLen
+static int compare(const u32 *a, const u32 *b, int len) {
+  for (int i = 0; i < len; i++) {
+    if (a[i] != b[i])
+      return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+// BigInteger.implMultiplyToLen: z[0, xlen + ylen) = x * y
+static void multiply_to_len(u32 *z, const u32 *x, int xlen, const u32 *y, int ylen) {
+  int xstart = xlen - 1, ystart = ylen - 1;
+  u64 carry = 0;
+  for (int j = ystart, k = ystart + 1 + xstart; j >= 0; j--, k--) {
+    u64 product = (u64)y[j] * x[xstart] + carry;
+    z[k] = (u32)product;
+    carry = product >> 32;
+  }
+  z[xstart] = (u32)carry;
+
+  for (int i = xstart - 1; i >= 0; i--) {
+    carry = 0;
+    for (int j = ystart, k = ystart + 1 + i; j >= 0; j--, k--) {
+      u64 product = (u64)y[j] * x[i] + z[k] + carry;
+      z[k] = (u32)product;
+      carry = product >> 32;
+    }
+    z[i] = (u32)carry;
+  }
+}
+
+// BigInteger.implSquareToLen: z[0, 2 * len) = x * x, computing each off-diagonal product once
+static void square_to_len(u32 *z, int z_length, const u32 *x, int len, int zlen) {
+  // Store the squares, shifted right one bit
+  u32 last_product_low_word = 0;
+  for (int j = 0, i = 0; j < len; j++) {
+    u64 product = (u64)x[j] * x[j];
+    z[i++] = last_product_low_word << 31 | (u32)(product >> 33);
+    z[i++] = (u32)(product >> 1);
+    last_product_low_word = (u32)product;
+  }
+
+  // Add in the off-diagonal sums
+  for (int i = len, offset = 1; i > 0; i--, offset += 2) {
+    u32 t = mul_add(z, z_length, x, offset, i - 1, x[i - 1]);
+    add_one(z, z_length, offset - 1, i, t);
+  }
+
+  // Shift back up and set the low bit
+  for (int i = 0; i < zlen - 1; i++)
+    z[i] = z[i] << 1 | z[i + 1] >> 31;
+  z[zlen - 1] = z[zlen - 1] << 1 | (x[len - 1] & 1);
+}
+
+// BigInteger.montReduce: Montgomery-reduces the 2 * mlen digit product n by mod, leaving the result in n[0, mlen)
+static void mont_reduce(u32 *n, int n_length, const u32 *mod, int mlen, u32 inv) {
+  int c = 0, offset = 0;
+  for (int len = mlen; len > 0; len--, offset++) {
+    u32 n_end = n[n_length - 1 - offset];
+    u32 carry = mul_add(n, n_length, mod, offset, mlen, inv * n_end);
+    c += add_one(n, n_length, offset, mlen, carry);
+  }
+  while (c > 0)
+    c += sub_n(n, mod, mlen);
+  while (compare(n, mod, mlen) >= 0)
+    sub_n(n, mod, mlen);
+}
+
+// private static int[] implMultiplyToLen(int[] x, int xlen, int[] y, int ylen, int[] z)
+DECLARE_INTRINSIC_NATIVE("java/math", BigInteger, implMultiplyToLen, "([II[II[I)[I") {
+  DCHECK(argc == 5);
+  int xlen = args[1].i, ylen = args[3].i;
+  if (check_digits(thread, args[0].handle->obj, xlen) || check_digits(thread, args[2].handle->obj, ylen))
+    return value_null();
+  obj_header *z = result_array(thread, args[4].handle->obj, xlen + ylen);
+  if (!z)
+    return value_null();
+  multiply_to_len(digits(z), digits(args[0].handle->obj), xlen, digits(args[2].handle->obj), ylen);
+  return (stack_value){.obj = z};
+}
+
+// private static final int[] implSquareToLen(int[] x, int len, int[] z, int zlen)
+DECLARE_INTRINSIC_NATIVE("java/math", BigInteger, implSquareToLen, "([II[II)[I") {
+  DCHECK(argc == 4);
+  obj_header *x = args[0].handle->obj, *z = args[2].handle->obj;
+  int len = args[1].i, zlen = args[3].i;
+  if (check_digits(thread, x, len) || check_digits(thread, z, zlen))
+    return value_null();
+  if (2 * (s64)len > ArrayLength(z)) {
+    raise_array_index_oob_exception(thread, ArrayLength(z), ArrayLength(z));
+    return value_null();
+  }
+  square_to_len(digits(z), ArrayLength(z), digits(x), len, zlen);
+  return (stack_value){.obj = z};
+}
+
+// private static int implMulAdd(int[] out, int[] in, int offset, int len, int k)
+DECLARE_INTRINSIC_NATIVE("java/math", BigInteger, implMulAdd, "([I[IIII)I") {
+  DCHECK(argc == 5);
+  obj_header *out = args[0].handle->obj, *in = args[1].handle->obj;
+  int offset = args[2].i, len = args[3].i;
+  if (!out) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  if (len <= 0)
+    return (stack_value){.i = 0};
+  if (check_digits(thread, in, len))
+    return value_null();
+  int out_length = ArrayLength(out);
+  s64 last = (s64)out_length - offset - 1, first = last - len + 1;
+  if (first < 0 || last >= out_length) {
+    raise_array_index_oob_exception(thread, (int)(first < 0 ? first : last), out_length);
+    return value_null();
+  }
+  return (stack_value){.i = (s32)mul_add(digits(out), out_length, digits(in), offset, len, args[4].i)};
+}
+
+// private static int[] implMontgomeryMultiply(int[] a, int[] b, int[] n, int len, long inv, int[] product)
+DECLARE_INTRINSIC_NATIVE("java/math", BigInteger, implMontgomeryMultiply, "([I[I[IIJ[I)[I") {
+  DCHECK(argc == 6);
+  int len = args[3].i;
+  if (check_digits(thread, args[0].handle->obj, len) || check_digits(thread, args[1].handle->obj, len) ||
+      check_digits(thread, args[2].handle->obj, len))
+    return value_null();
+  obj_header *product = result_array(thread, args[5].handle->obj, 2 * len);
+  if (!product)
+    return value_null();
+  multiply_to_len(digits(product), digits(args[0].handle->obj), len, digits(args[1].handle->obj), len);
+  mont_reduce(digits(product), ArrayLength(product), digits(args[2].handle->obj), len, (u32)args[4].l);
+  return (stack_value){.obj = product};
+}
+
+// private static int[] implMontgomerySquare(int[] a, int[] n, int len, long inv, int[] product)
+DECLARE_INTRINSIC_NATIVE("java/math", BigInteger, implMontgomerySquare, "([I[IIJ[I)[I") {
+  DCHECK(argc == 5);
+  int len = args[2].i;
+  if (check_digits(thread, args[0].handle->obj, len) || check_digits(thread, args[1].handle->obj, len))
+    return value_null();
+  obj_header *product = result_array(thread, args[4].handle->obj, 2 * len);
+  if (!product)
+    return value_null();
+  square_to_len(digits(product), ArrayLength(product), digits(args[0].handle->obj), len, 2 * len);
+  mont_reduce(digits(product), ArrayLength(product), digits(args[1].handle->obj), len, (u32)args[3].l);
+  return (stack_value){.obj = product};
+}
+
+// Java masks shift distances to five bits; C leaves shifting a u32 by 32 undefined
+#define SHL(x, n) ((u32)(x) << ((n) & 31))
+#define SHR(x, n) ((u32)(x) >> ((n) & 31))
+
+// private static void shiftLeftImplWorker(int[] newArr, int[] oldArr, int newIdx, int shiftCount, int numIter)
+DECLARE_INTRINSIC_NATIVE("java/math", BigInteger, shiftLeftImplWorker, "([I[IIII)V") {
+  DCHECK(argc == 5);
+  obj_header *new_arr = args[0].handle->obj, *old_arr = args[1].handle->obj;
+  int new_idx = args[2].i, shift = args[3].i, num_iter = args[4].i;
+  if (num_iter <= 0)
+    return value_null();
+  // Reads old_arr[0, num_iter] and writes new_arr[new_idx, new_idx + num_iter)
+  if (!new_arr) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  if (check_digits(thread, old_arr, num_iter + 1))
+    return value_null();
+  if (new_idx < 0 || (s64)new_idx + num_iter > ArrayLength(new_arr)) {
+    raise_array_index_oob_exception(thread, new_idx < 0 ? new_idx : ArrayLength(new_arr), ArrayLength(new_arr));
+    return value_null();
+  }
+  u32 *dst = digits(new_arr) + new_idx, *src = digits(old_arr);
+  for (int i = 0; i < num_iter; i++)
+    dst[i] = SHL(src[i], shift) | SHR(src[i + 1], 32 - shift);
+  return value_null();
+}
+
+// private static void shiftRightImplWorker(int[] newArr, int[] oldArr, int newIdx, int shiftCount, int numIter)
+DECLARE_INTRINSIC_NATIVE("java/math", BigInteger, shiftRightImplWorker, "([I[IIII)V") {
+  DCHECK(argc == 5);
+  obj_header *new_arr = args[0].handle->obj, *old_arr = args[1].handle->obj;
+  int new_idx = args[2].i, shift = args[3].i, num_iter = args[4].i;
+  int last = new_idx == 0 ? num_iter - 1 : num_iter;
+  if (last < new_idx)
+    return value_null();
+  // Writes new_arr[new_idx, last] from old_arr[num_iter - count, num_iter], high digits first
+  s64 count = (s64)last - new_idx + 1;
+  if (!new_arr || !old_arr) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  if (new_idx < 0 || last >= ArrayLength(new_arr)) {
+    raise_array_index_oob_exception(thread, new_idx < 0 ? new_idx : last, ArrayLength(new_arr));
+    return value_null();
+  }
+  if (num_iter - count < 0 || num_iter >= ArrayLength(old_arr)) {
+    raise_array_index_oob_exception(thread, num_iter - count < 0 ? (int)(num_iter - count) : num_iter,
+                                    ArrayLength(old_arr));
+    return value_null();
+  }
+  u32 *dst = digits(new_arr), *src = digits(old_arr);
+  for (int i = last, idx = num_iter; i >= new_idx; i--, idx--)
+    dst[i] = SHR(src[idx], shift) | SHL(src[idx - 1], 32 - shift);
+  return value_null();
+}
+
+#undef SHL
+#undef SHR
@@ -0,0 +1,171 @@
+#include <natives-dsl.h>
+#include <simd.h>
+
+// Arrays.equals and Arrays.fill for primitive arrays. (equals for float[] and double[] compares floatToIntBits, which
+// canonicalizes NaNs, so isn't a plain memory comparison and is left to the bytecode.)
+
+static stack_value equals(obj_header *a, obj_header *b, int element_size) {
+  if (a == b)
+    return (stack_value){.i = 1};
+  if (!a || !b || ArrayLength(a) != ArrayLength(b))
+    return (stack_value){.i = 0};
+  return (stack_value){.i = simd_mismatch(ArrayData(a), ArrayData(b), (size_t)ArrayLength(a) * element_size) < 0};
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, equals, "([Z[Z)Z", 0) {
+  DCHECK(argc == 2);
+  return equals(args[0].handle->obj, args[1].handle->obj, 1);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, equals, "([B[B)Z", 1) {
+  DCHECK(argc == 2);
+  return equals(args[0].handle->obj, args[1].handle->obj, 1);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, equals, "([C[C)Z", 2) {
+  DCHECK(argc == 2);
+  return equals(args[0].handle->obj, args[1].handle->obj, 2);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, equals, "([S[S)Z", 3) {
+  DCHECK(argc == 2);
+  return equals(args[0].handle->obj, args[1].handle->obj, 2);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, equals, "([I[I)Z", 4) {
+  DCHECK(argc == 2);
+  return equals(args[0].handle->obj, args[1].handle->obj, 4);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, equals, "([J[J)Z", 5) {
+  DCHECK(argc == 2);
+  return equals(args[0].handle->obj, args[1].handle->obj, 8);
+}
+
+// value holds the element's bits in its low element_size bytes
+static void fill(obj_header *array, int from, int to, u64 value, int element_size) {
+  void *data = (char *)ArrayData(array) + (size_t)from * element_size;
+  size_t count = to - from;
+  switch (element_size) {
+  case 1:
+    memset(data, (u8)value, count);
+    break;
+  case 2:
+    simd_fill_16(data, (u16)value, count);
+    break;
+  case 4:
+    simd_fill_32(data, (u32)value, count);
+    break;
+  default:
+    simd_fill_64(data, value, count);
+    break;
+  }
+}
+
+static stack_value fill_all(vm_thread *thread, obj_header *array, u64 value, int element_size) {
+  if (!array) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  fill(array, 0, ArrayLength(array), value, element_size);
+  return value_null();
+}
+
+// Mirrors Arrays.rangeCheck
+static stack_value fill_range(vm_thread *thread, obj_header *array, int from, int to, u64 value, int element_size) {
+  if (!array) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  INIT_STACK_STRING(message, 64);
+  if (from > to) {
+    message = bprintf(message, "fromIndex(%d) > toIndex(%d)", from, to);
+    raise_vm_exception(thread, STR("java/lang/IllegalArgumentException"), message);
+  } else if (from < 0 || to > ArrayLength(array)) {
+    message = bprintf(message, "Array index out of range: %d", from < 0 ? from : to);
+    raise_vm_exception(thread, STR("java/lang/ArrayIndexOutOfBoundsException"), message);
+  } else {
+    fill(array, from, to, value, element_size);
+  }
+  return value_null();
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([ZZ)V", 0) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u32)args[1].i, 1);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([BB)V", 1) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u32)args[1].i, 1);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([CC)V", 2) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u32)args[1].i, 2);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([SS)V", 3) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u32)args[1].i, 2);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([II)V", 4) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u32)args[1].i, 4);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([JJ)V", 5) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u64)args[1].l, 8);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([FF)V", 6) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u32)args[1].i, 4);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([DD)V", 7) {
+  DCHECK(argc == 2);
+  return fill_all(thread, args[0].handle->obj, (u64)args[1].l, 8);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([ZIIZ)V", 8) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u32)args[3].i, 1);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([BIIB)V", 9) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u32)args[3].i, 1);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([CIIC)V", 10) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u32)args[3].i, 2);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([SIIS)V", 11) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u32)args[3].i, 2);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([IIII)V", 12) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u32)args[3].i, 4);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([JIIJ)V", 13) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u64)args[3].l, 8);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([FIIF)V", 14) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u32)args[3].i, 4);
+}
+
+DECLARE_INTRINSIC_NATIVE_OVERLOADED("java/util", Arrays, fill, "([DIID)V", 15) {
+  DCHECK(argc == 4);
+  return fill_range(thread, args[0].handle->obj, args[1].i, args[2].i, (u64)args[3].l, 8);
+}
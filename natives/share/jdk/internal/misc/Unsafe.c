@@ -1,3 +1,4 @@
+#include "gc.h"
 #include "objects.h"
 #include "roundrobin_scheduler.h"
 
@@ -9,6 +10,37 @@
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, registerNatives, "()V") { return value_null(); }
 
+// Whether references in obj are heap_refs (see compressed_fields). Static field memory, which staticFieldBase hands
+// out as an object, holds plain pointers.
+static bool has_narrow_references(vm *vm, obj_header *obj) {
+  if (!COMPRESSED_REFS || !obj || !in_heap(vm, obj))
+    return false;
+  return obj->descriptor->kind == CD_KIND_ORDINARY_ARRAY || obj->descriptor->compressed_fields;
+}
+
+static obj_header *get_reference(vm *vm, obj_header *obj, s64 offset) {
+  return load_ref_slot((void *)((uintptr_t)obj + offset), has_narrow_references(vm, obj));
+}
+
+static void put_reference(vm *vm, obj_header *obj, s64 offset, obj_header *value) {
+  store_ref_slot((void *)((uintptr_t)obj + offset), has_narrow_references(vm, obj), value);
+  gc_write_barrier(vm, obj);
+}
+
+// Returns the previous value of the reference
+static obj_header *compare_and_exchange_reference(vm *vm, obj_header *obj, s64 offset, obj_header *expected,
+                                                  obj_header *update) {
+  void *slot = (void *)((uintptr_t)obj + offset);
+  obj_header *previous;
+  if (has_narrow_references(vm, obj)) {
+    previous = decode_ref(__sync_val_compare_and_swap((heap_ref *)slot, encode_ref(expected), encode_ref(update)));
+  } else {
+    previous = (obj_header *)__sync_val_compare_and_swap((uintptr_t *)slot, (uintptr_t)expected, (uintptr_t)update);
+  }
+  gc_write_barrier(vm, obj);
+  return previous;
+}
+
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, arrayBaseOffset0, "(Ljava/lang/Class;)I") {
   return (stack_value){.i = kArrayDataOffset};
 }
@@ -73,7 +105,7 @@ DECLARE_NATIVE("jdk/internal/misc", Unsafe, arrayIndexScale0, "(Ljava/lang/Class
   classdesc *desc = unmirror_class(args[0].handle->obj);
   switch (desc->kind) {
   case CD_KIND_ORDINARY_ARRAY:
-    return (stack_value){.i = sizeof(void *)};
+    return (stack_value){.i = sizeof(heap_ref)};
   case CD_KIND_PRIMITIVE_ARRAY:
     return (stack_value){.i = sizeof_type_kind(desc->primitive_component)};
   case CD_KIND_ORDINARY:
@@ -94,13 +126,13 @@ DECLARE_NATIVE("jdk/internal/misc", Unsafe, getLongVolatile, "(Ljava/lang/Object
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, putReferenceVolatile, "(Ljava/lang/Object;JLjava/lang/Object;)V") {
   DCHECK(argc == 3);
-  *(void *volatile *)((uintptr_t)args[0].handle->obj + args[1].l) = args[2].handle->obj;
+  put_reference(thread->vm, args[0].handle->obj, args[1].l, args[2].handle->obj);
   return value_null();
 }
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, putOrderedReference, "(Ljava/lang/Object;JLjava/lang/Object;)V") {
   DCHECK(argc == 3);
-  *(void **)((void *)args[0].handle->obj + args[1].l) = args[2].handle->obj;
+  put_reference(thread->vm, args[0].handle->obj, args[1].l, args[2].handle->obj);
   return value_null();
 }
 
@@ -112,7 +144,7 @@ DECLARE_NATIVE("jdk/internal/misc", Unsafe, putOrderedLong, "(Ljava/lang/Object;
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, putReference, "(Ljava/lang/Object;JLjava/lang/Object;)V") {
   DCHECK(argc == 3);
-  *(void **)((uintptr_t)args[0].handle->obj + args[1].l) = args[2].handle->obj;
+  put_reference(thread->vm, args[0].handle->obj, args[1].l, args[2].handle->obj);
   return value_null();
 }
 
@@ -137,21 +169,17 @@ DECLARE_NATIVE("jdk/internal/misc", Unsafe, compareAndSetLong, "(Ljava/lang/Obje
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, compareAndSetReference,
                "(Ljava/lang/Object;JLjava/lang/Object;Ljava/lang/Object;)Z") {
   DCHECK(argc == 4);
-  obj_header *target = args[0].handle->obj;
-  s64 offset = args[1].l;
-  uintptr_t expected = (uintptr_t)args[2].handle->obj, update = (uintptr_t)args[3].handle->obj;
-  int ret = __sync_bool_compare_and_swap((uintptr_t *)((uintptr_t)target + offset), expected, update);
-  return (stack_value){.l = ret};
+  obj_header *expected = args[2].handle->obj;
+  obj_header *previous =
+      compare_and_exchange_reference(thread->vm, args[0].handle->obj, args[1].l, expected, args[3].handle->obj);
+  return (stack_value){.l = previous == expected};
 }
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, compareAndExchangeReference,
                "(Ljava/lang/Object;JLjava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;") {
   DCHECK(argc == 4);
-  obj_header *target = args[0].handle->obj;
-  s64 offset = args[1].l;
-  uintptr_t expected = (uintptr_t)args[2].handle->obj, update = (uintptr_t)args[3].handle->obj;
-  uintptr_t ret = __sync_val_compare_and_swap((uintptr_t *)((uintptr_t)target + offset), expected, update);
-  return (stack_value){.obj = (void *)ret};
+  return (stack_value){.obj = compare_and_exchange_reference(thread->vm, args[0].handle->obj, args[1].l,
+                                                            args[2].handle->obj, args[3].handle->obj)};
 }
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, addressSize, "()I") { return (stack_value){.i = sizeof(void *)}; }
@@ -296,7 +324,7 @@ DECLARE_NATIVE("jdk/internal/misc", Unsafe, putBoolean, "(Ljava/lang/Object;JZ)V
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, getReference, "(Ljava/lang/Object;J)Ljava/lang/Object;") {
   DCHECK(argc == 2);
-  return (stack_value){.obj = *(void **)((uintptr_t)args[0].handle->obj + args[1].l)};
+  return (stack_value){.obj = get_reference(thread->vm, args[0].handle->obj, args[1].l)};
 }
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, getInt, "(Ljava/lang/Object;J)I") {
@@ -331,7 +359,7 @@ DECLARE_NATIVE_OVERLOADED("jdk/internal/misc", Unsafe, getByte, "(J)B", 1) {
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, getReferenceVolatile, "(Ljava/lang/Object;J)Ljava/lang/Object;") {
   DCHECK(argc == 2);
-  return (stack_value){.obj = *(void **)((uintptr_t)args[0].handle->obj + args[1].l)};
+  return (stack_value){.obj = get_reference(thread->vm, args[0].handle->obj, args[1].l)};
 }
 
 DECLARE_NATIVE("jdk/internal/misc", Unsafe, defineClass,
@@ -345,10 +373,8 @@ DECLARE_NATIVE("jdk/internal/misc", Unsafe, defineClass,
   obj_header *data = args[1].handle->obj;
   int offset = args[2].i;
   int length = args[3].i;
-  obj_header *loader = args[4].handle->obj;
   obj_header *pd = args[5].handle->obj;
 
-  (void)loader;
   (void)pd;
 
   heap_string name_str = AsHeapString(name, on_oom);
@@ -367,6 +393,14 @@ DECLARE_NATIVE("jdk/internal/misc", Unsafe, defineClass,
   classdesc *result = define_bootstrap_class(thread, hslc(name_str), bytes, length);
 
   free_heap_str(name_str);
+  if (!result)
+    return value_null();
+  // Like ClassLoader.defineClass, a class with a loader lives as long as the loader does
+  if (args[4].handle->obj) {
+    // classdesc fields are GC roots, not heap slots, so the store needs no write barrier
+    result->classloader = args[4].handle->obj;
+    make_class_unloadable(thread->vm, result, true);
+  }
 
   initialize_class_t pox = {.args = {thread, result}};
   future_t f = initialize_class(&pox);
@@ -0,0 +1,95 @@
+#include <natives-dsl.h>
+#include <simd.h>
+
+// Basic type constants used by vectorizedHashCode (mirroring ArraysSupport.T_*)
+enum { T_BOOLEAN = 4, T_CHAR = 5, T_BYTE = 8, T_SHORT = 9, T_INT = 10 };
+
+// Compares whole longs, then (for byte and char arrays) one int, and leaves a tail of fewer elements than that to the
+// caller, which it reports as ~tail. Offsets are Unsafe offsets, i.e. absolute addresses if the object is null.
+DECLARE_INTRINSIC_NATIVE("jdk/internal/util", ArraysSupport, vectorizedMismatch,
+                         "(Ljava/lang/Object;JLjava/lang/Object;JII)I") {
+  DCHECK(argc == 6);
+  const u8 *a = (const u8 *)((uintptr_t)args[0].handle->obj + args[1].l);
+  const u8 *b = (const u8 *)((uintptr_t)args[2].handle->obj + args[3].l);
+  int length = args[4].i, log2_scale = args[5].i;
+
+  int log2_values_per_long = 3 - log2_scale;
+  int long_values = (length >> log2_values_per_long) << log2_values_per_long;
+  size_t bytes = (size_t)long_values << log2_scale;
+  int tail = length - long_values;
+  if (log2_scale < 2) {
+    int values_per_int = 1 << (2 - log2_scale);
+    if (tail >= values_per_int) {
+      bytes += 4;
+      tail -= values_per_int;
+    }
+  }
+
+  ptrdiff_t mismatch = simd_mismatch(a, b, bytes);
+  return (stack_value){.i = mismatch >= 0 ? (int)(mismatch >> log2_scale) : ~tail};
+}
+
+static bool is_array_of(obj_header *array, type_kind kind) {
+  return Is1DPrimitiveArray(array) && array->descriptor->primitive_component == kind;
+}
+
+DECLARE_INTRINSIC_NATIVE("jdk/internal/util", ArraysSupport, vectorizedHashCode, "(Ljava/lang/Object;IIII)I") {
+  DCHECK(argc == 5);
+  obj_header *array = args[0].handle->obj;
+  int from = args[1].i, length = args[2].i, result = args[3].i, basic_type = args[4].i;
+
+  type_kind kind;
+  switch (basic_type) {
+  case T_BOOLEAN:
+  case T_BYTE:
+    kind = TYPE_KIND_BYTE;
+    break;
+  case T_CHAR: // char[], or a UTF16 string's byte[]
+    kind = array && is_array_of(array, TYPE_KIND_BYTE) ? TYPE_KIND_BYTE : TYPE_KIND_CHAR;
+    break;
+  case T_SHORT:
+    kind = TYPE_KIND_SHORT;
+    break;
+  case T_INT:
+    kind = TYPE_KIND_INT;
+    break;
+  default: {
+    INIT_STACK_STRING(message, 64);
+    message = bprintf(message, "unrecognized basic type: %d", basic_type);
+    raise_vm_exception(thread, STR("java/lang/IllegalArgumentException"), message);
+    return value_null();
+  }
+  }
+
+  if (array && !is_array_of(array, kind)) {
+    raise_vm_exception_no_msg(thread, STR("java/lang/ClassCastException"));
+    return value_null();
+  }
+  if (length <= 0)
+    return (stack_value){.i = result};
+  if (!array) {
+    raise_null_pointer_exception(thread);
+    return value_null();
+  }
+  int array_length = ArrayLength(array);
+  if (basic_type == T_CHAR && kind == TYPE_KIND_BYTE)
+    array_length >>= 1; // indices are in chars
+  if (from < 0 || from > array_length - length) {
+    raise_array_index_oob_exception(thread, from < 0 ? from : array_length, array_length);
+    return value_null();
+  }
+
+  void *data = ArrayData(array);
+  switch (basic_type) {
+  case T_BOOLEAN: // unsigned bytes (StringLatin1.hashCode)
+    return (stack_value){.i = simd_hash_u8(result, (const u8 *)data + from, length)};
+  case T_CHAR:
+    return (stack_value){.i = simd_hash_u16(result, (const u16 *)data + from, length)};
+  case T_BYTE:
+    return (stack_value){.i = simd_hash_s8(result, (const s8 *)data + from, length)};
+  case T_SHORT:
+    return (stack_value){.i = simd_hash_s16(result, (const s16 *)data + from, length)};
+  default:
+    return (stack_value){.i = simd_hash_s32(result, (const s32 *)data + from, length)};
+  }
+}
@@ -69,7 +69,7 @@ DECLARE_NATIVE("jdk/internal/util", SystemProps_Raw, platformProperties, "()[Lja
 #define SET_PROP(index, value)                                                                                         \
   {                                                                                                                    \
     obj_header *str = MakeJStringFromCString(thread, value, true);                                                     \
-    ReferenceArrayStore(props->obj, index, str);                                                                       \
+    ReferenceArrayStore(thread, props->obj, index, str);                                                               \
   }
 
   SET_PROP(_file_encoding_NDX, "UTF-8");
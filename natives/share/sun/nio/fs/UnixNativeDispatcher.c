@@ -43,7 +43,7 @@ DECLARE_NATIVE("sun/nio/fs", UnixNativeDispatcher, getcwd, "()[B") {
   return (stack_value){.obj = array};
 }
 
-stack_value stat_impl(value *args) {
+stack_value stat_impl(vm_thread *thread, value *args) {
   struct stat st;
 
   if (!args[1].handle)
@@ -56,8 +56,8 @@ stack_value stat_impl(value *args) {
 
   obj_header *attrs = args[1].handle->obj;
 
-#define MapAttrLong(name, value) StoreFieldLong(attrs, (#name), value)
-#define MapAttrInt(name, value) StoreFieldInt(attrs, (#name), value)
+#define MapAttrLong(name, value) StoreFieldLong(thread, attrs, (#name), value)
+#define MapAttrInt(name, value) StoreFieldInt(thread, attrs, (#name), value)
   MapAttrInt(st_mode, st.st_mode);
   MapAttrLong(st_ino, st.st_ino);
   MapAttrLong(st_dev, st.st_dev);
@@ -100,11 +100,11 @@ stack_value stat_impl(value *args) {
 }
 
 DECLARE_NATIVE("sun/nio/fs", UnixNativeDispatcher, stat0, "(JLsun/nio/fs/UnixFileAttributes;)I") {
-  return stat_impl(args);
+  return stat_impl(thread, args);
 }
 
 DECLARE_NATIVE("sun/nio/fs", UnixNativeDispatcher, lstat0, "(JLsun/nio/fs/UnixFileAttributes;)V") {
-  stat_impl(args);
+  stat_impl(thread, args);
   return value_null();
 }
 
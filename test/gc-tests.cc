@@ -0,0 +1,723 @@
+#include "doctest/doctest.h"
+
+#include <string>
+#include <vector>
+
+#include <allocation_profiler.h>
+#include <arrays.h>
+#include <bjvm.h>
+#include <cached_classdescs.h>
+#include <gc.h>
+#include <heap_dump.h>
+#include <linkage.h>
+#include <monitors.h>
+#include <objects.h>
+
+#include "tests-common.h"
+
+using namespace Bjvm::Tests;
+
+static std::string ReadJString(vm_thread *thread, object str) {
+  heap_string read;
+  REQUIRE(!read_string_to_utf8(thread, &read, str));
+  std::string result{read.chars, (size_t)read.len};
+  free_heap_str(read);
+  return result;
+}
+
+TEST_CASE("Generational GC keeps old-to-young references alive") {
+  vm_options options = default_vm_options();
+  options.initial_heap_size = 1 << 24;
+  options.nursery_size = 1 << 18;
+  auto vm = CreateTestVM(options);
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  REQUIRE(vm->nursery_capacity == 1 << 18);
+
+  constexpr int count = 2000;
+  handle *array = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm.get())->string, count));
+  major_gc(vm.get());
+  REQUIRE(!in_nursery(vm.get(), array->obj));
+
+  // The array is old, so the only thing keeping these strings alive across minor GCs is the card table
+  for (int i = 0; i < count; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      MakeJStringFromCString(thread, "garbage which should never be promoted", false);
+    }
+    object str = MakeJStringFromCString(thread, std::to_string(i).c_str(), false);
+    ReferenceArrayStore(thread, array->obj, i, str);
+  }
+
+  for (int i = 0; i < count; ++i) {
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(array->obj, i)) == std::to_string(i));
+  }
+
+  major_gc(vm.get());
+  REQUIRE(vm->nursery_used == 0);
+  for (int i = 0; i < count; ++i) {
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(array->obj, i)) == std::to_string(i));
+  }
+
+  drop_handle(thread, array);
+  free_thread(thread);
+}
+
+TEST_CASE("Generational GC runs programs") {
+  vm_options options = default_vm_options();
+  options.nursery_size = 1 << 20;
+  auto result = run_test_case("test_files/reflection_class/", true, "Main", "", {}, options);
+  auto expected = run_test_case("test_files/reflection_class/", true);
+  REQUIRE(!result.stdout_.empty());
+  REQUIRE(result.stdout_ == expected.stdout_);
+}
+
+TEST_CASE("Major GC slides live objects down") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  constexpr int count = 10000;
+  handle *array = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm.get())->string, count));
+  for (int i = 0; i < count; ++i) {
+    object str = MakeJStringFromCString(thread, std::to_string(i).c_str(), false);
+    if (i % 3 == 0) {
+      ReferenceArrayStore(thread, array->obj, i / 3, str);
+    }
+  }
+
+  major_gc(vm.get());
+  size_t used = vm->heap_used;
+  major_gc(vm.get());
+  REQUIRE(vm->heap_used == used); // nothing more to free
+
+  for (int i = 0; i < count; i += 3) {
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(array->obj, i / 3)) == std::to_string(i));
+  }
+
+  drop_handle(thread, array);
+  major_gc(vm.get());
+  REQUIRE(vm->heap_used < used);
+  free_thread(thread);
+}
+
+// Builds a tangle of strings and arrays, half of it garbage, and returns the root array
+static object MakeGraph(vm_thread *thread, int count) {
+  vm *vm = thread->vm;
+  handle *root = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm)->object, count));
+  for (int i = 0; i < count; ++i) {
+    handle *inner = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm)->object, 3));
+    for (int j = 0; j < 3; ++j) {
+      object str = MakeJStringFromCString(thread, std::to_string(i * 3 + j).c_str(), false);
+      if (j != 1)
+        ReferenceArrayStore(thread, inner->obj, j, str);
+    }
+    // Share some arrays between several parents
+    ReferenceArrayStore(thread, root->obj, i, i % 7 == 6 ? ReferenceArrayLoad(root->obj, i - 3) : inner->obj);
+    drop_handle(thread, inner);
+  }
+  object result = root->obj;
+  drop_handle(thread, root);
+  return result;
+}
+
+static void VerifyGraph(vm_thread *thread, object root, int count) {
+  for (int i = 0; i < count; ++i) {
+    int k = i % 7 == 6 ? i - 3 : i;
+    object inner = ReferenceArrayLoad(root, i);
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(inner, 0)) == std::to_string(k * 3));
+    REQUIRE(ReferenceArrayLoad(inner, 1) == nullptr);
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(inner, 2)) == std::to_string(k * 3 + 2));
+  }
+}
+
+TEST_CASE("Parallel major GC matches the serial collector") {
+  vm_options options = default_vm_options();
+  options.gc_threads = 4;
+  auto vm = CreateTestVM(options);
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  constexpr int count = 20000;
+  size_t live[2];
+  for (int threads : {1, 4}) {
+    vm->gc_threads = threads;
+    major_gc(vm.get());
+    size_t baseline = vm->heap_used;
+
+    handle *root = make_handle(thread, MakeGraph(thread, count));
+    major_gc(vm.get());
+    live[threads == 4] = vm->heap_used - baseline;
+    VerifyGraph(thread, root->obj, count);
+
+    // Collecting again must not move or free anything
+    size_t used = vm->heap_used;
+    major_gc(vm.get());
+    REQUIRE(vm->heap_used == used);
+    VerifyGraph(thread, root->obj, count);
+
+    drop_handle(thread, root);
+  }
+  REQUIRE(live[0] == live[1]);
+  free_thread(thread);
+}
+
+TEST_CASE("Parallel major GC runs programs") {
+  vm_options options = default_vm_options();
+  options.gc_threads = 4;
+  auto result = run_test_case("test_files/reflection_class/", true, "Main", "", {}, options);
+  auto expected = run_test_case("test_files/reflection_class/", true);
+  REQUIRE(!result.stdout_.empty());
+  REQUIRE(result.stdout_ == expected.stdout_);
+}
+
+TEST_CASE("Heap grows on demand and shrinks when the live set drops") {
+  vm_options options = default_vm_options();
+  options.initial_heap_size = 1 << 22;
+  options.max_heap_size = 1 << 26;
+  auto vm = CreateTestVM(options);
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  REQUIRE(vm->heap_capacity == 1 << 22);
+
+  // About 16 MB of live strings
+  constexpr int count = 200000;
+  handle *array = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm.get())->string, count));
+  for (int i = 0; i < count; ++i) {
+    object str = MakeJStringFromCString(thread, std::to_string(i).c_str(), false);
+    REQUIRE(str);
+    ReferenceArrayStore(thread, array->obj, i, str);
+  }
+  size_t grown = vm->heap_capacity;
+  REQUIRE(grown > 1 << 22);
+  REQUIRE(grown <= 1 << 26);
+  for (int i = 0; i < count; i += 1000) {
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(array->obj, i)) == std::to_string(i));
+  }
+
+  drop_handle(thread, array);
+  for (int i = 0; i < 8; ++i) {
+    major_gc(vm.get());
+  }
+  REQUIRE(vm->heap_capacity < grown);
+  free_thread(thread);
+}
+
+TEST_CASE("Threads allocate from their own TLABs") {
+  auto vm = CreateTestVM();
+  vm_thread *a = create_main_thread(vm.get(), default_thread_options());
+  vm_thread *b = create_main_thread(vm.get(), default_thread_options());
+  classdesc *object_class = cached_classes(vm.get())->object;
+  major_gc(vm.get()); // start from fresh buffers
+
+  object first = AllocateObject(a, object_class, object_class->instance_bytes);
+  object other = AllocateObject(b, object_class, object_class->instance_bytes);
+  object second = AllocateObject(a, object_class, object_class->instance_bytes);
+  REQUIRE((u8 *)second == (u8 *)first + align_up(object_class->instance_bytes, 8));
+  REQUIRE((u8 *)other >= a->tlab_end); // b's buffer was carved out after a's
+  REQUIRE(b->tlab_top == (u8 *)other + align_up(object_class->instance_bytes, 8));
+
+  major_gc(vm.get());
+  REQUIRE(a->tlab_top == nullptr);
+  REQUIRE(b->tlab_top == nullptr);
+
+  free_thread(b);
+  free_thread(a);
+}
+
+TEST_CASE("Major GC leaves free memory zeroed") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  handle *keep = make_handle(thread, MakeJStringFromCString(thread, "survivor", false));
+  for (int i = 0; i < 1000; ++i) {
+    MakeJStringFromCString(thread, "garbage which should be scrubbed", false);
+  }
+  major_gc(vm.get());
+  REQUIRE(heap_is_zeroed(vm->heap + vm->heap_used, vm->true_heap_capacity - vm->heap_used));
+
+  // Fresh arrays come out of that memory without being cleared again
+  object array = CreatePrimitiveArray1D(thread, TYPE_KIND_LONG, 1000);
+  REQUIRE(heap_is_zeroed(ArrayData(array), 1000 * sizeof(s64)));
+  REQUIRE(ReadJString(thread, keep->obj) == "survivor");
+
+  drop_handle(thread, keep);
+  free_thread(thread);
+}
+
+TEST_CASE("Incremental marking keeps objects stored while it runs") {
+  vm_options options = default_vm_options();
+  options.initial_heap_size = options.max_heap_size = 1 << 22;
+  options.nursery_size = 1 << 16;
+  options.gc_pause_budget_us = 1;
+  auto vm = CreateTestVM(options);
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  constexpr int count = 4000;
+  handle *array = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm.get())->string, count));
+  int cycles = 0;
+  for (int i = 0; i < 50 * count; ++i) {
+    object str = MakeJStringFromCString(thread, std::to_string(i).c_str(), false);
+    ReferenceArrayStore(thread, array->obj, i % count, str);
+    if (i % 16 == 0 && vm->incremental_mark) {
+      incremental_gc_step(vm.get());
+      cycles += !vm->incremental_mark;
+    }
+  }
+  REQUIRE(cycles > 0);
+  for (int i = 0; i < count; ++i) {
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(array->obj, i)) == std::to_string(49 * count + i));
+  }
+
+  drop_handle(thread, array);
+  free_thread(thread);
+}
+
+TEST_CASE("Incremental marking keeps objects copied by natives while it runs") {
+  vm_options options = default_vm_options();
+  options.initial_heap_size = options.max_heap_size = 1 << 22;
+  options.nursery_size = 1 << 16;
+  options.gc_pause_budget_us = 1;
+  auto vm = CreateTestVM(options);
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  cp_method *clone =
+      method_lookup(cached_classes(vm.get())->object, STR("clone"), STR("()Ljava/lang/Object;"), false, false);
+  REQUIRE(clone);
+
+  // Big enough that each clone is allocated straight into the compacting space, where only its card tells minor GCs
+  // about the young strings copied into it
+  constexpr int count = 8192;
+  handle *source = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm.get())->string, count));
+  handle *copy = nullptr;
+  std::vector<std::string> expected(count);
+  int cycles = 0, clones_while_marking = 0;
+  for (int i = 0; i < 40 * count; ++i) {
+    std::string value = std::to_string(i);
+    object str = MakeJStringFromCString(thread, value.c_str(), false);
+    ReferenceArrayStore(thread, source->obj, i % count, str);
+    if (i >= count && i % 1024 == 1023) {
+      // Check the previous copy survived everything since, then replace it
+      if (copy) {
+        for (int j = 0; j < count; j += 97) {
+          REQUIRE(ReadJString(thread, ReferenceArrayLoad(copy->obj, j)) == expected[j]);
+        }
+        drop_handle(thread, copy);
+      }
+      clones_while_marking += vm->incremental_mark != nullptr;
+      stack_value args[1] = {{.obj = source->obj}};
+      copy = make_handle(thread, call_interpreter_synchronous(thread, clone, args).obj);
+      REQUIRE(copy->obj);
+      REQUIRE(!in_nursery(vm.get(), copy->obj));
+      for (int j = 0; j < count; ++j) {
+        expected[j] = std::to_string(i - (i - j) % count);
+      }
+    }
+    if (i % 16 == 0 && vm->incremental_mark) {
+      incremental_gc_step(vm.get());
+      cycles += !vm->incremental_mark;
+    }
+  }
+  REQUIRE(cycles > 0);
+  REQUIRE(clones_while_marking > 0);
+
+  major_gc(vm.get());
+  for (int j = 0; j < count; ++j) {
+    REQUIRE(ReadJString(thread, ReferenceArrayLoad(copy->obj, j)) == expected[j]);
+  }
+
+  drop_handle(thread, copy);
+  drop_handle(thread, source);
+  free_thread(thread);
+}
+
+static int CountInternedStrings(vm *vm) {
+  int count = 0;
+  for (u32 i = 0; i < vm->interned_strings.capacity; ++i) {
+    object string = vm->interned_strings.entries[i].string;
+    count += string && string != INTERNED_TOMBSTONE;
+  }
+  return count;
+}
+
+TEST_CASE("Interned strings are collected once unreachable") {
+  vm_options options = default_vm_options();
+  options.nursery_size = 1 << 16;
+  auto vm = CreateTestVM(options);
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  major_gc(vm.get()); // empty the nursery
+
+  handle *kept = make_handle(thread, InternJString(thread, MakeJStringFromCString(thread, "kept interned", false)));
+  handle *dropped = make_handle(thread, InternJString(thread, MakeJStringFromCString(thread, "dropped", false)));
+  REQUIRE(InternJString(thread, MakeJStringFromCString(thread, "dropped", false)) == dropped->obj);
+  int interned = CountInternedStrings(vm.get());
+  drop_handle(thread, dropped);
+
+  minor_gc(vm.get());
+  REQUIRE(CountInternedStrings(vm.get()) == interned - 1);
+  REQUIRE(InternJString(thread, MakeJStringFromCString(thread, "kept interned", false)) == kept->obj);
+  object fresh = MakeJStringFromCString(thread, "dropped", false);
+  REQUIRE(InternJString(thread, fresh) == fresh);
+
+  interned = CountInternedStrings(vm.get());
+  major_gc(vm.get());
+  REQUIRE(CountInternedStrings(vm.get()) < interned);
+  REQUIRE(InternJString(thread, MakeJStringFromCString(thread, "kept interned", false)) == kept->obj);
+  REQUIRE(ReadJString(thread, kept->obj) == "kept interned");
+
+  drop_handle(thread, kept);
+  free_thread(thread);
+}
+
+TEST_CASE("Classes are unloaded once their loader and instances are unreachable") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  auto bytes = ReadFile("test_files/constant_value/Main.class").value();
+  classdesc *desc = define_bootstrap_class(thread, STR("Main"), bytes.data(), bytes.size());
+  REQUIRE(desc);
+  REQUIRE(!link_class(thread, desc));
+  handle *loader = make_handle(thread, MakeJStringFromCString(thread, "stand-in loader", false));
+  desc->classloader = loader->obj;
+  make_class_unloadable(vm.get(), desc, true);
+
+  // The loader keeps the class, and then an instance keeps both the class and the loader
+  major_gc(vm.get());
+  REQUIRE(hash_table_lookup(&vm->classes, "Main", 4) == desc);
+  handle *instance = make_handle(thread, new_object(thread, desc));
+  drop_handle(thread, loader);
+  major_gc(vm.get());
+  REQUIRE(hash_table_lookup(&vm->classes, "Main", 4) == desc);
+  REQUIRE(ReadJString(thread, (object)desc->classloader) == "stand-in loader");
+
+  drop_handle(thread, instance);
+  major_gc(vm.get());
+  REQUIRE(!hash_table_lookup(&vm->classes, "Main", 4));
+  REQUIRE(arrlen(vm->unloadable_classes) == 0);
+
+  free_thread(thread);
+}
+
+TEST_CASE("Unloading a class forgets its devirtualized calls") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  auto bytes = ReadFile("test_files/constant_value/Main.class").value();
+  classdesc *desc = define_bootstrap_class(thread, STR("Main"), bytes.data(), bytes.size());
+  REQUIRE(desc);
+  REQUIRE(!link_class(thread, desc));
+  handle *loader = make_handle(thread, MakeJStringFromCString(thread, "stand-in loader", false));
+  desc->classloader = loader->obj;
+  make_class_unloadable(vm.get(), desc, true);
+
+  // As if a call in Main had been devirtualized to a method of a class which stays loaded
+  classdesc *Object = bootstrap_lookup_class(thread, STR("java/lang/Object"));
+  cp_method *target = method_lookup(Object, STR("toString"), STR("()Ljava/lang/String;"), false, false);
+  REQUIRE(target);
+  cp_method *caller = nullptr;
+  for (int i = 0; !caller && i < desc->methods_count; ++i)
+    if (desc->methods[i].code)
+      caller = desc->methods + i;
+  REQUIRE(caller);
+  bytecode_insn *call = caller->code->code;
+  call->kind = insn_invokevirtual_direct;
+  call->ic = target;
+  arrput(target->devirtualized_calls, call);
+  ptrdiff_t calls = arrlen(target->devirtualized_calls);
+
+  drop_handle(thread, loader);
+  major_gc(vm.get());
+  REQUIRE(!hash_table_lookup(&vm->classes, "Main", 4));
+  // Otherwise loading a class overriding toString would write to the freed code
+  REQUIRE(arrlen(target->devirtualized_calls) == calls - 1);
+  for (int i = 0; i < arrlen(target->devirtualized_calls); ++i)
+    CHECK(target->devirtualized_calls[i] != call);
+
+  free_thread(thread);
+}
+
+TEST_CASE("Unloading a class fixes the inline caches of a live class it shadowed") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  auto bytes = ReadFile("test_files/constant_value/Main.class").value();
+
+  // Two loaders each define Main. The second definition replaces the first in vm->classes, but only it dies.
+  classdesc *defined[2];
+  handle *loaders[2];
+  for (int i = 0; i < 2; ++i) {
+    defined[i] = define_bootstrap_class(thread, STR("Main"), bytes.data(), bytes.size());
+    REQUIRE(defined[i]);
+    REQUIRE(!link_class(thread, defined[i]));
+    loaders[i] = make_handle(thread, MakeJStringFromCString(thread, "stand-in loader", false));
+    defined[i]->classloader = loaders[i]->obj;
+    make_class_unloadable(vm.get(), defined[i], true);
+  }
+  classdesc *live = defined[0], *dying = defined[1];
+  REQUIRE(hash_table_lookup(&vm->classes, "Main", 4) == dying);
+
+  // As if calls in the live Main had run on instances of the dying one
+  cp_method *caller = nullptr;
+  for (int i = 0; !caller && i < live->methods_count; ++i)
+    if (live->methods[i].code && live->methods[i].code->insn_count >= 2)
+      caller = live->methods + i;
+  REQUIRE(caller);
+  bytecode_insn *monomorphic = caller->code->code, *pic_call = caller->code->code + 1;
+  monomorphic->kind = insn_invokevtable_monomorphic;
+  monomorphic->ic = dying->methods;
+  monomorphic->ic2 = dying;
+  auto *pic = (polymorphic_ic *)arena_alloc(&live->arena, 1, sizeof(polymorphic_ic));
+  *pic = {.receivers = {dying, live}, .methods = {dying->methods, live->methods}, .count = 2};
+  pic_call->kind = insn_invokevtable_pic;
+  pic_call->ic = pic;
+  note_cached_class(vm.get(), live, dying);
+
+  drop_handle(thread, loaders[1]);
+  major_gc(vm.get());
+  REQUIRE(arrlen(vm->unloadable_classes) == 1);
+  REQUIRE(vm->unloadable_classes[0] == live);
+  // Otherwise the next call would compare against, or call into, the freed class
+  CHECK(monomorphic->kind == insn_invokevtable_polymorphic);
+  REQUIRE(pic->count == 1);
+  CHECK(pic->receivers[0] == live);
+  CHECK(pic->methods[0] == live->methods);
+
+  drop_handle(thread, loaders[0]);
+  free_thread(thread);
+}
+
+TEST_CASE("Heap dumps contain the reachable objects") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  handle *keep = make_handle(thread, MakeJStringFromCString(thread, "kept needle", false));
+  MakeJStringFromCString(thread, "dropped needle", false);
+
+  size_t length;
+  u8 *dump = heap_dump(vm.get(), &length);
+  REQUIRE(dump);
+  std::string contents{(char *)dump, length};
+  free(dump);
+  REQUIRE(contents.starts_with(std::string{"JAVA PROFILE 1.0.2\0", 19}));
+  REQUIRE(contents.find("java/lang/String") != std::string::npos);
+  REQUIRE(contents.find("kept needle") != std::string::npos);
+  REQUIRE(contents.find("dropped needle") == std::string::npos);
+
+  drop_handle(thread, keep);
+  free_thread(thread);
+}
+
+TEST_CASE("Allocation profiler samples allocations by class and stack") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  allocation_profiler *profiler = start_allocation_profiler(vm.get(), 1024);
+  REQUIRE(profiler);
+  REQUIRE(!start_allocation_profiler(vm.get(), 1024));
+
+  for (int i = 0; i < 4000; ++i) {
+    MakeJStringFromCString(thread, "sampled", false);
+    AllocateObject(thread, cached_classes(vm.get())->object, sizeof(obj_header));
+  }
+  CreatePrimitiveArray1D(thread, TYPE_KIND_INT, 1 << 16); // bigger than the sampling interval
+
+  char *report = finish_allocation_profiler(profiler);
+  REQUIRE(report);
+  std::string contents{report};
+  free(report);
+  REQUIRE(!vm->allocation_profiler);
+  REQUIRE(thread->tlab_end == thread->tlab_limit);
+
+  // No frames were on the stack, so each line is just the class and the estimated bytes
+  REQUIRE(contents.find("java/lang/String ") != std::string::npos);
+  REQUIRE(contents.find("java/lang/Object ") != std::string::npos);
+  REQUIRE(contents.find("byte[] ") != std::string::npos);
+  size_t ints = contents.find("int[] ");
+  REQUIRE(ints != std::string::npos);
+  REQUIRE(std::stoull(contents.substr(ints + 6)) >= 2 << 16); // 1 << 18 bytes, give or take
+
+  free_thread(thread);
+}
+
+TEST_CASE("Compressed references survive collection") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  classdesc *list = bootstrap_lookup_class(thread, STR("java/util/ArrayList"));
+  REQUIRE(list);
+  REQUIRE(!link_class(thread, list));
+  // Classes whose layout natives depend on keep pointer-sized fields
+  REQUIRE(list->compressed_fields == COMPRESSED_REFS);
+  REQUIRE(!cached_classes(vm.get())->string->compressed_fields);
+
+  MakeGraph(thread, 1000); // garbage, so that everything below moves
+  handle *elements = make_handle(thread, CreateObjectArray1D(thread, cached_classes(vm.get())->object, 2));
+  REQUIRE(size_of_object(elements->obj) == kArrayDataOffset + 2 * sizeof(heap_ref));
+  ReferenceArrayStore(thread, elements->obj, 1, MakeJStringFromCString(thread, "element", false));
+  handle *instance = make_handle(thread, new_object(thread, list));
+  cp_field *field = field_lookup(list, STR("elementData"), STR("[Ljava/lang/Object;"));
+  REQUIRE(field);
+  set_field(thread, instance->obj, field, (stack_value){.obj = elements->obj});
+  drop_handle(thread, elements);
+
+  major_gc(vm.get());
+  object data = get_field(instance->obj, field).obj;
+  REQUIRE(data);
+  REQUIRE(ReferenceArrayLoad(data, 0) == nullptr);
+  REQUIRE(ReadJString(thread, ReferenceArrayLoad(data, 1)) == "element");
+
+  drop_handle(thread, instance);
+  free_thread(thread);
+}
+
+static monitor_data *Inflate(vm_thread *thread, object obj, s32 tid, u32 hold_count) {
+  monitor_data *monitor = allocate_monitor_for(thread, obj);
+  REQUIRE(monitor);
+  monitor->mark_word = obj->header_word.mark_word;
+  monitor->tid = tid;
+  monitor->hold_count = hold_count;
+  obj->header_word.expanded_data = monitor;
+  return monitor;
+}
+
+TEST_CASE("Major GC deflates idle monitors and keeps held ones") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  handle *idle = make_handle(thread, MakeJStringFromCString(thread, "idle", false));
+  handle *held = make_handle(thread, MakeJStringFromCString(thread, "held", false));
+  s32 idle_hash = get_object_hash_code(vm.get(), idle->obj);
+  Inflate(thread, idle->obj, -1, 0);
+  monitor_data *held_monitor = Inflate(thread, held->obj, thread->tid, 1);
+  Inflate(thread, MakeJStringFromCString(thread, "garbage", false), thread->tid, 1);
+
+  major_gc(vm.get());
+  REQUIRE(!has_expanded_data(&idle->obj->header_word));
+  REQUIRE(get_object_hash_code(vm.get(), idle->obj) == idle_hash);
+  REQUIRE(inspect_monitor(&held->obj->header_word) == held_monitor);
+  REQUIRE(current_thread_hold_count(thread, held->obj) == 1);
+
+  drop_handle(thread, idle);
+  drop_handle(thread, held);
+  free_thread(thread);
+}
+
+static bool Acquire(vm_thread *thread, object obj) {
+  monitor_acquire_t ctx{};
+  ctx.args.thread = thread;
+  ctx.args.obj = obj;
+  return monitor_acquire(&ctx).status == FUTURE_READY;
+}
+
+TEST_CASE("Thin locks survive collection and inflate on contention") {
+  auto vm = CreateTestVM();
+  vm_thread *a = create_main_thread(vm.get(), default_thread_options());
+  vm_thread *b = create_main_thread(vm.get(), default_thread_options());
+  handle *lock = make_handle(a, MakeJStringFromCString(a, "lock", false));
+  s32 hash = get_object_hash_code(vm.get(), lock->obj);
+
+  REQUIRE(Acquire(a, lock->obj));
+  REQUIRE(Acquire(a, lock->obj));
+  REQUIRE(!has_expanded_data(&lock->obj->header_word));
+  REQUIRE(monitor_release(b, lock->obj) == -1);
+
+  major_gc(vm.get());
+  REQUIRE(current_thread_hold_count(a, lock->obj) == 2);
+  REQUIRE(get_object_hash_code(vm.get(), lock->obj) == hash);
+
+  REQUIRE(!Acquire(b, lock->obj)); // b has to wait, so the lock is inflated with a's holds
+  REQUIRE(has_expanded_data(&lock->obj->header_word));
+  REQUIRE(current_thread_hold_count(a, lock->obj) == 2);
+  REQUIRE(monitor_release(a, lock->obj) == 0);
+  REQUIRE(monitor_release(a, lock->obj) == 0);
+  REQUIRE(Acquire(b, lock->obj));
+  REQUIRE(monitor_release(b, lock->obj) == 0);
+  REQUIRE(get_object_hash_code(vm.get(), lock->obj) == hash);
+
+  drop_handle(a, lock);
+  free_thread(b);
+  free_thread(a);
+}
+
+TEST_CASE("Locks elided while single-threaded are applied when a second thread starts") {
+  auto vm = CreateTestVM();
+  vm_thread *a = create_main_thread(vm.get(), default_thread_options());
+  handle *lock = make_handle(a, MakeJStringFromCString(a, "lock", false));
+  header_word unlocked = lock->obj->header_word;
+
+  REQUIRE(vm->eliding_locks);
+  REQUIRE(Acquire(a, lock->obj));
+  REQUIRE(Acquire(a, lock->obj));
+  REQUIRE(memcmp(&lock->obj->header_word, &unlocked, sizeof(unlocked)) == 0);
+  REQUIRE(current_thread_hold_count(a, lock->obj) == 2);
+
+  major_gc(vm.get());
+  REQUIRE(current_thread_hold_count(a, lock->obj) == 2);
+
+  vm_thread *b = create_main_thread(vm.get(), default_thread_options());
+  REQUIRE(!vm->eliding_locks);
+  REQUIRE(current_thread_hold_count(a, lock->obj) == 2);
+  REQUIRE(current_thread_hold_count(b, lock->obj) == 0);
+  REQUIRE(!Acquire(b, lock->obj));
+  REQUIRE(monitor_release(a, lock->obj) == 0);
+  REQUIRE(monitor_release(a, lock->obj) == 0);
+  REQUIRE(monitor_release(a, lock->obj) == -1);
+
+  drop_handle(a, lock);
+  free_thread(b);
+  free_thread(a);
+}
+
+TEST_CASE("Releasing an elided lock out of order keeps the others in locking order") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  handle *locks[4];
+  for (int i = 0; i < 4; ++i) {
+    locks[i] = make_handle(thread, MakeJStringFromCString(thread, "lock", false));
+    REQUIRE(Acquire(thread, locks[i]->obj));
+  }
+
+  REQUIRE(monitor_release(thread, locks[1]->obj) == 0);
+  REQUIRE(arrlen(vm->elided_locks) == 3);
+  CHECK(vm->elided_locks[0].obj == locks[0]->obj);
+  CHECK(vm->elided_locks[1].obj == locks[2]->obj);
+  CHECK(vm->elided_locks[2].obj == locks[3]->obj);
+
+  for (int i : {3, 2, 0})
+    REQUIRE(monitor_release(thread, locks[i]->obj) == 0);
+  CHECK(arrlen(vm->elided_locks) == 0);
+  for (handle *lock : locks)
+    drop_handle(thread, lock);
+  free_thread(thread);
+}
+
+static object MakeReference(vm_thread *thread, const char *class_name, object referent) {
+  classdesc *desc = bootstrap_lookup_class(thread, {.chars = (char *)class_name, .len = (u16)strlen(class_name)});
+  REQUIRE(desc);
+  REQUIRE(!link_class(thread, desc));
+  handle *keep = make_handle(thread, referent);
+  object ref = AllocateObject(thread, desc, desc->instance_bytes);
+  ((struct native_Reference *)ref)->referent = keep->obj;
+  drop_handle(thread, keep);
+  return ref;
+}
+
+TEST_CASE("Major GC clears weak references and keeps soft ones until memory is tight") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  handle *strong = make_handle(thread, MakeJStringFromCString(thread, "strong", false));
+  handle *weak_to_strong = make_handle(thread, MakeReference(thread, "java/lang/ref/WeakReference", strong->obj));
+  handle *weak = make_handle(
+      thread, MakeReference(thread, "java/lang/ref/WeakReference", MakeJStringFromCString(thread, "weak", false)));
+  handle *soft = make_handle(
+      thread, MakeReference(thread, "java/lang/ref/SoftReference", MakeJStringFromCString(thread, "soft", false)));
+  auto referent = [](handle *ref) { return ((struct native_Reference *)ref->obj)->referent; };
+
+  major_gc(vm.get());
+  REQUIRE(referent(weak) == nullptr);
+  REQUIRE(vm->reference_pending_list == weak->obj);
+  REQUIRE(referent(weak_to_strong) == strong->obj);
+  REQUIRE(ReadJString(thread, referent(soft)) == "soft");
+
+  // Soft references go in the last-ditch collection before giving up on an allocation
+  vm->reference_pending_list = nullptr;
+  major_gc_for_allocation(vm.get(), 0, true);
+  REQUIRE(referent(soft) == nullptr);
+  REQUIRE(vm->reference_pending_list == soft->obj);
+  REQUIRE(ReadJString(thread, referent(weak_to_strong)) == "strong");
+
+  vm->reference_pending_list = nullptr;
+  drop_handle(thread, soft);
+  drop_handle(thread, weak);
+  drop_handle(thread, weak_to_strong);
+  drop_handle(thread, strong);
+  free_thread(thread);
+}
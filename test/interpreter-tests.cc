@@ -0,0 +1,1174 @@
+// Tests of the instructions which the analysis and the interpreter rewrite bytecode into (superinstructions, inline
+// caches, trivial invokes, intrinsics). The methods are assembled in memory from decoded instructions, so that each
+// test controls exactly which sequence gets rewritten.
+
+#include "doctest/doctest.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <analysis.h>
+#include <arrays.h>
+#include <bjvm.h>
+#include <gc.h>
+#include <linkage.h>
+#include <objects.h>
+#include <vtable.h>
+
+#include "tests-common.h"
+
+using namespace Bjvm::Tests;
+
+namespace {
+
+field_descriptor kInt = {.base_kind = TYPE_KIND_INT, .repr_kind = TYPE_KIND_INT};
+
+bytecode_insn Insn(insn_code_kind kind, u32 index = 0) {
+  bytecode_insn insn{};
+  insn.kind = kind;
+  insn.index = index;
+  return insn;
+}
+
+bytecode_insn IConst(s64 value) {
+  bytecode_insn insn = Insn(insn_iconst);
+  insn.integer_imm = value;
+  return insn;
+}
+
+cp_entry FieldRef(field_descriptor *type) {
+  cp_entry entry{.kind = CP_KIND_FIELD_REF};
+  entry.field.parsed_descriptor = type;
+  return entry;
+}
+
+bytecode_insn CpInsn(insn_code_kind kind, cp_entry *entry) {
+  bytecode_insn insn = Insn(kind);
+  insn.cp = entry;
+  return insn;
+}
+
+cp_entry MethodRef(cp_method *resolved) {
+  cp_entry entry{.kind = CP_KIND_METHOD_REF};
+  entry.methodref.resolved = resolved;
+  entry.methodref.descriptor = resolved->descriptor;
+  return entry;
+}
+
+bytecode_insn IInc(u16 index, s16 by) {
+  bytecode_insn insn = Insn(insn_iinc);
+  insn.iinc = {.index = index, .const_ = by};
+  return insn;
+}
+
+// The code of a method. Instruction i is at original pc i and on line kFirstLine + i.
+struct SyntheticCode {
+  attribute_code code{};
+  method_descriptor descriptor{};
+  attribute_line_number_table line_numbers{};
+  std::vector<bytecode_insn> insns;
+  std::vector<line_number_table_entry> lines;
+};
+
+constexpr int kFirstLine = 100;
+
+// A class whose methods are built from decoded instructions and analyzed like parsed ones
+struct SyntheticClass {
+  static constexpr int kMaxMethods = 16;
+
+  classdesc cd{};
+  cp_method methods[kMaxMethods]{};
+  std::vector<std::unique_ptr<SyntheticCode>> code;
+  cp_class_info super{};
+  std::vector<cp_class_info> interfaces;
+  std::vector<cp_class_info *> interface_ptrs;
+
+  explicit SyntheticClass(const char *name, int flags = ACCESS_PUBLIC) {
+    cd.kind = CD_KIND_ORDINARY;
+    cd.state = CD_STATE_INITIALIZED;
+    cd.name = str_to_utf8(name);
+    cd.access_flags = (access_flags)flags;
+    cd.methods = methods;
+  }
+
+  SyntheticClass(const SyntheticClass &) = delete;
+
+  ~SyntheticClass() {
+    for (int i = 0; i < cd.methods_count; ++i) {
+      free_code_analysis(methods[i].code_analysis);
+      arrfree(methods[i].devirtualized_calls);
+    }
+    free_function_tables(&cd);
+    arena_uninit(&cd.arena);
+  }
+
+  // Add a method with the given descriptor, e.g. "(I)I", and analyze it as linking would
+  cp_method *Method(const char *name, const char *descriptor, std::vector<bytecode_insn> insns, int max_locals,
+                    int flags = ACCESS_STATIC) {
+    cp_method *method = Declare(name, descriptor, std::move(insns), max_locals, flags);
+    Analyze(method);
+    return method;
+  }
+
+  // Add a method without analyzing it yet, so that a test can first change what linking would have set up
+  cp_method *Declare(const char *name, const char *descriptor, std::vector<bytecode_insn> insns, int max_locals,
+                     int flags = ACCESS_STATIC) {
+    REQUIRE(cd.methods_count < kMaxMethods);
+    cp_method *method = &methods[cd.methods_count];
+    method->my_index = cd.methods_count++;
+    method->name = str_to_utf8(name);
+    method->unparsed_descriptor = str_to_utf8(descriptor);
+    method->access_flags = (access_flags)flags;
+    method->my_class = &cd;
+
+    auto c = std::make_unique<SyntheticCode>();
+    char *error = parse_method_descriptor(method->unparsed_descriptor, &c->descriptor, &cd.arena);
+    REQUIRE(!error);
+    method->descriptor = &c->descriptor;
+    if (!(flags & ACCESS_ABSTRACT)) {
+      c->insns = std::move(insns);
+      for (size_t i = 0; i < c->insns.size(); ++i) {
+        c->insns[i].original_pc = i;
+        c->lines.push_back({.start_pc = (int)i, .line = kFirstLine + (int)i});
+      }
+      c->line_numbers = {.entries = c->lines.data(), .entry_count = (int)c->lines.size()};
+      c->code.insn_count = (int)c->insns.size();
+      c->code.code = c->insns.data();
+      c->code.max_stack = 4;
+      c->code.max_locals = max_locals;
+      c->code.line_number_table = &c->line_numbers;
+      method->code = &c->code;
+      method->missing_smt = true;
+    }
+    code.push_back(std::move(c));
+    return method;
+  }
+
+  void Analyze(cp_method *method) {
+    heap_string error;
+    REQUIRE(analyze_method_code(method, &error) == 0);
+  }
+
+  // Set up the vtable and itables, once all methods have been added and the superclass and interfaces are linked
+  void Link(SyntheticClass *super_class, std::vector<SyntheticClass *> implements = {}) {
+    if (super_class) {
+      super.classdesc = &super_class->cd;
+      cd.super_class = &super;
+    }
+    interfaces.resize(implements.size());
+    for (size_t i = 0; i < implements.size(); ++i) {
+      interfaces[i].classdesc = &implements[i]->cd;
+      interface_ptrs.push_back(&interfaces[i]);
+    }
+    cd.interfaces = interface_ptrs.data();
+    cd.interfaces_count = (int)interface_ptrs.size();
+    set_up_function_tables(&cd);
+  }
+};
+
+// An object of a synthetic class with a few int fields
+struct SyntheticObject {
+  obj_header header;
+  int fields[4];
+
+  explicit SyntheticObject(SyntheticClass &cls) : header{}, fields{} { header.descriptor = &cls.cd; }
+};
+
+constexpr size_t FieldOffset(int i) { return offsetof(SyntheticObject, fields) + i * sizeof(int); }
+
+// Rewrite a call into the given quickened kind, as the interpreter would once the call has run on a receiver of the
+// given class and found the target method
+void QuickenCall(SyntheticClass &caller, bytecode_insn *call, insn_code_kind kind, cp_method *target,
+                 classdesc *receiver) {
+  cp_method *resolved = call->cp->methodref.resolved;
+  call->kind = kind;
+  call->args = method_argc(target);
+  call->returns = target->descriptor->return_type.base_kind != TYPE_KIND_VOID;
+  switch (kind) {
+  case insn_invokestatic_resolved:
+  case insn_invokespecial_resolved:
+  case insn_invokevirtual_direct:
+    call->ic = target;
+    break;
+  case insn_invokevtable_monomorphic:
+  case insn_invokeitable_monomorphic:
+    call->ic = target;
+    call->ic2 = receiver;
+    break;
+  case insn_invokevtable_polymorphic:
+    call->ic2 = (void *)resolved->vtable_index;
+    break;
+  case insn_invokeitable_polymorphic:
+    call->ic = resolved->my_class;
+    call->ic2 = (void *)resolved->itable_index;
+    break;
+  case insn_invokevtable_pic:
+  case insn_invokeitable_pic: {
+    auto *pic = (polymorphic_ic *)arena_alloc(&caller.cd.arena, 1, sizeof(polymorphic_ic));
+    *pic = {.receivers = {receiver}, .methods = {target}, .count = 1};
+    call->ic = pic;
+    call->ic2 = nullptr;
+    break;
+  }
+  default:
+    FAIL("not a quickened invoke: " << insn_code_to_string(kind));
+  }
+}
+
+stack_value Call(vm_thread *thread, cp_method *method, std::vector<stack_value> args = {}) {
+  return call_interpreter_synchronous(thread, method, args.data());
+}
+
+std::string ReadJavaString(vm_thread *thread, obj_header *string) {
+  heap_string str;
+  REQUIRE(read_string_to_utf8(thread, &str, string) == 0);
+  std::string result{str.chars, (size_t)str.len};
+  free_heap_str(str);
+  return result;
+}
+
+// Takes the pending exception, which must be a NullPointerException thrown at the given instruction of the method
+void RequireNullPointerExceptionAt(vm_thread *thread, cp_method *method, int pc) {
+  obj_header *exception = thread->current_exception;
+  REQUIRE(exception);
+  thread->current_exception = nullptr;
+  CHECK(to_string_view(exception->descriptor->name) == "java/lang/NullPointerException");
+
+  obj_header *trace = ((struct native_Throwable *)exception)->backtrace;
+  REQUIRE(trace);
+  REQUIRE(ArrayLength(trace) >= 1);
+  auto *top = *(struct native_StackTraceElement **)ArrayData(trace);
+  CHECK(ReadJavaString(thread, top->declaringClass) == to_string_view(method->my_class->name));
+  CHECK(ReadJavaString(thread, top->methodName) == to_string_view(method->name));
+  CHECK(top->lineNumber == kFirstLine + pc);
+}
+
+} // namespace
+
+TEST_CASE("Superinstructions run fused loops") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  SyntheticClass cls("Fused");
+
+  // int f(int n) { int s = 0; for (int i = 0; i < 1000; i++) { s = s + i; s = s - n; } return s; }
+  cp_method *f = cls.Method("f", "(I)I",
+                            {IConst(0), Insn(insn_istore, 1), IConst(0), Insn(insn_istore, 2),
+                             /* 4 */ Insn(insn_iload, 2), IConst(1000), Insn(insn_if_icmpge, 17),
+                             /* 7 */ Insn(insn_iload, 1), Insn(insn_iload, 2), Insn(insn_iadd), Insn(insn_istore, 1),
+                             /* 11 */ Insn(insn_iload, 1), Insn(insn_iload, 0), Insn(insn_isub), Insn(insn_istore, 1),
+                             /* 15 */ IInc(2, 1), Insn(insn_goto, 4),
+                             /* 17 */ Insn(insn_iload, 1), Insn(insn_ireturn)},
+                            3);
+  bytecode_insn *insns = f->code->code;
+  REQUIRE(insns[4].kind == insn_iload_iconst_if_icmpge);
+  REQUIRE(insns[7].kind == insn_iload_iload_iadd);
+  REQUIRE(insns[11].kind == insn_iload_iload_isub);
+  REQUIRE(insns[15].kind == insn_iinc_goto);
+
+  for (u32 fuel : {3u, thread->fuel}) {
+    // A low fuel makes the loop yield from inside the fused compare and the fused backward jump
+    thread->fuel = fuel;
+    for (int n = -3; n < 3; ++n) {
+      int expected = 0;
+      for (int i = 0; i < 1000; i++)
+        expected = expected + i - n;
+      stack_value result = Call(thread, f, {{.i = n}});
+      REQUIRE(!thread->current_exception);
+      CHECK(result.i == expected);
+    }
+  }
+
+  // A forward goto after an iinc isn't a loop, so it stays unfused:
+  // int g(int n) { n += 5; goto L; L: return n; }
+  cp_method *g = cls.Method("g", "(I)I", {IInc(0, 5), Insn(insn_goto, 2), Insn(insn_iload, 0), Insn(insn_ireturn)}, 1);
+  CHECK(g->code->code[0].kind == insn_iinc);
+  CHECK(Call(thread, g, {{.i = 1}}).i == 6);
+
+  free_thread(thread);
+}
+
+TEST_CASE("Branches into the middle of a fused sequence") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  SyntheticClass cls("Fused");
+
+  // int f(int c, int a, int b, int d) { return (c != 0 ? a : b) + d; }, where the goto lands on the second iload
+  cp_method *f = cls.Method("f", "(IIII)I",
+                            {Insn(insn_iload, 0), Insn(insn_ifeq, 4), Insn(insn_iload, 1), Insn(insn_goto, 5),
+                             /* 4 */ Insn(insn_iload, 2), Insn(insn_iload, 3), Insn(insn_iadd), Insn(insn_ireturn)},
+                            4);
+  REQUIRE(f->code->code[4].kind == insn_iload_iload_iadd);
+  CHECK(Call(thread, f, {{.i = 1}, {.i = 10}, {.i = 20}, {.i = 3}}).i == 13);
+  CHECK(Call(thread, f, {{.i = 0}, {.i = 10}, {.i = 20}, {.i = 3}}).i == 23);
+
+  // int g(int c, int a, int b) { return (c != 0 ? a : b) < 10 ? 1 : 0; }, where the goto lands on the iconst
+  cp_method *g = cls.Method("g", "(III)I",
+                            {Insn(insn_iload, 0), Insn(insn_ifeq, 4), Insn(insn_iload, 1), Insn(insn_goto, 5),
+                             /* 4 */ Insn(insn_iload, 2), IConst(10), Insn(insn_if_icmplt, 9),
+                             /* 7 */ IConst(0), Insn(insn_ireturn),
+                             /* 9 */ IConst(1), Insn(insn_ireturn)},
+                            3);
+  REQUIRE(g->code->code[4].kind == insn_iload_iconst_if_icmplt);
+  CHECK(Call(thread, g, {{.i = 1}, {.i = 5}, {.i = 50}}).i == 1);
+  CHECK(Call(thread, g, {{.i = 1}, {.i = 50}, {.i = 5}}).i == 0);
+  CHECK(Call(thread, g, {{.i = 0}, {.i = 5}, {.i = 50}}).i == 0);
+  CHECK(Call(thread, g, {{.i = 0}, {.i = 50}, {.i = 5}}).i == 1);
+
+  free_thread(thread);
+}
+
+TEST_CASE("Fused aload_getfield throws NullPointerException at the getfield") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  SyntheticClass cls("Fused");
+
+  // int f(Fused o) { return 1 + o.value; }
+  cp_entry value = FieldRef(&kInt);
+  cp_method *f = cls.Method(
+      "f", "(LFused;)I",
+      {IConst(1), Insn(insn_aload, 0), CpInsn(insn_getfield, &value), Insn(insn_iadd), Insn(insn_ireturn)}, 1);
+  bytecode_insn *insns = f->code->code;
+  REQUIRE(insns[1].kind == insn_aload_getfield);
+  // As if the getfield had been resolved
+  insns[2].kind = insn_getfield_I;
+  insns[2].ic2 = (void *)FieldOffset(0);
+
+  SyntheticObject o(cls);
+  o.fields[0] = 41;
+  CHECK(Call(thread, f, {{.obj = &o.header}}).i == 42);
+  CHECK(insns[1].kind == insn_aload_getfield_I); // re-quickened once the getfield was resolved
+
+  Call(thread, f, {{.obj = nullptr}});
+  RequireNullPointerExceptionAt(thread, f, 2);
+
+  // The fused instruction is left as it was, so later calls still take the fast path
+  CHECK(insns[1].kind == insn_aload_getfield_I);
+  CHECK(Call(thread, f, {{.obj = &o.header}}).i == 42);
+
+  free_thread(thread);
+}
+
+// Receiver classes for the inline cache tests: Impl0 .. Impl5 all extend Root and implement Shape, and their m()
+// returns 100 + the index of the class
+struct ShapeHierarchy {
+  static constexpr int kImpls = POLYMORPHIC_IC_WAYS + 2;
+
+  SyntheticClass root{"Root"};
+  SyntheticClass shape{"Shape", ACCESS_PUBLIC | ACCESS_INTERFACE | ACCESS_ABSTRACT};
+  std::vector<std::unique_ptr<SyntheticClass>> impls;
+  std::vector<SyntheticObject> objects;
+
+  ShapeHierarchy() {
+    static const char *names[kImpls] = {"Impl0", "Impl1", "Impl2", "Impl3", "Impl4", "Impl5"};
+    root.Link(nullptr);
+    shape.Method("m", "()I", {}, 0, ACCESS_PUBLIC | ACCESS_ABSTRACT);
+    shape.Link(&root);
+    for (int i = 0; i < kImpls; ++i) {
+      auto impl = std::make_unique<SyntheticClass>(names[i]);
+      impl->Method("m", "()I", {IConst(100 + i), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC);
+      impl->Link(&root, {&shape});
+      objects.emplace_back(*impl);
+      impls.push_back(std::move(impl));
+    }
+  }
+};
+
+TEST_CASE("Polymorphic inline caches hit, miss and go megamorphic") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  ShapeHierarchy h;
+  SyntheticClass cls("Caller");
+
+  for (bool is_interface : {false, true}) {
+    CAPTURE(is_interface);
+    // int f(Shape s) { return s.m(); }, as an invokevirtual of Impl0.m or an invokeinterface of Shape.m
+    cp_entry m = MethodRef(is_interface ? &h.shape.methods[0] : &h.impls[0]->methods[0]);
+    cp_method *f = cls.Method(is_interface ? "viaShape" : "viaImpl0", "(LShape;)I",
+                              {Insn(insn_aload, 0),
+                               CpInsn(is_interface ? insn_invokeinterface : insn_invokevirtual, &m),
+                               Insn(insn_ireturn)},
+                              1);
+    // As if the call had been executed on an Impl0
+    bytecode_insn *call = &f->code->code[1];
+    call->kind = is_interface ? insn_invokeitable_monomorphic : insn_invokevtable_monomorphic;
+    call->ic = &h.impls[0]->methods[0];
+    call->ic2 = &h.impls[0]->cd;
+    call->args = 1;
+    call->returns = true;
+
+    auto call_on = [&](int i) { return Call(thread, f, {{.obj = &h.objects[i].header}}).i; };
+    CHECK(call_on(0) == 100);
+    CHECK(call->kind == (is_interface ? insn_invokeitable_monomorphic : insn_invokevtable_monomorphic));
+
+    // A second receiver class turns the monomorphic cache into a polymorphic one holding both
+    CHECK(call_on(1) == 101);
+    REQUIRE(call->kind == (is_interface ? insn_invokeitable_pic : insn_invokevtable_pic));
+    auto *pic = (polymorphic_ic *)call->ic;
+    CHECK(pic->count == 2);
+    CHECK(pic->misses == 1);
+    for (int i = 0; i < 10; ++i) {
+      CHECK(call_on(0) == 100);
+      CHECK(call_on(1) == 101);
+    }
+    CHECK(pic->hits == 20);
+
+    // Misses fill the remaining ways
+    for (int i = 2; i < POLYMORPHIC_IC_WAYS; ++i)
+      CHECK(call_on(i) == 100 + i);
+    CHECK(pic->count == POLYMORPHIC_IC_WAYS);
+    CHECK(pic->misses == POLYMORPHIC_IC_WAYS - 1);
+    CHECK(call_on(POLYMORPHIC_IC_WAYS - 1) == 100 + POLYMORPHIC_IC_WAYS - 1);
+    CHECK(pic->hits == 21);
+
+    // One more receiver class and the call goes megamorphic, dispatching through the tables from then on
+    CHECK(call_on(POLYMORPHIC_IC_WAYS) == 100 + POLYMORPHIC_IC_WAYS);
+    CHECK(call->kind == (is_interface ? insn_invokeitable_polymorphic : insn_invokevtable_polymorphic));
+    for (int i = 0; i < ShapeHierarchy::kImpls; ++i)
+      CHECK(call_on(i) == 100 + i);
+
+    // The megamorphic call gave its cache back to the class, so a call going polymorphic again reuses it, emptied
+    call->kind = is_interface ? insn_invokeitable_monomorphic : insn_invokevtable_monomorphic;
+    call->ic = &h.impls[0]->methods[0];
+    call->ic2 = &h.impls[0]->cd;
+    CHECK(call_on(1) == 101);
+    REQUIRE(call->kind == (is_interface ? insn_invokeitable_pic : insn_invokevtable_pic));
+    CHECK(call->ic == pic);
+    CHECK(pic->count == 2);
+    CHECK(pic->hits == 0);
+    CHECK(pic->misses == 1);
+    CHECK(cls.cd.unused_pics == nullptr);
+  }
+
+  free_thread(thread);
+}
+
+TEST_CASE("Loading an overriding subclass undoes devirtualized calls") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  SyntheticClass root("Root");
+  root.Link(nullptr);
+  SyntheticClass base("Base");
+  base.Method("m", "()I", {IConst(1), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC);
+  base.Method("fixed", "()I", {IConst(10), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC | ACCESS_FINAL);
+  base.Link(&root);
+  cp_method *m = &base.methods[0], *fixed = &base.methods[1];
+
+  // int f(Base b) { return b.m() + b.fixed(); }
+  SyntheticClass cls("Caller");
+  cp_entry m_ref = MethodRef(m), fixed_ref = MethodRef(fixed);
+  cp_method *f = cls.Method("f", "(LBase;)I",
+                            {Insn(insn_aload, 0), CpInsn(insn_invokevirtual, &m_ref), Insn(insn_aload, 0),
+                             CpInsn(insn_invokevirtual, &fixed_ref), Insn(insn_iadd), Insn(insn_ireturn)},
+                            1);
+  bytecode_insn *call_m = &f->code->code[1], *call_fixed = &f->code->code[3];
+
+  SyntheticObject base_object(base);
+  CHECK(Call(thread, f, {{.obj = &base_object.header}}).i == 11);
+  // Nothing overrides either method, but only the call to the one which could be overridden depends on that
+  REQUIRE(call_m->kind == insn_invokevirtual_direct);
+  REQUIRE(call_fixed->kind == insn_invokevirtual_direct);
+  REQUIRE(arrlen(m->devirtualized_calls) == 1);
+  CHECK(m->devirtualized_calls[0] == call_m);
+  CHECK(arrlen(fixed->devirtualized_calls) == 0);
+
+  SyntheticClass sub("Sub");
+  sub.Method("m", "()I", {IConst(2), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC);
+  sub.Link(&base);
+  CHECK(m->overridden);
+  CHECK(call_m->kind == insn_invokevirtual);
+  CHECK(arrlen(m->devirtualized_calls) == 0);
+  CHECK(call_fixed->kind == insn_invokevirtual_direct);
+
+  // The call is quickened again, now dispatching on the receiver class
+  SyntheticObject sub_object(sub);
+  CHECK(Call(thread, f, {{.obj = &sub_object.header}}).i == 12);
+  CHECK(call_m->kind == insn_invokevtable_monomorphic);
+  CHECK(Call(thread, f, {{.obj = &base_object.header}}).i == 11);
+  CHECK(Call(thread, f, {{.obj = &sub_object.header}}).i == 12);
+
+  free_thread(thread);
+}
+
+TEST_CASE("Interfaces whose itable hashes collide are all found") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  // A class implementing 8 interfaces gets a 16-slot table. Pick interfaces whose search starts at the last slot or the
+  // first, so that all of them are in one cluster which wraps around the end of the table.
+  constexpr int kInterfaces = 8, kPool = 512;
+  itables sixteen_slots{.slots_mask = 15};
+  std::vector<std::unique_ptr<SyntheticClass>> pool;
+  std::vector<SyntheticClass *> implemented, colliding_others;
+  int at_end = 0, at_start = 0;
+  for (int i = 0; i < kPool; ++i) {
+    auto &iface = pool.emplace_back(
+        std::make_unique<SyntheticClass>("Colliding", ACCESS_PUBLIC | ACCESS_INTERFACE | ACCESS_ABSTRACT));
+    u32 slot = itable_home_slot(&sixteen_slots, &iface->cd);
+    if (slot == 15 && at_end < kInterfaces - 2)
+      ++at_end, implemented.push_back(iface.get());
+    else if (slot == 0 && at_start < 2)
+      ++at_start, implemented.push_back(iface.get());
+    else if (slot == 15 || slot == 0)
+      colliding_others.push_back(iface.get());
+  }
+  REQUIRE(implemented.size() == kInterfaces);
+  REQUIRE(!colliding_others.empty());
+
+  // interface I<i> { int m<i>(); } and class Impl implements I0..I7 { public int m<i>() { return 100 + i; } }
+  static const char *names[kInterfaces] = {"m0", "m1", "m2", "m3", "m4", "m5", "m6", "m7"};
+  SyntheticClass root("Root");
+  root.Link(nullptr);
+  SyntheticClass impl("Impl");
+  cp_method *declared[kInterfaces], *impl_methods[kInterfaces];
+  for (int i = 0; i < kInterfaces; ++i) {
+    declared[i] = implemented[i]->Method(names[i], "()I", {}, 0, ACCESS_PUBLIC | ACCESS_ABSTRACT);
+    implemented[i]->Link(&root);
+    impl_methods[i] = impl.Method(names[i], "()I", {IConst(100 + i), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC);
+  }
+  impl.Link(&root, implemented);
+  REQUIRE(impl.cd.itables.slots_mask == 15);
+
+  SyntheticObject obj(impl);
+  SyntheticClass cls("Caller");
+  std::deque<cp_entry> refs;
+  for (int i = 0; i < kInterfaces; ++i) {
+    CAPTURE(i);
+    int index = itable_find(&impl.cd, &implemented[i]->cd);
+    REQUIRE(index >= 0);
+    CHECK(impl.cd.itables.interfaces[index] == &implemented[i]->cd);
+    CHECK(itable_lookup(&impl.cd, &implemented[i]->cd, declared[i]->itable_index) == impl_methods[i]);
+
+    // static int f(I<i> o) { return o.m<i>(); }, gone megamorphic
+    cp_entry *ref = &refs.emplace_back(MethodRef(declared[i]));
+    cp_method *f = cls.Method(names[i], "(LImpl;)I",
+                              {Insn(insn_aload, 0), CpInsn(insn_invokeinterface, ref), Insn(insn_ireturn)}, 1);
+    QuickenCall(cls, &f->code->code[1], insn_invokeitable_polymorphic, impl_methods[i], nullptr);
+    CHECK(Call(thread, f, {{.obj = &obj.header}}).i == 100 + i);
+  }
+
+  // Searching for these goes through the whole cluster before reaching an empty slot
+  for (SyntheticClass *other : colliding_others) {
+    CHECK(itable_find(&impl.cd, &other->cd) == -1);
+    CHECK(!instanceof(&impl.cd, &other->cd));
+  }
+
+  free_thread(thread);
+}
+
+TEST_CASE("Interface calls on an array receiver") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  handle *array = make_handle(thread, CreatePrimitiveArray1D(thread, TYPE_KIND_INT, 3));
+  classdesc *array_class = array->obj->descriptor;
+
+  // Arrays implement Cloneable and Serializable
+  classdesc *Cloneable = bootstrap_lookup_class(thread, STR("java/lang/Cloneable"));
+  classdesc *Serializable = bootstrap_lookup_class(thread, STR("java/io/Serializable"));
+  REQUIRE(Cloneable);
+  REQUIRE(Serializable);
+  CHECK(itable_find(array_class, Cloneable) >= 0);
+  CHECK(itable_find(array_class, Serializable) >= 0);
+  CHECK(instanceof(array_class, Cloneable));
+
+  SyntheticClass cls("Caller");
+
+  // static int f(Cloneable c) { return c.hashCode(); }, which resolves to Object.hashCode
+  cp_method *hash_code = method_lookup(Cloneable, STR("hashCode"), STR("()I"), true, true);
+  REQUIRE(hash_code);
+  REQUIRE(!(hash_code->my_class->access_flags & ACCESS_INTERFACE));
+  cp_entry hash_code_ref = MethodRef(hash_code);
+  cp_method *f = cls.Method("f", "(Ljava/lang/Cloneable;)I",
+                            {Insn(insn_aload, 0), CpInsn(insn_invokeinterface, &hash_code_ref), Insn(insn_ireturn)}, 1);
+  s32 hash = Call(thread, f, {{.obj = array->obj}}).i;
+  REQUIRE(!thread->current_exception);
+  CHECK(f->code->code[1].kind != insn_invokeinterface);
+  CHECK(Call(thread, f, {{.obj = array->obj}}).i == hash);
+
+  // static int g(HasM o) { return o.m(); }, with the call cached for an implementation, then given the array, which
+  // doesn't implement HasM
+  SyntheticClass root("Root");
+  root.Link(nullptr);
+  SyntheticClass has_m("HasM", ACCESS_PUBLIC | ACCESS_INTERFACE | ACCESS_ABSTRACT);
+  cp_method *m = has_m.Method("m", "()I", {}, 0, ACCESS_PUBLIC | ACCESS_ABSTRACT);
+  has_m.Link(&root);
+  SyntheticClass impl("Impl");
+  cp_method *impl_m = impl.Method("m", "()I", {IConst(1), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC);
+  impl.Link(&root, {&has_m});
+
+  classdesc *IncompatibleClassChangeError =
+      bootstrap_lookup_class(thread, STR("java/lang/IncompatibleClassChangeError"));
+  REQUIRE(IncompatibleClassChangeError);
+  cp_entry m_ref = MethodRef(m);
+  cp_method *g = cls.Method("g", "(LHasM;)I",
+                            {Insn(insn_aload, 0), CpInsn(insn_invokeinterface, &m_ref), Insn(insn_ireturn)}, 1);
+  for (insn_code_kind kind : {insn_invokeinterface, insn_invokeitable_monomorphic, insn_invokeitable_pic,
+                              insn_invokeitable_polymorphic}) {
+    CAPTURE(insn_code_to_string(kind));
+    if (kind == insn_invokeinterface)
+      g->code->code[1].kind = kind;
+    else
+      QuickenCall(cls, &g->code->code[1], kind, impl_m, &impl.cd);
+    Call(thread, g, {{.obj = array->obj}});
+    obj_header *exception = thread->current_exception;
+    REQUIRE(exception);
+    thread->current_exception = nullptr;
+    CHECK(instanceof(exception->descriptor, IncompatibleClassChangeError));
+  }
+
+  drop_handle(thread, array);
+  free_thread(thread);
+}
+
+// A class file with the single method
+//   static int s(int key) { switch (key) { case keys[i]: return kCaseResult + i; default: return -1; } }
+// whose lookupswitch lists the keys in the given order, parsed like any other class
+struct LookupswitchClass {
+  static constexpr int kCaseResult = 100;
+  static constexpr u8 kUtf8Tag = 1, kClassTag = 7;
+
+  std::vector<u8> bytes;
+  classdesc cd{};
+  cp_method *method = nullptr;
+
+  explicit LookupswitchClass(const std::vector<s32> &keys) {
+    U4(0xCAFEBABE);
+    U2(0);
+    U2(49); // no StackMapTable needed
+    U2(8);  // constant pool count
+    Utf8("Switch");
+    U1(kClassTag), U2(1);
+    Utf8("java/lang/Object");
+    U1(kClassTag), U2(3);
+    Utf8("s");
+    Utf8("(I)I");
+    Utf8("Code");
+    U2(ACCESS_PUBLIC), U2(2), U2(4), U2(0), U2(0);
+
+    // iload_0, then the lookupswitch at pc 1 padded to pc 4, then the cases, each sipush + ireturn, then the default
+    int cases_pc = 4 + 8 + 8 * (int)keys.size();
+    std::vector<u8> code = {0x1a, 0xab, 0, 0};
+    std::swap(bytes, code);
+    U4(cases_pc + 4 * keys.size() - 1); // default, relative to the lookupswitch
+    U4(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+      U4(keys[i]), U4(cases_pc + 4 * i - 1);
+    for (size_t i = 0; i < keys.size(); ++i)
+      U1(0x11), U2(kCaseResult + i), U1(0xac);
+    U1(0x02), U1(0xac); // iconst_m1, ireturn
+    std::swap(bytes, code);
+
+    U2(1); // methods count
+    U2(ACCESS_PUBLIC | ACCESS_STATIC), U2(5), U2(6), U2(1);
+    U2(7), U4(12 + code.size()), U2(1), U2(1), U4(code.size());
+    bytes.insert(bytes.end(), code.begin(), code.end());
+    U2(0), U2(0); // exception table, attributes
+    U2(0);        // class attributes
+
+    heap_string error;
+    REQUIRE(parse_classfile(bytes.data(), bytes.size(), &cd, &error) == PARSE_SUCCESS);
+    cd.state = CD_STATE_INITIALIZED;
+    method = &cd.methods[0];
+    REQUIRE(analyze_method_code(method, &error) == 0);
+  }
+
+  LookupswitchClass(const LookupswitchClass &) = delete;
+
+  ~LookupswitchClass() { free_classfile(cd); }
+
+  const bytecode_insn &Switch() const { return method->code->code[1]; }
+
+  int Run(vm_thread *thread, s32 key) {
+    stack_value result = Call(thread, method, {{.i = key}});
+    REQUIRE(!thread->current_exception);
+    return result.i;
+  }
+
+private:
+  void U1(u8 value) { bytes.push_back(value); }
+  void U2(u16 value) { U1(value >> 8), U1(value); }
+  void U4(u32 value) { U2(value >> 16), U2(value); }
+  void Utf8(const char *str) {
+    U1(kUtf8Tag), U2(strlen(str));
+    bytes.insert(bytes.end(), str, str + strlen(str));
+  }
+};
+
+TEST_CASE("Unsorted lookupswitch keys are sorted for the binary search") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  std::vector<s32> keys = {1000, -5, 70000, 3, 512};
+  LookupswitchClass cls(keys);
+  REQUIRE(cls.Switch().kind == insn_lookupswitch);
+  const struct lookupswitch_data *data = cls.Switch().lookupswitch;
+  REQUIRE(data->keys_count == 5);
+  CHECK(std::is_sorted(data->keys, data->keys + data->keys_count));
+
+  for (size_t i = 0; i < keys.size(); ++i)
+    CHECK(cls.Run(thread, keys[i]) == LookupswitchClass::kCaseResult + (int)i);
+  for (s32 key : {-6, -4, 0, 4, 999, 70001, INT_MIN, INT_MAX})
+    CHECK(cls.Run(thread, key) == -1);
+
+  free_thread(thread);
+}
+
+TEST_CASE("Lookupswitch keys at INT_MIN and INT_MAX") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  // Far too sparse for a table, however the span is computed
+  std::vector<s32> keys = {INT_MAX, 0, INT_MIN};
+  LookupswitchClass cls(keys);
+  REQUIRE(cls.Switch().kind == insn_lookupswitch);
+  for (size_t i = 0; i < keys.size(); ++i)
+    CHECK(cls.Run(thread, keys[i]) == LookupswitchClass::kCaseResult + (int)i);
+  for (s32 key : {INT_MIN + 1, INT_MAX - 1, -1, 1})
+    CHECK(cls.Run(thread, key) == -1);
+
+  // Dense keys at either end of the range still become a table
+  for (s32 low : {INT_MIN, INT_MAX - 1}) {
+    CAPTURE(low);
+    LookupswitchClass edge({low + 1, low});
+    REQUIRE(edge.Switch().kind == insn_tableswitch);
+    CHECK(edge.Run(thread, low) == LookupswitchClass::kCaseResult + 1);
+    CHECK(edge.Run(thread, low + 1) == LookupswitchClass::kCaseResult);
+    CHECK(edge.Run(thread, low == INT_MIN ? INT_MAX : INT_MIN) == -1);
+    CHECK(edge.Run(thread, 0) == -1);
+  }
+
+  free_thread(thread);
+}
+
+TEST_CASE("A dense lookupswitch becomes a tableswitch whose gaps go to the default") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  std::vector<s32> keys = {5, 1, 3, 2};
+  LookupswitchClass cls(keys);
+  REQUIRE(cls.Switch().kind == insn_tableswitch);
+  const struct tableswitch_data *table = cls.Switch().tableswitch;
+  CHECK(table->low == 1);
+  CHECK(table->high == 5);
+  CHECK(table->targets[4 - 1] == table->default_target);
+
+  for (size_t i = 0; i < keys.size(); ++i)
+    CHECK(cls.Run(thread, keys[i]) == LookupswitchClass::kCaseResult + (int)i);
+  for (s32 key : {4, 0, 6, -1, INT_MIN, INT_MAX})
+    CHECK(cls.Run(thread, key) == -1);
+
+  // Duplicate keys keep it a lookupswitch, so that every case stays reachable, and the first one listed wins
+  LookupswitchClass dups({3, 2, 1, 3, 2, 3});
+  REQUIRE(dups.Switch().kind == insn_lookupswitch);
+  CHECK(dups.Run(thread, 1) == LookupswitchClass::kCaseResult + 2);
+  CHECK(dups.Run(thread, 2) == LookupswitchClass::kCaseResult + 1);
+  CHECK(dups.Run(thread, 3) == LookupswitchClass::kCaseResult);
+
+  free_thread(thread);
+}
+
+// Point has an int field x, and implements HasX, whose methods are all trivial:
+//   int getX() { return x; }   void setX(int x) { this.x = x; }   int seven() { return 7; }   void nothing() {}
+// plus static int answer() { return 42; }
+struct TrivialMethods {
+  SyntheticClass root{"Root"};
+  SyntheticClass has_x{"HasX", ACCESS_PUBLIC | ACCESS_INTERFACE | ACCESS_ABSTRACT};
+  SyntheticClass point{"Point"};
+  cp_entry x = FieldRef(&kInt);
+  cp_method *get_x, *set_x, *seven, *nothing, *answer;
+
+  TrivialMethods() {
+    root.Link(nullptr);
+    for (auto [name, descriptor] : {std::pair{"getX", "()I"}, {"setX", "(I)V"}, {"seven", "()I"}, {"nothing", "()V"}})
+      has_x.Method(name, descriptor, {}, 0, ACCESS_PUBLIC | ACCESS_ABSTRACT);
+    has_x.Link(&root);
+
+    get_x = point.Method("getX", "()I", {Insn(insn_aload, 0), CpInsn(insn_getfield, &x), Insn(insn_ireturn)}, 1,
+                         ACCESS_PUBLIC);
+    set_x = point.Method("setX", "(I)V",
+                         {Insn(insn_aload, 0), Insn(insn_iload, 1), CpInsn(insn_putfield, &x), Insn(insn_return)}, 2,
+                         ACCESS_PUBLIC);
+    seven = point.Method("seven", "()I", {IConst(7), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC);
+    nothing = point.Method("nothing", "()V", {Insn(insn_return)}, 1, ACCESS_PUBLIC);
+    answer = point.Method("answer", "()I", {IConst(42), Insn(insn_ireturn)}, 0, ACCESS_PUBLIC | ACCESS_STATIC);
+    point.Link(&root, {&has_x});
+
+    // As if the field accesses had been resolved
+    get_x->code->code[1].kind = insn_getfield_I;
+    get_x->code->code[1].ic2 = (void *)FieldOffset(0);
+    set_x->code->code[2].kind = insn_putfield_I;
+    set_x->code->code[2].ic2 = (void *)FieldOffset(0);
+  }
+};
+
+TEST_CASE("Trivial methods are recognized") {
+  TrivialMethods t;
+  CHECK(t.get_x->trivial == TRIVIAL_METHOD_GETTER);
+  CHECK(t.set_x->trivial == TRIVIAL_METHOD_SETTER);
+  CHECK(t.seven->trivial == TRIVIAL_METHOD_CONSTANT);
+  CHECK(t.answer->trivial == TRIVIAL_METHOD_CONSTANT);
+  CHECK(t.nothing->trivial == TRIVIAL_METHOD_EMPTY);
+  // The getter's aload is fused with its getfield afterwards
+  CHECK(t.get_x->code->code[0].kind == insn_aload_getfield);
+
+  SyntheticClass cls("Other");
+  // A static method can't be a getter or setter, since nothing guarantees its argument is non-null
+  cp_entry x = FieldRef(&kInt);
+  cp_method *static_getter = cls.Method(
+      "getX", "(LPoint;)I", {Insn(insn_aload, 0), CpInsn(insn_getfield, &x), Insn(insn_ireturn)}, 1, ACCESS_STATIC);
+  CHECK(static_getter->trivial == TRIVIAL_METHOD_NONE);
+
+  // Entering a synchronized method has to take the monitor
+  cp_method *locked = cls.Method("locked", "()V", {Insn(insn_return)}, 1, ACCESS_PUBLIC | ACCESS_SYNCHRONIZED);
+  CHECK(locked->trivial == TRIVIAL_METHOD_NONE);
+
+  // A native bound over the bytecode has to run instead of it
+  native_callback callback{};
+  cp_method *intrinsic = cls.Declare("intrinsic", "()I", {IConst(1), Insn(insn_ireturn)}, 1, ACCESS_PUBLIC);
+  intrinsic->native_handle = &callback;
+  cls.Analyze(intrinsic);
+  CHECK(intrinsic->trivial == TRIVIAL_METHOD_NONE);
+}
+
+TEST_CASE("Trivial methods run without a frame through every invoke kind") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  TrivialMethods t;
+  SyntheticClass cls("Caller");
+
+  // static int answer() { return Point.answer(); }
+  cp_entry answer_ref = MethodRef(t.answer);
+  cp_method *answer = cls.Method("answer", "()I", {CpInsn(insn_invokestatic, &answer_ref), Insn(insn_ireturn)}, 0);
+  QuickenCall(cls, &answer->code->code[0], insn_invokestatic_resolved, t.answer, nullptr);
+  CHECK(Call(thread, answer).i == 42);
+  CHECK(t.answer->call_count == 0);
+
+  cp_method *targets[] = {t.set_x, t.nothing, t.get_x, t.seven};
+  cp_entry point_refs[4], has_x_refs[4];
+  for (int i = 0; i < 4; ++i) {
+    point_refs[i] = MethodRef(targets[i]);
+    cp_method *declared = method_lookup(&t.has_x.cd, targets[i]->name, targets[i]->unparsed_descriptor, false, false);
+    has_x_refs[i] = MethodRef(declared);
+  }
+
+  for (insn_code_kind kind :
+       {insn_invokespecial_resolved, insn_invokevirtual_direct, insn_invokevtable_monomorphic, insn_invokevtable_pic,
+        insn_invokevtable_polymorphic, insn_invokeitable_monomorphic, insn_invokeitable_pic,
+        insn_invokeitable_polymorphic}) {
+    CAPTURE(insn_code_to_string(kind));
+    bool is_interface = kind == insn_invokeitable_monomorphic || kind == insn_invokeitable_pic ||
+                        kind == insn_invokeitable_polymorphic;
+    cp_entry *refs = is_interface ? has_x_refs : point_refs;
+    insn_code_kind invoke = is_interface ? insn_invokeinterface : insn_invokevirtual;
+
+    // static int f(Point p, int x) { p.setX(x); p.nothing(); return p.getX() + p.seven(); }
+    cp_method *f = cls.Method(insn_code_to_string(kind), "(LPoint;I)I",
+                              {Insn(insn_aload, 0), Insn(insn_iload, 1), CpInsn(invoke, &refs[0]),
+                               Insn(insn_aload, 0), CpInsn(invoke, &refs[1]),
+                               Insn(insn_aload, 0), CpInsn(invoke, &refs[2]),
+                               Insn(insn_aload, 0), CpInsn(invoke, &refs[3]),
+                               Insn(insn_iadd), Insn(insn_ireturn)},
+                              2);
+    for (int i = 0; i < 4; ++i)
+      QuickenCall(cls, &f->code->code[2 + 2 * i], kind, targets[i], &t.point.cd);
+
+    SyntheticObject p(t.point);
+    for (int x : {5, -1000}) {
+      CHECK(Call(thread, f, {{.obj = &p.header}, {.i = x}}).i == x + 7);
+      CHECK(p.fields[0] == x);
+    }
+    for (cp_method *target : targets)
+      CHECK(target->call_count == 0);
+  }
+
+  free_thread(thread);
+}
+
+TEST_CASE("A trivial getter on a null receiver throws NullPointerException from the call") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  TrivialMethods t;
+  SyntheticClass cls("Caller");
+
+  // static int f(Point p) { return p.getX(); }
+  cp_entry get_x = MethodRef(t.get_x);
+  cp_method *f = cls.Method("f", "(LPoint;)I",
+                            {Insn(insn_aload, 0), CpInsn(insn_invokevirtual, &get_x), Insn(insn_ireturn)}, 1);
+  for (insn_code_kind kind : {insn_invokevirtual_direct, insn_invokevtable_monomorphic, insn_invokespecial_resolved}) {
+    CAPTURE(insn_code_to_string(kind));
+    QuickenCall(cls, &f->code->code[1], kind, t.get_x, &t.point.cd);
+    Call(thread, f, {{.obj = nullptr}});
+    // The getter never gets a frame, so the exception comes from the call in f
+    RequireNullPointerExceptionAt(thread, f, 1);
+    CHECK(t.get_x->call_count == 0);
+  }
+
+  free_thread(thread);
+}
+
+TEST_CASE("A trivial reference setter marks the card of an old object") {
+  vm_options options = default_vm_options();
+  options.nursery_size = 1 << 18;
+  auto vm = CreateTestVM(options);
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+
+  // void setDeclaringClass(String s) { this.declaringClass = s; }, setting the field of StackTraceElement, whose
+  // layout is fixed
+  SyntheticClass element("Element");
+  field_descriptor string_type = {.base_kind = TYPE_KIND_REFERENCE, .repr_kind = TYPE_KIND_REFERENCE};
+  cp_entry declaring_class = FieldRef(&string_type);
+  cp_method *setter = element.Method(
+      "setDeclaringClass", "(Ljava/lang/String;)V",
+      {Insn(insn_aload, 0), Insn(insn_aload, 1), CpInsn(insn_putfield, &declaring_class), Insn(insn_return)}, 2,
+      ACCESS_PUBLIC);
+  REQUIRE(setter->trivial == TRIVIAL_METHOD_SETTER);
+  setter->code->code[2].kind = insn_putfield_L;
+  setter->code->code[2].ic2 = (void *)offsetof(struct native_StackTraceElement, declaringClass);
+
+  // static void f(StackTraceElement e, String s) { e.setDeclaringClass(s); }
+  SyntheticClass cls("Caller");
+  cp_entry setter_ref = MethodRef(setter);
+  cp_method *f = cls.Method("f", "(Ljava/lang/StackTraceElement;Ljava/lang/String;)V",
+                            {Insn(insn_aload, 0), Insn(insn_aload, 1), CpInsn(insn_invokevirtual, &setter_ref),
+                             Insn(insn_return)},
+                            2);
+  QuickenCall(cls, &f->code->code[2], insn_invokevirtual_direct, setter, nullptr);
+
+  classdesc *StackTraceElement = bootstrap_lookup_class(thread, STR("java/lang/StackTraceElement"));
+  REQUIRE(!link_class(thread, StackTraceElement));
+  handle *holder = make_handle(thread, new_object(thread, StackTraceElement));
+  major_gc(vm.get());
+  REQUIRE(!in_nursery(vm.get(), holder->obj));
+  u8 *card = &vm->card_table[((u8 *)holder->obj - vm->heap) / CARD_BYTES];
+  *card = 0; // the holder has no references into the nursery yet
+
+  object str = MakeJStringFromCString(thread, "young", false);
+  REQUIRE(in_nursery(vm.get(), str));
+  Call(thread, f, {{.obj = holder->obj}, {.obj = str}});
+  REQUIRE(!thread->current_exception);
+  CHECK(setter->call_count == 0);
+  CHECK(*card);
+
+  // So the string survives a minor GC through the holder alone
+  minor_gc(vm.get());
+  auto *e = (struct native_StackTraceElement *)holder->obj;
+  REQUIRE(e->declaringClass);
+  CHECK(ReadJavaString(thread, e->declaringClass) == "young");
+
+  drop_handle(thread, holder);
+  free_thread(thread);
+}
+
+// A static method which passes its arguments straight on to a JDK method, so that the call is replaced by the method's
+// intrinsic instruction the first time it runs
+struct IntrinsicCall {
+  cp_method *caller;
+  cp_method *target;
+  int pc; // of the call in the caller
+
+  stack_value operator()(vm_thread *thread, std::vector<stack_value> args = {}) const {
+    stack_value result = Call(thread, caller, std::move(args));
+    // Methods without an intrinsic, like numberOfTrailingZeros, are called as usual
+    if (!thread->current_exception && target->intrinsic != insn_nop)
+      CHECK(caller->code->code[pc].kind == target->intrinsic);
+    return result;
+  }
+};
+
+struct IntrinsicCallers {
+  vm_thread *thread;
+  SyntheticClass cls{"IntrinsicCallers"};
+  std::deque<std::string> descriptors;
+  std::deque<cp_entry> refs;
+
+  explicit IntrinsicCallers(vm_thread *thread) : thread(thread) {}
+
+  // static <descriptor> name(...) { return class_name.name(...); }, or, for a virtual method, with the receiver as the
+  // first argument
+  IntrinsicCall Get(const char *class_name, const char *name, const char *descriptor, bool is_virtual = false) {
+    classdesc *desc = bootstrap_lookup_class(thread, str_to_utf8(class_name));
+    REQUIRE(desc != nullptr);
+    AWAIT_READY(initialize_class, thread, desc);
+    cp_method *target = method_lookup(desc, str_to_utf8(name), str_to_utf8(descriptor), false, false);
+    REQUIRE(target != nullptr);
+    cp_entry *ref = &refs.emplace_back(MethodRef(target));
+
+    const std::string &caller_descriptor = descriptors.emplace_back(
+        is_virtual ? "(L" + std::string(class_name) + ";" + (descriptor + 1) : std::string(descriptor));
+    std::vector<bytecode_insn> insns;
+    int local = 0;
+    const char *c = caller_descriptor.c_str() + 1;
+    for (; *c != ')'; ++c) {
+      switch (*c) {
+      case 'J':
+        insns.push_back(Insn(insn_lload, local));
+        local += 2;
+        break;
+      case 'D':
+        insns.push_back(Insn(insn_dload, local));
+        local += 2;
+        break;
+      case 'F':
+        insns.push_back(Insn(insn_fload, local++));
+        break;
+      case 'L':
+        insns.push_back(Insn(insn_aload, local++));
+        c = strchr(c, ';');
+        break;
+      default:
+        insns.push_back(Insn(insn_iload, local++));
+      }
+    }
+    int pc = (int)insns.size();
+    insns.push_back(CpInsn(is_virtual ? insn_invokevirtual : insn_invokestatic, ref));
+    switch (c[1]) {
+    case 'J':
+      insns.push_back(Insn(insn_lreturn));
+      break;
+    case 'D':
+      insns.push_back(Insn(insn_dreturn));
+      break;
+    case 'F':
+      insns.push_back(Insn(insn_freturn));
+      break;
+    case 'L':
+      insns.push_back(Insn(insn_areturn));
+      break;
+    default:
+      insns.push_back(Insn(insn_ireturn));
+    }
+    return {cls.Method(name, caller_descriptor.c_str(), insns, local), target, pc};
+  }
+};
+
+TEST_CASE("Math.min and max intrinsics propagate NaN and order -0.0 below 0.0") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  IntrinsicCallers callers(thread);
+  IntrinsicCall fmin = callers.Get("java/lang/Math", "min", "(FF)F");
+  IntrinsicCall fmax = callers.Get("java/lang/Math", "max", "(FF)F");
+  IntrinsicCall dmin = callers.Get("java/lang/Math", "min", "(DD)D");
+  IntrinsicCall dmax = callers.Get("java/lang/Math", "max", "(DD)D");
+
+  for (const IntrinsicCall &f : {fmin, fmax}) {
+    CHECK(std::isnan(f(thread, {{.f = NAN}, {.f = 1}}).f));
+    CHECK(std::isnan(f(thread, {{.f = 1}, {.f = NAN}}).f));
+  }
+  for (const IntrinsicCall &f : {dmin, dmax}) {
+    CHECK(std::isnan(f(thread, {{.d = NAN}, {.d = 1}}).d));
+    CHECK(std::isnan(f(thread, {{.d = 1}, {.d = NAN}}).d));
+  }
+
+  // Either order of the arguments
+  for (float a : {-0.0f, 0.0f}) {
+    float b = -a;
+    CHECK(std::signbit(fmin(thread, {{.f = a}, {.f = b}}).f));
+    CHECK(!std::signbit(fmax(thread, {{.f = a}, {.f = b}}).f));
+    CHECK(std::signbit(dmin(thread, {{.d = a}, {.d = b}}).d));
+    CHECK(!std::signbit(dmax(thread, {{.d = a}, {.d = b}}).d));
+  }
+  CHECK(fmin(thread, {{.f = 2}, {.f = -3}}).f == -3);
+  CHECK(dmax(thread, {{.d = 2}, {.d = -3}}).d == 2);
+  free_thread(thread);
+}
+
+TEST_CASE("Math.abs intrinsics leave MIN_VALUE negative") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  IntrinsicCallers callers(thread);
+  IntrinsicCall iabs = callers.Get("java/lang/Math", "abs", "(I)I");
+  IntrinsicCall labs = callers.Get("java/lang/Math", "abs", "(J)J");
+
+  CHECK(iabs(thread, {{.i = INT_MIN}}).i == INT_MIN);
+  CHECK(iabs(thread, {{.i = -5}}).i == 5);
+  CHECK(labs(thread, {{.l = LLONG_MIN}}).l == LLONG_MIN);
+  CHECK(labs(thread, {{.l = -5}}).l == 5);
+  free_thread(thread);
+}
+
+TEST_CASE("Integer and Long bit intrinsics at 0 and -1") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  IntrinsicCallers callers(thread);
+  struct {
+    IntrinsicCall call;
+    int at_zero, at_minus_one;
+  } int_cases[] = {
+      {callers.Get("java/lang/Integer", "numberOfLeadingZeros", "(I)I"), 32, 0},
+      {callers.Get("java/lang/Integer", "numberOfTrailingZeros", "(I)I"), 32, 0},
+      {callers.Get("java/lang/Integer", "bitCount", "(I)I"), 0, 32},
+      {callers.Get("java/lang/Integer", "reverse", "(I)I"), 0, -1},
+      {callers.Get("java/lang/Integer", "reverseBytes", "(I)I"), 0, -1},
+  };
+  for (const auto &c : int_cases) {
+    CAPTURE(to_string_view(c.call.target->name));
+    CHECK(c.call(thread, {{.i = 0}}).i == c.at_zero);
+    CHECK(c.call(thread, {{.i = -1}}).i == c.at_minus_one);
+  }
+
+  // The counting methods return an int, the others a long
+  struct {
+    IntrinsicCall call;
+    s64 at_zero, at_minus_one;
+  } long_cases[] = {
+      {callers.Get("java/lang/Long", "numberOfLeadingZeros", "(J)I"), 64, 0},
+      {callers.Get("java/lang/Long", "numberOfTrailingZeros", "(J)I"), 64, 0},
+      {callers.Get("java/lang/Long", "bitCount", "(J)I"), 0, 64},
+      {callers.Get("java/lang/Long", "reverse", "(J)J"), 0, -1},
+      {callers.Get("java/lang/Long", "reverseBytes", "(J)J"), 0, -1},
+  };
+  for (const auto &c : long_cases) {
+    CAPTURE(to_string_view(c.call.target->name));
+    bool returns_long = c.call.target->descriptor->return_type.base_kind == TYPE_KIND_LONG;
+    stack_value at_zero = c.call(thread, {{.l = 0}}), at_minus_one = c.call(thread, {{.l = -1}});
+    CHECK((returns_long ? at_zero.l : at_zero.i) == c.at_zero);
+    CHECK((returns_long ? at_minus_one.l : at_minus_one.i) == c.at_minus_one);
+  }
+  free_thread(thread);
+}
+
+TEST_CASE("Object.getClass intrinsic throws NullPointerException on null") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  IntrinsicCallers callers(thread);
+  IntrinsicCall get_class = callers.Get("java/lang/Object", "getClass", "()Ljava/lang/Class;", true);
+
+  // The first call on an object replaces the invokevirtual with the intrinsic, which the null then goes through
+  object str = MakeJStringFromCString(thread, "str", false);
+  CHECK(get_class(thread, {{.obj = str}}).obj == (object)get_class_mirror(thread, str->descriptor));
+  REQUIRE(get_class.caller->code->code[get_class.pc].kind == insn_get_class);
+  get_class(thread, {{.obj = nullptr}});
+  RequireNullPointerExceptionAt(thread, get_class.caller, get_class.pc);
+  free_thread(thread);
+}
+
+TEST_CASE("Thread.currentThread and System.identityHashCode intrinsics are stable across GC") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  IntrinsicCallers callers(thread);
+  IntrinsicCall current_thread = callers.Get("java/lang/Thread", "currentThread", "()Ljava/lang/Thread;");
+  IntrinsicCall identity_hash_code =
+      callers.Get("java/lang/System", "identityHashCode", "(Ljava/lang/Object;)I");
+
+  handle *young = make_handle(thread, MakeJStringFromCString(thread, "young", false));
+  REQUIRE(in_nursery(thread->vm, young->obj));
+  s32 young_hash = identity_hash_code(thread, {{.obj = young->obj}}).i;
+  s32 thread_hash = identity_hash_code(thread, {current_thread(thread)}).i;
+  REQUIRE(current_thread(thread).obj == (object)thread->thread_obj);
+
+  // Promotes the string out of the nursery, then moves everything again
+  minor_gc(thread->vm);
+  REQUIRE(!in_nursery(thread->vm, young->obj));
+  major_gc(thread->vm);
+
+  CHECK(current_thread(thread).obj == (object)thread->thread_obj);
+  CHECK(identity_hash_code(thread, {current_thread(thread)}).i == thread_hash);
+  CHECK(identity_hash_code(thread, {{.obj = young->obj}}).i == young_hash);
+  drop_handle(thread, young);
+  free_thread(thread);
+}
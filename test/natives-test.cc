@@ -7,13 +7,17 @@
 #include <fstream>
 #include <iostream>
 #include <optional>
+#include <random>
 #include <unordered_map>
 
 #include "doctest/doctest.h"
 
+#include "arrays.h"
 #include "roundrobin_scheduler.h"
 #include "tests-common.h"
 
+using namespace Bjvm::Tests;
+
 struct async_wakeup_info {
   int index;
 };
@@ -101,4 +105,298 @@ TEST_CASE("Async natives") {
   rr_scheduler_uninit(&scheduler);
   free_thread(thread);
   free_vm(vm);
-}
\ No newline at end of file
+}
+
+// An argument to a method under test: either a primitive value or an array, created afresh for each call
+struct IntrinsicArg {
+  stack_value value = {};
+  type_kind array_kind = TYPE_KIND_VOID; // TYPE_KIND_REFERENCE for a null array
+  std::vector<u8> contents;
+};
+
+static IntrinsicArg IntArg(int i) { return {.value = {.i = i}}; }
+static IntrinsicArg LongArg(s64 l) { return {.value = {.l = l}}; }
+static IntrinsicArg NullArg() { return {.array_kind = TYPE_KIND_REFERENCE}; }
+
+static IntrinsicArg ArrayArg(type_kind kind, int length, std::mt19937 &rng, int alphabet = 256) {
+  IntrinsicArg arg{.array_kind = kind};
+  arg.contents.resize(length * sizeof_type_kind(kind));
+  for (u8 &b : arg.contents)
+    b = rng() % alphabet;
+  return arg;
+}
+
+struct IntrinsicResult {
+  s64 value;
+  std::string exception; // class name of the exception thrown, if any
+  std::vector<std::vector<u8>> arrays;
+
+  bool operator==(const IntrinsicResult &) const = default;
+};
+
+static std::vector<u8> ArrayContents(obj_header *array) {
+  u8 *data = (u8 *)ArrayData(array);
+  return {data, data + ArrayLength(array) * sizeof_type_kind(array->descriptor->primitive_component)};
+}
+
+// Calls the method either through the native bound over it by DECLARE_INTRINSIC_NATIVE or, with the native unbound,
+// as bytecode
+static IntrinsicResult CallIntrinsic(vm_thread *thread, cp_method *method, const std::vector<IntrinsicArg> &args,
+                                     bool as_bytecode) {
+  std::vector<handle *> arrays;
+  for (const IntrinsicArg &arg : args) {
+    if (arg.array_kind == TYPE_KIND_VOID || arg.array_kind == TYPE_KIND_REFERENCE)
+      continue;
+    obj_header *array =
+        CreatePrimitiveArray1D(thread, arg.array_kind, (int)(arg.contents.size() / sizeof_type_kind(arg.array_kind)));
+    memcpy(ArrayData(array), arg.contents.data(), arg.contents.size());
+    arrays.push_back(make_handle(thread, array));
+  }
+
+  std::vector<stack_value> values;
+  size_t next_array = 0;
+  for (const IntrinsicArg &arg : args) {
+    if (arg.array_kind == TYPE_KIND_VOID)
+      values.push_back(arg.value);
+    else
+      values.push_back({.obj = arg.array_kind == TYPE_KIND_REFERENCE ? nullptr : arrays[next_array++]->obj});
+  }
+
+  void *native = method->native_handle;
+  REQUIRE(native != nullptr);
+  if (as_bytecode)
+    method->native_handle = nullptr;
+  stack_value value = call_interpreter_synchronous(thread, method, values.data());
+  method->native_handle = native;
+
+  IntrinsicResult result{};
+  const field_descriptor &return_type = method->descriptor->return_type;
+  if (thread->current_exception) {
+    result.exception = to_string_view(thread->current_exception->descriptor->name);
+    thread->current_exception = nullptr;
+  } else if (return_type.repr_kind == TYPE_KIND_REFERENCE) {
+    // A returned array is either one of the arguments, identified by its index, or a new one compared by contents
+    result.value = -1;
+    for (size_t i = 0; i < arrays.size(); ++i) {
+      if (arrays[i]->obj == value.obj)
+        result.value = (s64)i;
+    }
+    if (value.obj && result.value < 0)
+      result.arrays.push_back(ArrayContents(value.obj));
+  } else if (return_type.base_kind != TYPE_KIND_VOID) {
+    result.value = return_type.base_kind == TYPE_KIND_LONG ? value.l : value.i;
+  }
+  for (handle *array : arrays) {
+    result.arrays.push_back(ArrayContents(array->obj));
+    drop_handle(thread, array);
+  }
+  return result;
+}
+
+struct IntrinsicTester {
+  vm_thread *thread;
+  cp_method *method;
+
+  IntrinsicTester(vm_thread *thread, const char *class_name, const char *name, const char *descriptor)
+      : thread(thread) {
+    classdesc *desc = bootstrap_lookup_class(thread, str_to_utf8(class_name));
+    REQUIRE(desc != nullptr);
+    AWAIT_READY(initialize_class, thread, desc);
+    method = method_lookup(desc, str_to_utf8(name), str_to_utf8(descriptor), false, false);
+    REQUIRE(method != nullptr);
+  }
+
+  void Check(const std::vector<IntrinsicArg> &args) {
+    IntrinsicResult native = CallIntrinsic(thread, method, args, false);
+    IntrinsicResult bytecode = CallIntrinsic(thread, method, args, true);
+    REQUIRE(native.exception == bytecode.exception);
+    REQUIRE(native.value == bytecode.value);
+    REQUIRE(native.arrays == bytecode.arrays);
+  }
+};
+
+// Mostly in-range offsets and lengths, with the occasional out-of-range one
+static int Around(std::mt19937 &rng, int lo, int hi) {
+  if (rng() % 16 == 0)
+    return lo - 1 - (int)(rng() % 4);
+  if (rng() % 16 == 0)
+    return hi + 1 + (int)(rng() % 4);
+  return lo + (int)(rng() % (hi - lo + 1));
+}
+
+TEST_CASE("Intrinsic natives match the bytecode") {
+  auto vm = CreateTestVM();
+  vm_thread *thread = create_main_thread(vm.get(), default_thread_options());
+  std::mt19937 rng(24);
+
+  SUBCASE("ArraysSupport") {
+    IntrinsicTester mismatch(thread, "jdk/internal/util/ArraysSupport", "vectorizedMismatch",
+                             "(Ljava/lang/Object;JLjava/lang/Object;JII)I");
+    for (int i = 0; i < 400; ++i) {
+      int log2_scale = rng() % 4, length = rng() % 80, a_off = rng() % 5, b_off = rng() % 5;
+      type_kind kinds[] = {TYPE_KIND_BYTE, TYPE_KIND_CHAR, TYPE_KIND_INT, TYPE_KIND_LONG};
+      IntrinsicArg a = ArrayArg(kinds[log2_scale], length + a_off, rng, 2);
+      IntrinsicArg b = a;
+      b.contents.resize((length + b_off) << log2_scale);
+      if (rng() % 2)
+        std::ranges::fill(b.contents, 0);
+      mismatch.Check({a, LongArg(kArrayDataOffset + (a_off << log2_scale)), b,
+                      LongArg(kArrayDataOffset + (b_off << log2_scale)), IntArg(length), IntArg(log2_scale)});
+    }
+
+    IntrinsicTester hash(thread, "jdk/internal/util/ArraysSupport", "vectorizedHashCode", "(Ljava/lang/Object;IIII)I");
+    struct {
+      int basic_type;
+      type_kind kind;
+    } types[] = {{4, TYPE_KIND_BYTE},  {5, TYPE_KIND_CHAR},  {5, TYPE_KIND_BYTE},
+                 {8, TYPE_KIND_BYTE},  {9, TYPE_KIND_SHORT}, {10, TYPE_KIND_INT}};
+    for (int i = 0; i < 400; ++i) {
+      auto [basic_type, kind] = types[rng() % std::size(types)];
+      int length = rng() % 100;
+      IntrinsicArg array = ArrayArg(kind, length, rng);
+      if (basic_type == 5 && kind == TYPE_KIND_BYTE)
+        length /= 2;
+      int from = Around(rng, 0, length), count = Around(rng, 0, length - std::max(from, 0));
+      hash.Check({array, IntArg(from), IntArg(count), IntArg((int)rng()), IntArg(basic_type)});
+    }
+    hash.Check({NullArg(), IntArg(0), IntArg(1), IntArg(1), IntArg(10)});
+    hash.Check({NullArg(), IntArg(0), IntArg(0), IntArg(1), IntArg(10)});
+  }
+
+  SUBCASE("StringLatin1") {
+    IntrinsicTester equals(thread, "java/lang/StringLatin1", "equals", "([B[B)Z");
+    IntrinsicTester index_of_char(thread, "java/lang/StringLatin1", "indexOfChar", "([BIII)I");
+    IntrinsicTester index_of(thread, "java/lang/StringLatin1", "indexOf", "([BI[BII)I");
+    IntrinsicTester inflate(thread, "java/lang/StringLatin1", "inflate", "([BI[CII)V");
+    for (int i = 0; i < 400; ++i) {
+      int length = rng() % 100;
+      IntrinsicArg value = ArrayArg(TYPE_KIND_BYTE, length, rng, 4);
+      IntrinsicArg other = value;
+      if (length && rng() % 2)
+        other.contents[rng() % length] ^= 1;
+      equals.Check({value, other});
+
+      int from = Around(rng, 0, length);
+      index_of_char.Check({value, IntArg(rng() % 5), IntArg(from), IntArg(Around(rng, from, length))});
+
+      int str_count = Around(rng, 0, 4);
+      IntrinsicArg str = ArrayArg(TYPE_KIND_BYTE, std::max(str_count, 1), rng, 3);
+      index_of.Check({value, IntArg(length), str, IntArg(str_count), IntArg(Around(rng, 0, length))});
+
+      int src_off = Around(rng, 0, length), dst_length = rng() % 100, dst_off = Around(rng, 0, dst_length);
+      IntrinsicArg dst = ArrayArg(TYPE_KIND_CHAR, dst_length, rng);
+      int len = Around(rng, 0, std::max(0, std::min(length - src_off, dst_length - dst_off)));
+      inflate.Check({value, IntArg(src_off), dst, IntArg(dst_off), IntArg(len)});
+    }
+    equals.Check({NullArg(), ArrayArg(TYPE_KIND_BYTE, 1, rng)});
+  }
+
+  SUBCASE("StringUTF16") {
+    IntrinsicTester compress_chars(thread, "java/lang/StringUTF16", "compress", "([CI[BII)I");
+    IntrinsicTester compress_bytes(thread, "java/lang/StringUTF16", "compress", "([BI[BII)I");
+    for (int i = 0; i < 400; ++i) {
+      int length = rng() % 100;
+      IntrinsicArg chars = ArrayArg(TYPE_KIND_CHAR, length, rng);
+      for (int j = 1; j < length * 2; j += 2) // mostly Latin-1
+        chars.contents[j] = rng() % 64 == 0;
+      IntrinsicArg bytes = chars;
+      bytes.array_kind = TYPE_KIND_BYTE;
+
+      int src_off = Around(rng, 0, length), dst_length = rng() % 100, dst_off = Around(rng, 0, dst_length);
+      IntrinsicArg dst = ArrayArg(TYPE_KIND_BYTE, dst_length, rng);
+      int len = Around(rng, 0, std::max(0, std::min(length - src_off, dst_length - dst_off)));
+      compress_chars.Check({chars, IntArg(src_off), dst, IntArg(dst_off), IntArg(len)});
+      compress_bytes.Check({bytes, IntArg(src_off), dst, IntArg(dst_off), IntArg(len)});
+    }
+  }
+
+  SUBCASE("BigInteger") {
+    const char *big_integer = "java/math/BigInteger";
+    IntrinsicTester multiply(thread, big_integer, "implMultiplyToLen", "([II[II[I)[I");
+    IntrinsicTester square(thread, big_integer, "implSquareToLen", "([II[II)[I");
+    IntrinsicTester mul_add(thread, big_integer, "implMulAdd", "([I[IIII)I");
+    IntrinsicTester montgomery_multiply(thread, big_integer, "implMontgomeryMultiply", "([I[I[IIJ[I)[I");
+    IntrinsicTester montgomery_square(thread, big_integer, "implMontgomerySquare", "([I[IIJ[I)[I");
+    IntrinsicTester shift_left(thread, big_integer, "shiftLeftImplWorker", "([I[IIII)V");
+    IntrinsicTester shift_right(thread, big_integer, "shiftRightImplWorker", "([I[IIII)V");
+    for (int i = 0; i < 200; ++i) {
+      int xlen = 1 + rng() % 12, ylen = 1 + rng() % 12;
+      IntrinsicArg x = ArrayArg(TYPE_KIND_INT, xlen + rng() % 2, rng), y = ArrayArg(TYPE_KIND_INT, ylen, rng);
+      IntrinsicArg z = rng() % 2 ? NullArg() : ArrayArg(TYPE_KIND_INT, xlen + ylen - 1 + rng() % 3, rng);
+      multiply.Check({x, IntArg(xlen), y, IntArg(ylen), z});
+      square.Check({x, IntArg(xlen), ArrayArg(TYPE_KIND_INT, 2 * xlen, rng), IntArg(2 * xlen)});
+      mul_add.Check({ArrayArg(TYPE_KIND_INT, xlen + ylen, rng), y, IntArg(rng() % (xlen + 1)), IntArg(ylen),
+                     IntArg((int)rng())});
+
+      // An odd modulus with its top bit set, and the Montgomery inverse -n^-1 mod 2^32
+      int len = 2 * (1 + rng() % 6);
+      IntrinsicArg n = ArrayArg(TYPE_KIND_INT, len, rng), a = ArrayArg(TYPE_KIND_INT, len, rng),
+                   b = ArrayArg(TYPE_KIND_INT, len, rng);
+      u32 *digits = (u32 *)n.contents.data();
+      digits[0] |= 0x80000000;
+      digits[len - 1] |= 1;
+      ((u32 *)a.contents.data())[0] &= 0x7fffffff;
+      ((u32 *)b.contents.data())[0] &= 0x7fffffff;
+      u32 inv = digits[len - 1];
+      for (int j = 0; j < 5; ++j)
+        inv *= 2 - digits[len - 1] * inv;
+      IntrinsicArg product = rng() % 2 ? NullArg() : ArrayArg(TYPE_KIND_INT, 2 * len, rng);
+      montgomery_multiply.Check({a, b, n, IntArg(len), LongArg(-(s64)inv), product});
+      montgomery_square.Check({a, n, IntArg(len), LongArg(-(s64)inv), product});
+
+      int shift = 1 + rng() % 31, new_idx = rng() % 3;
+      std::vector<IntrinsicArg> shift_args = {ArrayArg(TYPE_KIND_INT, new_idx + xlen, rng), x, IntArg(new_idx),
+                                              IntArg(shift), IntArg(xlen - 1)};
+      shift_left.Check(shift_args);
+      shift_right.Check(shift_args);
+    }
+  }
+
+  SUBCASE("Arrays") {
+    struct {
+      type_kind kind;
+      char descriptor;
+    } types[] = {{TYPE_KIND_BOOLEAN, 'Z'}, {TYPE_KIND_BYTE, 'B'}, {TYPE_KIND_CHAR, 'C'},  {TYPE_KIND_SHORT, 'S'},
+                 {TYPE_KIND_INT, 'I'},     {TYPE_KIND_LONG, 'J'}, {TYPE_KIND_FLOAT, 'F'}, {TYPE_KIND_DOUBLE, 'D'}};
+    for (auto [kind, c] : types) {
+      std::string array_descriptor = std::string("[") + c;
+      std::string equals_descriptor = "(" + array_descriptor + array_descriptor + ")Z";
+      std::string fill_descriptor = "(" + array_descriptor + c + ")V";
+      std::string fill_range_descriptor = "(" + array_descriptor + "II" + c + ")V";
+      IntrinsicTester fill(thread, "java/util/Arrays", "fill", fill_descriptor.c_str());
+      IntrinsicTester fill_range(thread, "java/util/Arrays", "fill", fill_range_descriptor.c_str());
+      // float[] and double[] equality is left to the bytecode
+      std::optional<IntrinsicTester> equals;
+      if (kind != TYPE_KIND_FLOAT && kind != TYPE_KIND_DOUBLE)
+        equals.emplace(thread, "java/util/Arrays", "equals", equals_descriptor.c_str());
+
+      for (int i = 0; i < 100; ++i) {
+        int length = rng() % 70;
+        IntrinsicArg a = ArrayArg(kind, length, rng, kind == TYPE_KIND_BOOLEAN ? 2 : 256);
+        IntrinsicArg value = LongArg((s64)rng() << 32 | rng());
+        if (kind == TYPE_KIND_BOOLEAN)
+          value = IntArg(rng() % 2);
+        else if (kind == TYPE_KIND_FLOAT)
+          value.value.f = (float)(int)rng() / 7;
+        else if (kind == TYPE_KIND_DOUBLE)
+          value.value.d = (double)value.value.l / 7;
+        else if (sizeof_type_kind(kind) < 8)
+          value = IntArg((int)(value.value.l >> (64 - 8 * sizeof_type_kind(kind))));
+
+        if (equals) {
+          IntrinsicArg b = a;
+          if (length && rng() % 2)
+            b.contents[rng() % b.contents.size()] ^= 1;
+          equals->Check({a, b});
+          equals->Check({a, rng() % 2 ? NullArg() : ArrayArg(kind, rng() % 3, rng)});
+        }
+        fill.Check({a, value});
+        int from = Around(rng, 0, length);
+        fill_range.Check({a, IntArg(from), IntArg(Around(rng, std::max(from - 1, 0), length)), value});
+      }
+      fill.Check({NullArg(), kind == TYPE_KIND_LONG || kind == TYPE_KIND_DOUBLE ? LongArg(1) : IntArg(1)});
+    }
+  }
+
+  free_thread(thread);
+}
@@ -195,9 +195,9 @@ void print_method_sigs() {
 }
 
 ScheduledTestCaseResult run_test_case(std::string classpath, bool capture_stdio, std::string main_class,
-                                      std::string input, std::vector<std::string> args) {
+                                      std::string input, std::vector<std::string> args, vm_options options) {
   return run_scheduled_test_case(std::move(classpath), capture_stdio, std::move(main_class), std::move(input),
-                                 std::move(args));
+                                 std::move(args), options);
 }
 
 #ifdef EMSCRIPTEN
@@ -205,9 +205,9 @@ static void busy_wait(double us) { EM_ASM("const endAt = Date.now() + $0 / 1000;
 #endif
 
 ScheduledTestCaseResult run_scheduled_test_case(std::string classpath, bool capture_stdio, std::string main_class,
-                                                std::string input, std::vector<std::string> string_args) {
+                                                std::string input, std::vector<std::string> string_args,
+                                                vm_options options) {
   printf("Classpath: %s\n", classpath.c_str());
-  vm_options options = default_vm_options();
 
   ScheduledTestCaseResult result{};
   result.stdin_ = input;
@@ -268,7 +268,7 @@ ScheduledTestCaseResult run_scheduled_test_case(std::string classpath, bool capt
       make_handle(thread, CreateObjectArray1D(thread, cached_classes(thread->vm)->string, (int)string_args.size()));
   for (size_t i = 0; i < string_args.size(); i++) {
     object str = MakeJStringFromCString(thread, string_args[i].c_str(), true);
-    ReferenceArrayStore(string_args_as_object->obj, (int)i, str);
+    ReferenceArrayStore(thread, string_args_as_object->obj, (int)i, str);
   }
 
   stack_value args[1] = {{.obj = string_args_as_object->obj}};
@@ -67,6 +67,9 @@ void string_builder_free(string_builder *builder);
 
 string_hash_table make_hash_table(void (*free_fn)(void *), double load_factor, size_t initial_capacity);
 
+// Hash of a byte string, as used by string_hash_table
+u32 fxhash_string(const char *key, size_t len);
+
 hash_table_iterator hash_table_get_iterator(const string_hash_table *tbl);
 
 bool hash_table_iterator_has_next(hash_table_iterator iter, char **key, size_t *key_len, void **value);
@@ -0,0 +1,123 @@
+#include <allocation_profiler.h>
+
+// Allocations are sampled in bump_allocate_slow. While the profiler runs, each thread's TLAB end is lowered to where
+// its next sample is due, so the allocation which reaches it falls off the fast path; the bytes between samples are
+// randomized around sample_bytes.
+//
+// Samples are counted in a hash map keyed by the class descriptor followed by the methods on the stack, innermost
+// first, as raw pointers (like the CPU profiler does).
+typedef struct allocation_profiler {
+  vm *vm;
+  size_t sample_bytes;
+  u64 random_state;
+  // Stack key -> u64 estimated bytes allocated
+  string_hash_table sites;
+} allocation_profiler;
+
+#define MAX_SAMPLE_DEPTH 256
+
+allocation_profiler *start_allocation_profiler(vm *vm, size_t sample_bytes) {
+  if (vm->allocation_profiler || sample_bytes == 0)
+    return nullptr;
+  allocation_profiler *profiler = calloc(1, sizeof(allocation_profiler));
+  if (!profiler)
+    return nullptr;
+  profiler->vm = vm;
+  profiler->sample_bytes = sample_bytes;
+  profiler->random_state = 0x9e3779b97f4a7c15ULL ^ (uintptr_t)profiler;
+  profiler->sites = make_hash_table(free, 0.75, 64);
+  vm->allocation_profiler = profiler;
+  // Start new TLABs so that their ends get lowered to the first sample
+  for (int i = 0; i < arrlen(vm->active_threads); ++i) {
+    vm_thread *thread = vm->active_threads[i];
+    retire_tlab(thread);
+    thread->bytes_until_sample = next_sample_distance(profiler);
+  }
+  return profiler;
+}
+
+size_t next_sample_distance(allocation_profiler *profiler) {
+  // xorshift64, uniform in [sample_bytes / 2, sample_bytes * 3 / 2]
+  u64 x = profiler->random_state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  profiler->random_state = x;
+  return profiler->sample_bytes / 2 + x % (profiler->sample_bytes + 1);
+}
+
+size_t sample_allocation(vm_thread *thread, classdesc *descriptor, size_t bytes, size_t until_sample) {
+  allocation_profiler *profiler = thread->vm->allocation_profiler;
+  DCHECK(profiler);
+  DCHECK(until_sample < bytes);
+
+  // Every sample falling within the allocation counts, so that each stands for sample_bytes on average
+  u64 samples = 0;
+  for (; until_sample < bytes; until_sample += next_sample_distance(profiler))
+    ++samples;
+
+  void *key[MAX_SAMPLE_DEPTH + 1];
+  int depth = 0;
+  key[depth++] = descriptor;
+  for (stack_frame *frame = thread->stack.top; frame && depth <= MAX_SAMPLE_DEPTH; frame = frame->prev) {
+    key[depth++] = frame->method;
+  }
+
+  int key_len = depth * (int)sizeof(void *);
+  u64 *estimate = hash_table_lookup(&profiler->sites, (char *)key, key_len);
+  if (!estimate && (estimate = calloc(1, sizeof(u64))))
+    (void)hash_table_insert(&profiler->sites, (char *)key, key_len, estimate);
+  if (estimate)
+    *estimate += samples * profiler->sample_bytes;
+  return until_sample - bytes;
+}
+
+// The frames are separated by semicolons, so write arrays the Java way (e.g. java/lang/String[][]) rather than using
+// their descriptors
+static void append_class_name(string_builder *builder, classdesc *descriptor) {
+  classdesc *base = descriptor;
+  while (base->dimensions && base->one_fewer_dim)
+    base = base->one_fewer_dim;
+  string_builder_append(builder, "%.*s", fmt_slice(base->name));
+  for (int i = base->dimensions; i < descriptor->dimensions; ++i)
+    string_builder_append(builder, "[]");
+}
+
+char *finish_allocation_profiler(allocation_profiler *profiler) {
+  if (!profiler)
+    return nullptr;
+  vm *vm = profiler->vm;
+  vm->allocation_profiler = nullptr;
+  // Restore the TLAB ends
+  for (int i = 0; i < arrlen(vm->active_threads); ++i) {
+    retire_tlab(vm->active_threads[i]);
+  }
+
+  string_builder report;
+  string_builder_init(&report);
+
+  hash_table_iterator it = hash_table_get_iterator(&profiler->sites);
+  char *key;
+  size_t key_len;
+  u64 *estimate;
+  while (hash_table_iterator_has_next(it, &key, &key_len, (void **)&estimate)) {
+    int depth = (int)(key_len / sizeof(void *));
+    for (int i = depth - 1; i >= 1; --i) {
+      cp_method *method;
+      memcpy(&method, key + i * sizeof(void *), sizeof(void *));
+      string_builder_append(&report, "%.*s:%.*s;", fmt_slice(method->my_class->name), fmt_slice(method->name));
+    }
+    classdesc *descriptor;
+    memcpy(&descriptor, key, sizeof(void *));
+    append_class_name(&report, descriptor);
+    string_builder_append(&report, " %llu\n", (unsigned long long)*estimate);
+    hash_table_iterator_next(&it);
+  }
+
+  free_hash_table(profiler->sites);
+  free(profiler);
+
+  char *result = strdup(report.data ? report.data : "");
+  string_builder_free(&report);
+  return result;
+}
@@ -0,0 +1,37 @@
+#ifndef ALLOCATION_PROFILER_H
+#define ALLOCATION_PROFILER_H
+
+#include <bjvm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct allocation_profiler allocation_profiler;
+
+// Start sampling the heap allocations of every thread, about once per sample_bytes allocated, recording the class
+// allocated and the Java stack which allocated it. Returns null if a profiler is already running.
+EMSCRIPTEN_KEEPALIVE
+allocation_profiler *start_allocation_profiler(vm *vm, size_t sample_bytes);
+
+// Stop sampling and free the profiler. Returns the allocation sites in the collapsed stack format read by
+// flamegraph.pl and speedscope, one line per distinct stack, e.g.
+//   Main:main;java/util/ArrayList:grow;java/lang/Object[] 1048576
+// where the frames go from the outermost, the last one is the class allocated, and the number is the estimated bytes
+// allocated there. The result is to be freed with free.
+EMSCRIPTEN_KEEPALIVE
+char *finish_allocation_profiler(allocation_profiler *profiler);
+
+// Record the samples due during an allocation by the thread of an object of the given class and size, the next of
+// which is until_sample bytes into it. Returns the bytes from the end of the allocation to the next sample. Called by
+// bump_allocate_slow.
+size_t sample_allocation(vm_thread *thread, classdesc *descriptor, size_t bytes, size_t until_sample);
+// Bytes from one sample to the next. Randomized around sample_bytes so that periodic allocation patterns don't bias
+// the samples.
+size_t next_sample_distance(allocation_profiler *profiler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -981,6 +981,77 @@ static void intersect_exception_handlers(struct method_analysis_ctx *ctx, int in
   }
 }
 
+// Replace the first instruction of common short sequences with a superinstruction that executes the whole sequence.
+// The remaining instructions are left untouched, so a branch or exception handler landing in the middle of a fused
+// sequence still sees the original instructions, and a superinstruction may bail out to them on any slow path (e.g.
+// an aload_getfield on a null reference executes the getfield to raise the NPE).
+static void fuse_superinstructions(attribute_code *code) {
+  bytecode_insn *insns = code->code;
+  for (int i = 0; i + 1 < code->insn_count; ++i) {
+    bytecode_insn *a = insns + i, *b = insns + i + 1, *c = i + 2 < code->insn_count ? insns + i + 2 : nullptr;
+    if (a->kind == insn_aload && b->kind == insn_getfield) {
+      a->kind = insn_aload_getfield;
+      i += 1;
+    } else if (a->kind == insn_aload && b->kind == insn_arraylength) {
+      a->kind = insn_aload_arraylength;
+      i += 1;
+    } else if (a->kind == insn_iload && b->kind == insn_iload && c && (c->kind == insn_iadd || c->kind == insn_isub)) {
+      a->kind = c->kind == insn_iadd ? insn_iload_iload_iadd : insn_iload_iload_isub;
+      i += 2;
+    } else if (a->kind == insn_iload && b->kind == insn_iconst && c && c->kind >= insn_if_icmpeq &&
+               c->kind <= insn_if_icmple) {
+      a->kind = insn_iload_iconst_if_icmpeq + (c->kind - insn_if_icmpeq);
+      i += 2;
+    } else if (a->kind == insn_iinc && b->kind == insn_goto && (int)b->index <= i) {
+      a->kind = insn_iinc_goto;
+      i += 1;
+    }
+  }
+}
+
+static bool is_xload(insn_code_kind kind) {
+  return kind == insn_iload || kind == insn_lload || kind == insn_fload || kind == insn_dload || kind == insn_aload;
+}
+
+static bool is_xreturn(insn_code_kind kind) {
+  return kind == insn_ireturn || kind == insn_lreturn || kind == insn_freturn || kind == insn_dreturn ||
+         kind == insn_areturn;
+}
+
+// Recognize methods which the invoke instructions can execute without pushing a frame. This must run before
+// superinstructions are fused. Getters and setters must be instance methods, so that the receiver is known to be
+// non-null and the field access can't throw.
+static trivial_method_kind classify_trivial_method(const cp_method *method) {
+  const attribute_code *code = method->code;
+  const bytecode_insn *insns = code->code;
+  // A native bound over the bytecode (see DECLARE_INTRINSIC_NATIVE) has to run instead
+  if (method->access_flags & ACCESS_SYNCHRONIZED || method->native_handle)
+    return TRIVIAL_METHOD_NONE;
+  bool is_static = method->access_flags & ACCESS_STATIC;
+  switch (code->insn_count) {
+  case 1:
+    return insns[0].kind == insn_return ? TRIVIAL_METHOD_EMPTY : TRIVIAL_METHOD_NONE;
+  case 2: {
+    insn_code_kind k = insns[0].kind;
+    bool is_const = k == insn_iconst || k == insn_lconst || k == insn_fconst || k == insn_dconst || k == insn_aconst_null;
+    return is_const && is_xreturn(insns[1].kind) ? TRIVIAL_METHOD_CONSTANT : TRIVIAL_METHOD_NONE;
+  }
+  case 3:
+    return !is_static && insns[0].kind == insn_aload && insns[0].index == 0 && insns[1].kind == insn_getfield &&
+                   is_xreturn(insns[2].kind)
+               ? TRIVIAL_METHOD_GETTER
+               : TRIVIAL_METHOD_NONE;
+  case 4:
+    return !is_static && method->descriptor->args_count == 1 && insns[0].kind == insn_aload && insns[0].index == 0 &&
+                   is_xload(insns[1].kind) && insns[1].index == 1 && insns[2].kind == insn_putfield &&
+                   insns[3].kind == insn_return
+               ? TRIVIAL_METHOD_SETTER
+               : TRIVIAL_METHOD_NONE;
+  default:
+    return TRIVIAL_METHOD_NONE;
+  }
+}
+
 int analyze_method_code(cp_method *method, heap_string *error) {
   attribute_code *code = method->code;
   arena *arena = &method->my_class->arena;
@@ -1113,6 +1184,8 @@ analyze:
     goto analyze;
   }
   DCHECK(!ctx.changed);
+  method->trivial = classify_trivial_method(method);
+  fuse_superinstructions(code);
 
 inval:
   stack_map_frame_iterator_uninit(&iter);
@@ -1524,7 +1597,7 @@ static int extended_npe_phase2(const cp_method *method, stack_variable_source *s
       break;
     }
     case insn_getfield:
-    case insn_getfield_B ... insn_getfield_L: {
+    case insn_getfield_B ... insn_getfield_N: {
       // <a>.name or just "name" if a can't be resolved
       int err = extended_npe_phase2(method, &analy->sources[index].a, index, builder, false);
       if (!err) {
@@ -1543,12 +1616,17 @@ static int extended_npe_phase2(const cp_method *method, stack_variable_source *s
     case insn_invokeinterface:
     case insn_invokespecial:
     case insn_invokespecial_resolved:
+    case insn_invokevirtual_direct:
     case insn_invokestatic:
     case insn_invokestatic_resolved:
     case insn_invokeitable_monomorphic:
     case insn_invokeitable_polymorphic:
     case insn_invokevtable_monomorphic:
-    case insn_invokevtable_polymorphic: {
+    case insn_invokevtable_polymorphic:
+    case insn_invokevtable_pic:
+    case insn_invokeitable_pic:
+    case insn_get_class:
+    case insn_current_thread: {
       if (is_first) {
         string_builder_append(builder, "the return value of ");
       }
@@ -1619,21 +1697,25 @@ int get_extended_npe_message(cp_method *method, u16 pc, heap_string *result) {
     CASE(insn_monitorenter, "Cannot enter synchronized block")
     CASE(insn_monitorexit, "Cannot exit synchronized block")
   case insn_getfield:
-  case insn_getfield_B ... insn_getfield_L:
+  case insn_getfield_B ... insn_getfield_N:
     string_builder_append(&builder, "Cannot read field \"%.*s\"", fmt_slice(faulting_insn->cp->field.nat->name));
     break;
   case insn_putfield:
-  case insn_putfield_B ... insn_putfield_L:
+  case insn_putfield_B ... insn_putfield_N:
     string_builder_append(&builder, "Cannot assign field \"%.*s\"", fmt_slice(faulting_insn->cp->field.nat->name));
     break;
   case insn_invokevirtual:
   case insn_invokeinterface:
   case insn_invokespecial:
   case insn_invokespecial_resolved:
+  case insn_invokevirtual_direct:
   case insn_invokeitable_monomorphic:
   case insn_invokeitable_polymorphic:
   case insn_invokevtable_monomorphic:
-  case insn_invokevtable_polymorphic: {
+  case insn_invokevtable_polymorphic:
+  case insn_invokevtable_pic:
+  case insn_invokeitable_pic:
+  case insn_get_class: {
     cp_method_info *invoked = &faulting_insn->cp->methodref;
     string_builder_append(&builder, "Cannot invoke \"");
     npe_stringify_method(&builder, invoked);
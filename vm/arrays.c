@@ -103,6 +103,7 @@ classdesc *make_array_classdesc(vm_thread *thread, classdesc *classdesc) {
     }
     classdesc->array_type->dtor = free_array_classdesc;
     classdesc->array_type->classloader = classdesc->classloader;
+    classdesc->array_type->unloadable = classdesc->unloadable;
   }
   return classdesc->array_type;
 }
@@ -118,7 +119,6 @@ static obj_header *create_1d_primitive_array(vm_thread *thread, type_kind array_
   obj_header *array = AllocateObject(thread, array_desc, allocation_size);
   if (array) {
     *(int *)((char *)array + kArrayLengthOffset) = count;
-    memset(ArrayData(array), 0, count * size);
   }
 
   DCHECK(size_of_object(array) == allocation_size);
@@ -133,11 +133,10 @@ static obj_header *create_1d_object_array(vm_thread *thread, classdesc *cd, int
   classdesc *array_desc = make_array_classdesc(thread, cd);
   DCHECK(array_desc);
 
-  size_t allocation_size = kArrayDataOffset + count * sizeof(object);
+  size_t allocation_size = kArrayDataOffset + count * sizeof(heap_ref);
   obj_header *array = AllocateObject(thread, array_desc, allocation_size);
   if (array) {
     *(int *)((char *)array + kArrayLengthOffset) = count;
-    memset(ArrayData(array), 0, count * sizeof(object));
   }
 
   DCHECK(!array || size_of_object(array) == allocation_size);
@@ -166,7 +165,7 @@ obj_header *CreateArray(vm_thread *thread, classdesc *desc, int const *dim_sizes
     obj_header *subarray = CreateArray(thread, desc->one_fewer_dim, dim_sizes + 1, total_dimensions - 1);
     if (!subarray)
       goto oom;
-    ReferenceArrayStore(arr->obj, i, subarray);
+    ReferenceArrayStore(thread, arr->obj, i, subarray);
   }
 
   result = arr->obj;
@@ -6,6 +6,7 @@
 #define ARRAYS_H
 
 #include "bjvm.h"
+#include "objects.h"
 #include <stdint.h>
 #include <types.h>
 
@@ -27,6 +28,15 @@ static int constexpr kArrayHeaderSize = kArrayDataOffset - sizeof(obj_header);
 
 static int constexpr kArrayMaxDimensions = 255;
 
+// Allocate a one-dimensional array of the given linked array class. The elements are zeroed.
+static inline object AllocateArray(vm_thread *thread, classdesc *array_desc, int count, size_t element_size) {
+  object array = AllocateObject(thread, array_desc, kArrayDataOffset + count * element_size);
+  if (array) {
+    *(int *)((char *)array + kArrayLengthOffset) = count;
+  }
+  return array;
+}
+
 static inline bool Is1DPrimitiveArray(obj_header *src) {
   return src->descriptor->kind == CD_KIND_PRIMITIVE_ARRAY && src->descriptor->dimensions == 1;
 }
@@ -43,14 +53,15 @@ static inline obj_header *ReferenceArrayLoad(obj_header *array, int index) {
   DCHECK(array->descriptor->kind == CD_KIND_ORDINARY_ARRAY);
   DCHECK(index >= 0 && index < ArrayLength(array));
 
-  return *((obj_header **)ArrayData(array) + index);
+  return load_ref((heap_ref *)ArrayData(array) + index);
 }
 
-static inline void ReferenceArrayStore(obj_header *array, int index, obj_header *val) {
+static inline void ReferenceArrayStore(vm_thread *thread, obj_header *array, int index, obj_header *val) {
   DCHECK(array->descriptor->kind == CD_KIND_ORDINARY_ARRAY);
   DCHECK(index >= 0 && index < ArrayLength(array));
 
-  *((obj_header **)ArrayData(array) + index) = val;
+  store_ref((heap_ref *)ArrayData(array) + index, val);
+  gc_write_barrier(thread->vm, array);
 }
 
 static inline void ByteArrayStoreBlock(object array, s32 offset, s32 length, u8 const *data) {
@@ -17,7 +17,8 @@ EMSCRIPTEN_KEEPALIVE
 vm *ffi_create_vm(const char *classpath, size_t heap_size, write_bytes stdout_, write_bytes stderr_) {
   vm_options options = default_vm_options();
   options.classpath = (slice){.chars = (char *)classpath, .len = (int)strlen(classpath)};
-  options.heap_size = heap_size;
+  if (heap_size)
+    options.max_heap_size = heap_size;
   options.write_stdout = stdout_;
   options.write_stderr = stderr_;
   options.stdio_override_param = nullptr;
@@ -185,7 +186,7 @@ uintptr_t ffi_get_element_ptr(vm_thread *thread, object obj, int index) {
     return 0;
   }
   if (obj->descriptor->kind == CD_KIND_ORDINARY_ARRAY) {
-    return (uintptr_t)((object *)ArrayData(obj) + index);
+    return (uintptr_t)((heap_ref *)ArrayData(obj) + index);
   }
   return (uintptr_t)ArrayData(obj) + index * sizeof_type_kind(obj->descriptor->primitive_component);
 }
@@ -8,6 +8,7 @@
 #include <wchar.h>
 #include <zlib.h>
 
+#include "allocation_profiler.h"
 #include "analysis.h"
 #include "arrays.h"
 #include "objects.h"
@@ -15,6 +16,7 @@
 #include <config.h>
 #include <exceptions.h>
 #include <gc.h>
+#include <heap_dump.h>
 #include <reflection.h>
 
 #include "cached_classdescs.h"
@@ -93,7 +95,7 @@ bool has_expanded_data(header_word *data) { return !((uintptr_t)data->expanded_d
 mark_word_t *get_mark_word(vm *vm, header_word *data) {
   mark_word_t *word = has_expanded_data(data) ? &data->expanded_data->mark_word : &data->mark_word;
 #if DCHECKS_ENABLED
-  if (!in_heap(vm, (void *)word)) {
+  if (!has_expanded_data(data) && !in_heap(vm, (void *)word)) {
     // Data got corrupted. Print out information
     fprintf(stderr, "Corrupted mark word: %p at %p (expanded data: %d)\n", word, data, has_expanded_data(data));
     fprintf(stderr, "Surrounding bytes (-16 to +16): ");
@@ -111,8 +113,7 @@ monitor_data *inspect_monitor(header_word *data) { return has_expanded_data(data
 
 monitor_data *allocate_monitor_for(vm_thread *thread, obj_header *obj) {
   CHECK(in_heap(thread->vm, obj)); // if you're synchronizing on staticFieldBase, you deserve the chair
-  monitor_data *data = bump_allocate(thread, sizeof(monitor_data));
-  return data;
+  return allocate_monitor(thread->vm);
 }
 
 #define MAX_CF_NAME_LENGTH 1000
@@ -344,7 +345,8 @@ stack_frame *push_plain_frame(vm_thread *thread, cp_method *method, stack_value
 stack_frame *push_frame(vm_thread *thread, cp_method *method, stack_value *args, u8 argc) {
   DCHECK(method != nullptr, "Method is null");
   DCHECK(argc == method_argc(method), "Wrong argc");
-  if (method->access_flags & ACCESS_NATIVE) {
+  // Natives declared with DECLARE_INTRINSIC_NATIVE replace the bytecode of non-native methods
+  if (method->access_flags & ACCESS_NATIVE || unlikely(method->native_handle)) {
     return push_native_frame(thread, method, method->descriptor, args, argc);
   }
   return push_plain_frame(thread, method, args, argc);
@@ -568,7 +570,8 @@ static slice get_default_boot_cp() {
 
 vm_options default_vm_options() {
   vm_options options = {nullptr};
-  options.heap_size = 1 << 26;
+  options.initial_heap_size = 1 << 22;
+  options.max_heap_size = (size_t)1 << (sizeof(void *) == 8 ? 32 : 29);
   options.runtime_classpath = get_default_boot_cp();
 
   return options;
@@ -633,16 +636,32 @@ vm *create_vm(const vm_options options) {
   vm->classes = make_hash_table(free_classdesc, 0.75, 16);
   vm->inchoate_classes = make_hash_table(nullptr, 0.75, 16);
   vm->natives = make_hash_table(free_native_entries, 0.75, 16);
-  vm->interned_strings = make_hash_table(nullptr, 0.75, 16);
   vm->class_padding = make_hash_table(nullptr, 0.75, 16);
   vm->modules = make_hash_table(free, 0.75, 16);
   vm->main_thread_group = nullptr;
 
-  vm->heap = aligned_alloc(4096, options.heap_size);
   vm->heap_used = 0;
-  vm->heap_capacity = options.heap_size;
+  vm->max_heap_capacity = options.max_heap_size;
+  vm->min_heap_capacity = options.initial_heap_size < vm->max_heap_capacity ? options.initial_heap_size
+                                                                             : vm->max_heap_capacity;
+  vm->heap_capacity = vm->min_heap_capacity;
   vm->true_heap_capacity = vm->heap_capacity + OOM_SLOP_BYTES;
+  if (init_heap(vm)) {
+    fprintf(stderr, "Failed to reserve the heap");
+    free(vm);
+    return nullptr;
+  }
   vm->active_threads = nullptr;
+  vm->eliding_locks = true;
+  vm->gc_threads = options.gc_threads > 1 ? options.gc_threads : 1;
+  vm->gc_pause_budget_us = options.gc_pause_budget_us;
+  vm->heap_dump_path = options.heap_dump_path ? strdup(options.heap_dump_path) : nullptr;
+  if (init_generational_heap(vm, options.nursery_size)) {
+    fprintf(stderr, "Failed to allocate the card table");
+    release_heap(vm);
+    free(vm);
+    return nullptr;
+  }
 
   vm->read_stdin = options.read_stdin;
   vm->poll_available_stdin = options.poll_available_stdin;
@@ -695,10 +714,13 @@ void free_zstreams(vm *vm) {
 }
 
 void free_vm(vm *vm) {
+  free(finish_allocation_profiler(vm->allocation_profiler));
   free_hash_table(vm->classes);
+  arrfree(vm->unloadable_classes);
+  arrfree(vm->classes_caching_unloadable);
   free_hash_table(vm->natives);
   free_hash_table(vm->inchoate_classes);
-  free_hash_table(vm->interned_strings);
+  free(vm->interned_strings.entries);
   free_hash_table(vm->class_padding);
   free_hash_table(vm->modules);
 
@@ -716,9 +738,13 @@ void free_vm(vm *vm) {
     free_thread(vm->active_threads[i]);
   }
   arrfree(vm->active_threads);
-  free(vm->heap);
+  release_heap(vm);
+  free_generational_heap(vm);
+  free_monitor_pool(vm);
+  arrfree(vm->elided_locks);
   free_unsafe_allocations(vm);
   free_zstreams(vm);
+  free(vm->heap_dump_path);
 
   free(vm);
 }
@@ -775,8 +801,18 @@ __attribute__((noinline)) cp_field *field_lookup(classdesc *classdesc, slice con
 
 obj_header *get_main_thread_group(vm_thread *thread);
 
-void set_field(obj_header *obj, cp_field *field, stack_value stack_value) {
-  store_stack_value((void *)obj + field->byte_offset, stack_value, field->parsed_descriptor.repr_kind);
+// Whether the given instance field holds a heap_ref rather than a pointer
+static bool is_narrow_instance_field(const cp_field *field) {
+  return field->my_class->compressed_fields && field->parsed_descriptor.repr_kind == TYPE_KIND_REFERENCE;
+}
+
+void set_field(vm_thread *thread, obj_header *obj, cp_field *field, stack_value stack_value) {
+  if (is_narrow_instance_field(field))
+    store_ref((void *)obj + field->byte_offset, stack_value.obj);
+  else
+    store_stack_value((void *)obj + field->byte_offset, stack_value, field->parsed_descriptor.repr_kind);
+  if (field->parsed_descriptor.repr_kind == TYPE_KIND_REFERENCE)
+    gc_write_barrier(thread->vm, obj);
 }
 
 void set_static_field(cp_field *field, stack_value stack_value) {
@@ -785,6 +821,8 @@ void set_static_field(cp_field *field, stack_value stack_value) {
 }
 
 stack_value get_field(obj_header *obj, cp_field *field) {
+  if (is_narrow_instance_field(field))
+    return (stack_value){.obj = load_ref((void *)obj + field->byte_offset)};
   return load_stack_value((void *)obj + field->byte_offset, field->parsed_descriptor.repr_kind);
 }
 
@@ -810,13 +848,20 @@ static void init_unsafe_constants(vm_thread *thread) {
   set_static_field(unaligned_access, (stack_value){.i = 1});
 }
 
+static void add_thread_to_vm_list(vm_thread *thread) {
+  if (arrlen(thread->vm->active_threads) == 1)
+    stop_eliding_locks(thread->vm); // the existing thread's locks must now be visible to the new one
+  arrput(thread->vm->active_threads, thread);
+}
+
 #define PROFILE_STARTUP 0 // if 1, prints out profiler data for startup
 
 vm_thread *create_main_thread(vm *vm, thread_options options) {
   vm_thread *thr = calloc(1, sizeof(vm_thread));
-  arrput(vm->active_threads, thr);
-
   thr->vm = vm;
+  add_thread_to_vm_list(thr);
+  if (vm->allocation_profiler)
+    thr->bytes_until_sample = next_sample_distance(vm->allocation_profiler);
   thr->stack.frame_buffer = calloc(1, thr->stack.frame_buffer_capacity = options.stack_space);
   thr->stack.frame_buffer_end = thr->stack.frame_buffer + options.stack_space;
   thr->js_jit_enabled = options.js_jit_enabled;
@@ -855,6 +900,7 @@ vm_thread *create_main_thread(vm *vm, thread_options options) {
   java_thr->eetop = (uintptr_t)thr;
   object name = MakeJStringFromCString(thr, "main", true);
   java_thr->name = name;
+  gc_write_barrier(vm, java_thread->obj);
 
   // Call (Ljava/lang/ThreadGroup;Ljava/lang/String;)V
   cp_method *make_thread = method_lookup(cached_classes(vm)->thread, STR("<init>"),
@@ -932,9 +978,10 @@ vm_thread *create_vm_thread(vm *vm, vm_thread *creator_thread, struct native_Thr
   handle *java_thread = make_handle(creator_thread, (obj_header *)thread_obj);
 
   vm_thread *thr = calloc(1, sizeof(vm_thread));
-  arrput(vm->active_threads, thr);
-
   thr->vm = vm;
+  add_thread_to_vm_list(thr);
+  if (vm->allocation_profiler)
+    thr->bytes_until_sample = next_sample_distance(vm->allocation_profiler);
   thr->stack.frame_buffer = calloc(1, thr->stack.frame_buffer_capacity = options.stack_space);
   thr->stack.frame_buffer_end = thr->stack.frame_buffer + options.stack_space;
   thr->js_jit_enabled = options.js_jit_enabled;
@@ -1017,6 +1064,8 @@ static void remove_thread_from_vm_list(vm_thread *thread) {
       break;
     }
   }
+  if (arrlen(thread->vm->active_threads) == 1)
+    thread->vm->eliding_locks = true; // only one thread left to lock anything
 }
 
 void free_thread(vm_thread *thread) {
@@ -1051,7 +1100,7 @@ struct native_MethodType *resolve_method_type(vm_thread *thread, method_descript
     if (!arg_desc)
       return nullptr;
     object mirror = (void *)get_class_mirror(thread, arg_desc);
-    *((struct native_Class **)ArrayData(ptypes->obj) + i) = (void *)mirror;
+    ReferenceArrayStore(thread, ptypes->obj, i, mirror);
   }
 
   classdesc *ret_desc = load_class_of_field_descriptor(thread, method->return_type.unparsed);
@@ -1174,7 +1223,7 @@ DEFINE_ASYNC(resolve_mh_mt) {
       args->thread, CreateObjectArray1D(args->thread, cached_classes(args->thread->vm)->klass, info.ptypes_count));
   for (u32 i = 0; i < info.ptypes_count; ++i) {
     object mirror = (void *)get_class_mirror(args->thread, info.ptypes[i]);
-    *((obj_header **)ArrayData(self->ptypes_array->obj) + i) = mirror;
+    ReferenceArrayStore(args->thread, self->ptypes_array->obj, i, mirror);
   }
   arrfree(info.ptypes);
 
@@ -1408,7 +1457,8 @@ classdesc *define_bootstrap_class(vm_thread *thread, slice chars, const u8 *clas
         cp_method *method = class->methods + j;
 
         if (utf8_equals_utf8(method->name, entry->name) &&
-            utf8_equals_utf8(method->unparsed_descriptor, entry->descriptor)) {
+            utf8_equals_utf8(method->unparsed_descriptor, entry->descriptor) &&
+            (method->access_flags & ACCESS_NATIVE || entry->callback.replaces_bytecode)) {
 //          printf("Successfully bound method %.*s on class %.*s\n", fmt_slice(entry->name), fmt_slice(chars));
           method->native_handle = &entry->callback;
           goto done;
@@ -1440,6 +1490,22 @@ error_1:
   return nullptr;
 }
 
+void make_class_unloadable(vm *vm, classdesc *classdesc, bool kept_by_loader) {
+  DCHECK(classdesc->kind == CD_KIND_ORDINARY && !classdesc->unloadable);
+  classdesc->unloadable = true;
+  classdesc->kept_by_loader = kept_by_loader;
+  for (struct classdesc *array = classdesc->array_type; array; array = array->array_type)
+    array->unloadable = true;
+  arrput(vm->unloadable_classes, classdesc);
+}
+
+void note_cached_class(vm *vm, classdesc *caller, const classdesc *cached) {
+  if (cached->unloadable && !caller->caches_unloadable) {
+    caller->caches_unloadable = true;
+    arrput(vm->classes_caching_unloadable, caller);
+  }
+}
+
 void dump_trace(vm_thread *thread) {
   // Walk frames and print the method/line number
   stack_frame *frame = thread->stack.top;
@@ -1559,6 +1625,14 @@ void out_of_memory(vm_thread *thread) {
     return;
   }
 
+  if (vm->heap_dump_path) {
+    if (write_heap_dump(vm, vm->heap_dump_path))
+      fprintf(stderr, "Failed to write heap dump to %s\n", vm->heap_dump_path);
+    // Only the first OutOfMemoryError is dumped
+    free(vm->heap_dump_path);
+    vm->heap_dump_path = nullptr;
+  }
+
   // temporarily expand the valid heap so that we can allocate the OOM error and
   // its constituents
   size_t original_capacity = vm->heap_capacity;
@@ -1571,24 +1645,120 @@ void out_of_memory(vm_thread *thread) {
   vm->heap_capacity = original_capacity;
 }
 
-void *bump_allocate(vm_thread *thread, size_t bytes) {
+// Objects at least 1/PRETENURE_FRACTION of the nursery are allocated directly in the compacting space.
+#define PRETENURE_FRACTION 4
+
+// Bump-allocate between min and max bytes in the nursery (if young) or the compacting space, returning how much was
+// taken in *reserved, or nullptr if even min bytes aren't free.
+static u8 *reserve_space(vm *vm, bool young, size_t min, size_t max, size_t *reserved) {
+  DCHECK(vm->heap_used % 8 == 0);
+  size_t *used = young ? &vm->nursery_used : &vm->heap_used;
+  size_t base = young ? vm->nursery_start : 0;
+  size_t limit = young || !vm->nursery_capacity ? vm->heap_capacity : vm->nursery_start;
+  size_t available = limit - base - *used;
+  if (available < min)
+    return nullptr;
+  *reserved = available < max ? available : max;
+  u8 *result = vm->heap + base + *used;
+  *used += *reserved;
+  return result;
+}
+
+static void *compacting_space_allocate(vm *vm, size_t bytes) {
+  size_t reserved;
+  return reserve_space(vm, false, bytes, bytes, &reserved);
+}
+
+static void *nursery_allocate(vm *vm, size_t bytes) {
+  size_t reserved;
+  return reserve_space(vm, true, bytes, bytes, &reserved);
+}
+
+static void *heap_allocate(vm_thread *thread, size_t bytes) {
   // round up to multiple of 8
   bytes = align_up(bytes, 8);
   vm *vm = thread->vm;
-  DCHECK(vm->heap_used % 8 == 0);
-  if (vm->heap_used + bytes > vm->heap_capacity) {
-    major_gc(thread->vm);
-    if (vm->heap_used + bytes > vm->heap_capacity) {
-      out_of_memory(thread);
-      return nullptr;
-    }
+  bool young = bytes < vm->nursery_capacity / PRETENURE_FRACTION;
+  void *result = young ? nursery_allocate(vm, bytes) : compacting_space_allocate(vm, bytes);
+  if (!result && young && minor_gc(vm) == 0) {
+    result = nursery_allocate(vm, bytes);
+  }
+  // Collect everything, and as a last resort before throwing OutOfMemoryError, free softly reachable objects too
+  for (int attempt = 0; !result && attempt < 2; ++attempt) {
+    major_gc_for_allocation(vm, young ? 0 : bytes, attempt == 1);
+    result = young ? nursery_allocate(vm, bytes) : nullptr;
+    if (!result)
+      result = compacting_space_allocate(vm, bytes);
+  }
+  if (!result) {
+    out_of_memory(thread);
+    return nullptr;
   }
-  void *result = vm->heap + vm->heap_used;
-  memset(result, 0, bytes);
-  vm->heap_used += bytes;
+  if (!in_nursery(vm, result)) {
+    record_object_start(vm, result);
+  }
+  DCHECK(heap_is_zeroed(result, bytes));
   return result;
 }
 
+// Size of the thread-local allocation buffers. Objects over a quarter of this are allocated in the shared heap.
+#define TLAB_BYTES (1 << 14)
+
+void retire_tlab(vm_thread *thread) {
+  // The unused part of the buffer doesn't count towards the next allocation sample
+  thread->bytes_until_sample += thread->tlab_end - thread->tlab_top;
+  thread->tlab_top = thread->tlab_end = thread->tlab_limit = nullptr;
+}
+
+// Allocate from [top, limit) until further notice, lowering the end of the TLAB to the next allocation sample
+static void start_tlab(vm_thread *thread, u8 *top, u8 *limit) {
+  thread->tlab_top = top;
+  thread->tlab_end = thread->tlab_limit = limit;
+  if (thread->vm->allocation_profiler) {
+    if (thread->bytes_until_sample < (size_t)(limit - top)) {
+      thread->tlab_end = top + thread->bytes_until_sample;
+      thread->bytes_until_sample = 0;
+    } else {
+      thread->bytes_until_sample -= limit - top;
+    }
+  }
+}
+
+void *bump_allocate_slow(vm_thread *thread, classdesc *descriptor, size_t bytes) {
+  vm *vm = thread->vm;
+  if (vm->allocation_profiler) {
+    // Sample this allocation if it reaches the next sample, then let the TLAB continue past the lowered end
+    u8 *top = thread->tlab_top, *limit = thread->tlab_limit;
+    size_t until_sample = thread->tlab_end - top + thread->bytes_until_sample;
+    thread->bytes_until_sample = until_sample < bytes ? sample_allocation(thread, descriptor, bytes, until_sample)
+                                                      : until_sample - bytes;
+    if ((size_t)(limit - top) >= bytes) {
+      start_tlab(thread, top + bytes, limit);
+      return top;
+    }
+    start_tlab(thread, top, limit);
+  }
+
+  // TLABs come out of the nursery if there is one, so they must only hold objects small enough to live there
+  size_t tlab_bytes = TLAB_BYTES;
+  if (vm->nursery_capacity && tlab_bytes > vm->nursery_capacity / PRETENURE_FRACTION)
+    tlab_bytes = vm->nursery_capacity / PRETENURE_FRACTION & ~(size_t)7;
+
+  // While an OutOfMemoryError is being thrown, allocate exactly what is needed from the slop
+  if (bytes <= tlab_bytes / 4 && vm->heap_capacity != vm->true_heap_capacity) {
+    size_t reserved;
+    u8 *tlab = reserve_space(vm, vm->nursery_capacity != 0, bytes, tlab_bytes, &reserved);
+    if (tlab) {
+      DCHECK(heap_is_zeroed(tlab, reserved));
+      retire_tlab(thread);
+      start_tlab(thread, tlab + bytes, tlab + reserved);
+      return tlab;
+    }
+  }
+  // Too big for a TLAB, or time to collect garbage (which retires every TLAB)
+  return heap_allocate(thread, bytes);
+}
+
 // Returns true if the class descriptor is a subclass of java.lang.Error.
 // NOLINTNEXTLINE(misc-no-recursion)
 bool is_error(classdesc *d) {
@@ -2106,12 +2276,7 @@ struct native_Class *get_class_mirror(vm_thread *thread, classdesc *cd) {
 }
 
 bool instanceof_interface(const classdesc *o, const classdesc *target) {
-  if (o == target)
-    return true;
-  for (int i = 0; i < arrlen(o->itables.interfaces); ++i)
-    if (o->itables.interfaces[i] == target)
-      return true;
-  return false;
+  return o == target || itable_find(o, target) >= 0;
 }
 
 bool instanceof_super(const classdesc *o, const classdesc *target) {
@@ -2170,8 +2335,8 @@ bool method_types_compatible(struct native_MethodType *provider_mt, struct nativ
     return false;
   }
   for (int i = 0; i < ArrayLength(provider_mt->ptypes); ++i) {
-    classdesc *left = unmirror_class(((obj_header **)ArrayData(provider_mt->ptypes))[i]);
-    classdesc *right = unmirror_class(((obj_header **)ArrayData(targ->ptypes))[i]);
+    classdesc *left = unmirror_class(ReferenceArrayLoad(provider_mt->ptypes, i));
+    classdesc *right = unmirror_class(ReferenceArrayLoad(targ->ptypes, i));
 
     if (left != right) {
       return false;
@@ -2184,7 +2349,7 @@ bool method_types_compatible(struct native_MethodType *provider_mt, struct nativ
 [[maybe_unused]] static void dump_method_type(FILE *stream, struct native_MethodType *type) {
   fprintf(stream, "(");
   for (int i = 0; i < ArrayLength(type->ptypes); ++i) {
-    classdesc *desc = unmirror_class(((obj_header **)ArrayData(type->ptypes))[i]);
+    classdesc *desc = unmirror_class(ReferenceArrayLoad(type->ptypes, i));
     fprintf(stream, "%.*s", fmt_slice(desc->name));
     if (i + 1 < ArrayLength(type->ptypes))
       fprintf(stream, ", ");
@@ -2551,18 +2716,18 @@ DEFINE_ASYNC(indy_resolve) {
   for (; self->static_i < m->args_count; ++self->static_i) {
     cp_entry *arg = m->args[self->static_i];
     AWAIT(resolve_indy_static_argument, thread, arg);
-    ReferenceArrayStore(self->invoke_array->obj, self->static_i + 3,
+    ReferenceArrayStore(thread, self->invoke_array->obj, self->static_i + 3,
                         get_async_result(resolve_indy_static_argument).obj);
   }
 
   handle *name = make_handle(thread, MakeJStringFromModifiedUTF8(thread, indy->name_and_type->name, true));
   indy->resolved_mt = resolve_method_type(thread, indy->method_descriptor);
 
-  ReferenceArrayStore(self->invoke_array->obj, 0, lookup_handle->obj);
+  ReferenceArrayStore(thread, self->invoke_array->obj, 0, lookup_handle->obj);
   drop_handle(thread, lookup_handle);
-  ReferenceArrayStore(self->invoke_array->obj, 1, name->obj);
+  ReferenceArrayStore(thread, self->invoke_array->obj, 1, name->obj);
   drop_handle(thread, name);
-  ReferenceArrayStore(self->invoke_array->obj, 2, (void *)indy->resolved_mt);
+  ReferenceArrayStore(thread, self->invoke_array->obj, 2, (void *)indy->resolved_mt);
 
   // Invoke the bootstrap method using invokeWithArguments
   cp_method *invokeWithArguments = method_lookup(self->bootstrap_handle->obj->descriptor, STR("invokeWithArguments"),
@@ -108,6 +108,8 @@ typedef struct {
     sync_native_callback sync;
     async_native_callback async;
   };
+  // Also bind to (and replace) a method implemented in bytecode, rather than only to a native method
+  bool replaces_bytecode;
 } native_callback;
 
 // represents a native method somewhere in this binary
@@ -119,6 +121,7 @@ typedef struct {
 } native_t;
 
 //      struct { flags, hash? }
+// The bits of the flags word above mark_word_flags hold a thin lock, if any (see monitors.c)
 typedef struct {
   u32 data[2];
 } mark_word_t;
@@ -143,6 +146,49 @@ typedef struct obj_header {
   classdesc *descriptor;
 } obj_header;
 
+#if COMPRESSED_REFS
+// A reference stored in the heap: reference array elements, and the reference fields of classes laid out by the VM
+// (see classdesc.compressed_fields). Compressed, it is the offset of the object from compressed_heap_base in units of
+// 8 bytes, or 0 for null. Every heap, along with the static field memory which Unsafe hands out as the base of static
+// fields, is carved out of a single address range starting there (see gc.c).
+typedef u32 heap_ref;
+extern u8 *compressed_heap_base;
+
+static inline object decode_ref(heap_ref ref) {
+  return ref ? (object)(compressed_heap_base + ((uintptr_t)ref << 3)) : nullptr;
+}
+
+static inline heap_ref encode_ref(object obj) {
+  return obj ? (heap_ref)(((u8 *)obj - compressed_heap_base) >> 3) : 0;
+}
+#else
+typedef object heap_ref;
+
+static inline object decode_ref(heap_ref ref) { return ref; }
+static inline heap_ref encode_ref(object obj) { return obj; }
+#endif
+
+static inline object load_ref(const void *slot) { return decode_ref(*(const heap_ref *)slot); }
+static inline void store_ref(void *slot, object obj) { *(heap_ref *)slot = encode_ref(obj); }
+
+// Load or store a reference slot which holds either a heap_ref or, if not narrow, a plain pointer
+static inline object load_ref_slot(const void *slot, bool narrow) {
+  return narrow ? load_ref(slot) : *(const object *)slot;
+}
+
+static inline void store_ref_slot(void *slot, bool narrow, object obj) {
+  if (narrow)
+    store_ref(slot, obj);
+  else
+    *(object *)slot = obj;
+}
+
+// Address of the i-th instance reference field of an object of the given class (see instance_references)
+static inline void *instance_ref_slot(const classdesc *desc, object obj, u32 i) {
+  return (u8 *)obj + desc->instance_references->slots_unscaled[i] * (desc->compressed_fields ? sizeof(heap_ref)
+                                                                                               : sizeof(object));
+}
+
 typedef enum : u32 {
   IS_MARK_WORD = 1 << 0,
   IS_REACHABLE = 1 << 1,
@@ -325,12 +371,30 @@ typedef struct {
   size_t len;
 } mmap_allocation;
 
+// Open-addressed table of interned strings, keyed by their contents. The strings are held weakly: the GC removes
+// those which are otherwise unreachable, leaving a tombstone (see objects.c).
+typedef struct {
+  struct interned_string {
+    object string; // null if the slot was never used, INTERNED_TOMBSTONE if its string was removed
+    u32 hash;
+  } *entries;
+  u32 capacity; // a power of two, or 0
+  u32 used;     // slots which aren't null, including tombstones
+} intern_table;
+
+#define INTERNED_TOMBSTONE ((object)(uintptr_t)1)
+
 struct cached_classdescs;
 typedef struct vm {
   // Map class name (e.g. "java/lang/String") to classdesc*
   string_hash_table classes;
   // Classes currently under creation -- used to detect circularity
   string_hash_table inchoate_classes;
+  // Classes which may be unloaded once unreachable: those defined by a class loader, and weak hidden classes
+  classdesc **unloadable_classes;
+  // Classes with inline caches or devirtualized calls that refer to unloadable classes, which the GC fixes up before
+  // unloading those. Whether or not a class with the same name has since replaced them in 'classes'.
+  classdesc **classes_caching_unloadable;
 
   // Native methods in javah form
   string_hash_table natives;
@@ -341,8 +405,8 @@ typedef struct vm {
   // Main thread group
   obj_header *main_thread_group;
 
-  // Interned strings (string -> instance of java/lang/String)
-  string_hash_table interned_strings;
+  // Interned strings (contents -> instance of java/lang/String)
+  intern_table interned_strings;
 
   // Classes with implementation-required padding before other fields (map class
   // name -> padding bytes)
@@ -382,6 +446,60 @@ typedef struct vm {
   // bjvm.c.
   size_t true_heap_capacity;
 
+  // Adaptive sizing: after each major GC, heap_capacity moves between these bounds depending on how much of the heap
+  // is live and how much time is being spent collecting it.
+  size_t min_heap_capacity;
+  size_t max_heap_capacity;
+  // Bytes of address space set aside for the heap, enough for the maximum capacity plus the OOM slop
+  size_t heap_reservation;
+  // Microseconds spent in minor GCs since the last major GC, and when the last major GC finished
+  u64 minor_gc_us;
+  u64 last_major_gc_end_us;
+
+  // Generational collection. If enabled, small objects are bump-allocated in the nursery, the region
+  // [nursery_start, heap_capacity) at the top of the heap, and objects surviving a minor collection are promoted into
+  // the compacting space [0, nursery_start). nursery_capacity is 0 if generational collection is disabled.
+  size_t nursery_capacity;
+  size_t nursery_start;
+  size_t nursery_used;
+
+  // One byte per CARD_BYTES of the compacting space, nonzero if an object starting in that card may refer to an object
+  // in the nursery. Set by gc_write_barrier.
+  u8 *card_table;
+  // One bit per 8 bytes of the compacting space, set where an object begins. Used to find the objects in a dirty card.
+  u64 *object_starts;
+  // Pool of inflated monitors (see monitors.c)
+  struct monitor_slot **monitor_chunks;
+  struct monitor_slot *free_monitors;
+  // While the VM has a single thread, locking an object only counts holds here, and nothing is written to the object.
+  // The holds are moved to the objects when a second thread is created (see monitors.c).
+  bool eliding_locks;
+  struct elided_lock {
+    object obj;
+    u32 hold_count;
+  } *elided_locks;
+#if COMPRESSED_REFS
+  // Memory for the static fields of classes, bump-allocated from a range of the compressed reference region and
+  // committed as it fills
+  u8 *static_field_area;
+  size_t static_field_area_used;
+#endif
+  // Number of threads doing a major GC (1 for a serial collection)
+  int gc_threads;
+  // If nonzero, major GCs mark incrementally in slices of about this many microseconds between scheduler steps
+  u64 gc_pause_budget_us;
+  // State of a major GC which is marking incrementally, or null
+  struct gc_ctx *incremental_mark;
+  // Where to dump the heap when an OutOfMemoryError is first thrown, or null
+  char *heap_dump_path;
+  // Sampler of the allocations of every thread, or null (see allocation_profiler.h)
+  struct allocation_profiler *allocation_profiler;
+
+  // References cleared by the GC, linked through their 'discovered' fields, for the ReferenceHandler thread to enqueue
+  object reference_pending_list;
+  // Set when the heap is nearly full at its maximum size, so that the next major GC clears softly reachable objects
+  bool clear_soft_references;
+
   // Handles referenced from JS
   obj_header **js_handles;
 
@@ -431,8 +549,21 @@ typedef struct {
   // Passed to write_stdout/write_stderr/read_stdin
   void *stdio_override_param;
 
-  // Heap size (static for now)
-  size_t heap_size;
+  // The heap starts out at the initial size and grows as needed, up to the maximum size
+  size_t initial_heap_size;
+  size_t max_heap_size;
+  // Size of the nursery, carved out of the top of the heap. 0 disables generational collection. Native code which
+  // stores references into objects it holds across an allocation must call gc_write_barrier when this is enabled.
+  size_t nursery_size;
+  // Number of threads to mark and compact with during a major GC. 0 or 1 collects serially; ignored if the platform
+  // lacks threads.
+  int gc_threads;
+  // If nonzero, major GCs mark the heap a slice of at most about this many microseconds at a time, interleaved with
+  // rr_scheduler_step, and only pause for the final remark and compaction. Requires a nursery, whose write barrier
+  // tracks what the program changes while marking; ignored without one.
+  u64 gc_pause_budget_us;
+  // If set, the heap is dumped to this file in HPROF format the first time an OutOfMemoryError is thrown
+  const char *heap_dump_path;
   // Classpath for built-in files, e.g. rt.jar. Must have definitions for
   // Object.class, etc.
   slice runtime_classpath;
@@ -501,6 +632,9 @@ value *get_native_args(const stack_frame *frame); // same as locals, just called
 
 stack_value *frame_stack(stack_frame *frame);
 stack_value interpret_2(future_t *fut, vm_thread *thread, stack_frame *frame);
+// Make an invokevirtual or invokeinterface inline cache (monomorphic or a PIC) use vtable/itable dispatch, e.g. because
+// a receiver class it caches is being unloaded
+void make_invoke_polymorphic(bytecode_insn *insn);
 
 native_frame *get_native_frame_data(stack_frame *frame);
 cp_method *get_frame_method(stack_frame *frame);
@@ -565,6 +699,16 @@ typedef struct vm_thread {
   // Handle for null
   handle null_handle;
 
+  // Thread-local allocation buffer: small objects are bump-allocated from [tlab_top, tlab_end), which is carved out
+  // of the nursery (or the compacting space, if there is no nursery) and zeroed in advance. Retired by every GC.
+  u8 *tlab_top;
+  u8 *tlab_end;
+  // The real end of the TLAB. While allocations are being sampled, tlab_end is lowered to where the next sample is due
+  // if that's within the buffer.
+  u8 *tlab_limit;
+  // While allocations are being sampled, the bytes to allocate past tlab_end before the next sample
+  size_t bytes_until_sample;
+
   int allocations_so_far;
   // This value is used to periodically check whether we should yield back to the scheduler ...
   u32 fuel;
@@ -645,6 +789,11 @@ void free_vm(vm *vm);
 classdesc *bootstrap_lookup_class(vm_thread *thread, slice name);
 classdesc *bootstrap_lookup_class_impl(vm_thread *thread, slice name, bool raise_class_not_found);
 classdesc *define_bootstrap_class(vm_thread *thread, slice chars, const u8 *classfile_bytes, size_t classfile_len);
+// Let the GC unload the class once it's unreachable. If kept_by_loader, its class loader being reachable suffices.
+void make_class_unloadable(vm *vm, classdesc *classdesc, bool kept_by_loader);
+// Note that a call in the caller's code now caches the given class, as a receiver class or the class of a devirtualized
+// target, so that the call is fixed up if that class is unloaded
+void note_cached_class(vm *vm, classdesc *caller, const classdesc *cached);
 cp_method *method_lookup(classdesc *classdesc, const slice name, const slice descriptor, bool superclasses,
                          bool superinterfaces);
 
@@ -658,7 +807,8 @@ cp_field **unmirror_field(obj_header *mirror);
 cp_method *unmirror_method(obj_header *mirror);
 cp_method *unmirror_ctor(obj_header *mirror);
 
-void set_field(obj_header *obj, cp_field *field, stack_value stack_value);
+// Store to an instance field, with the GC write barrier if it is a reference
+void set_field(vm_thread *thread, obj_header *obj, cp_field *field, stack_value stack_value);
 void set_static_field(cp_field *field, stack_value stack_value);
 int resolve_field(vm_thread *thread, cp_field_info *info);
 stack_value get_field(obj_header *obj, cp_field *field);
@@ -710,7 +860,21 @@ static inline stack_value *frame_locals(const stack_frame *frame) {
 
 classdesc *primitive_classdesc(vm_thread *thread, type_kind prim_kind);
 void out_of_memory(vm_thread *thread);
-void *bump_allocate(vm_thread *thread, size_t bytes);
+void *bump_allocate_slow(vm_thread *thread, classdesc *descriptor, size_t bytes);
+// Give up the rest of the thread's TLAB, so that it starts a new one at its next allocation
+void retire_tlab(vm_thread *thread);
+
+// Allocate zeroed memory for an object of the given class. Returns nullptr, with an OutOfMemoryError raised, if the
+// heap is exhausted.
+static inline void *bump_allocate(vm_thread *thread, classdesc *descriptor, size_t bytes) {
+  bytes = align_up(bytes, 8);
+  u8 *result = thread->tlab_top;
+  if (likely((size_t)(thread->tlab_end - result) >= bytes)) {
+    thread->tlab_top = result + bytes;
+    return result;
+  }
+  return bump_allocate_slow(thread, descriptor, bytes);
+}
 
 #ifdef __cplusplus
 }
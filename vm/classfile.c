@@ -53,7 +53,10 @@ type_kind read_type_kind_char(char c) {
 
 char type_kind_to_char(type_kind kind) { return "ZCFDBSIJVL"[kind]; }
 
-void free_method(cp_method *method) { free_code_analysis(method->code_analysis); }
+void free_method(cp_method *method) {
+  free_code_analysis(method->code_analysis);
+  arrfree(method->devirtualized_calls);
+}
 
 void free_classfile(classdesc cf) {
   for (int i = 0; i < cf.methods_count; ++i)
@@ -501,6 +504,18 @@ bytecode_insn parse_tableswitch_insn(cf_byteslice *reader, int pc, classfile_par
   return (bytecode_insn){.kind = insn_tableswitch, .original_pc = original_pc, .tableswitch = data};
 }
 
+struct lookupswitch_pair {
+  int key, target, position;
+};
+
+// Orders lookupswitch pairs by key, keeping duplicate keys in the order they appeared
+static int cmp_lookupswitch_pairs(const void *a, const void *b) {
+  const struct lookupswitch_pair *x = a, *y = b;
+  if (x->key != y->key)
+    return x->key < y->key ? -1 : 1;
+  return x->position - y->position;
+}
+
 bytecode_insn parse_lookupswitch_insn(cf_byteslice *reader, int pc, classfile_parse_ctx *ctx) {
   int original_pc = pc++;
   while (pc % 4 != 0) {
@@ -523,6 +538,35 @@ bytecode_insn parse_lookupswitch_insn(cf_byteslice *reader, int pc, classfile_pa
     targets[i] = checked_pc(original_pc, reader_next_s32(reader, "lookupswitch target"), ctx);
   }
 
+  // The pairs should already be sorted by key, but we don't rely on it, since the interpreter binary searches them
+  struct lookupswitch_pair *pairs = malloc(pairs_count * sizeof(*pairs));
+  for (int i = 0; i < pairs_count; ++i)
+    pairs[i] = (struct lookupswitch_pair){.key = keys[i], .target = targets[i], .position = i};
+  qsort(pairs, pairs_count, sizeof(*pairs), cmp_lookupswitch_pairs);
+  bool has_duplicates = false;
+  for (int i = 0; i < pairs_count; ++i) {
+    keys[i] = pairs[i].key;
+    targets[i] = pairs[i].target;
+    has_duplicates |= i > 0 && keys[i] == keys[i - 1];
+  }
+  free(pairs);
+
+  // If the keys are dense enough, make it a tableswitch, with the gaps going to the default target. Not with duplicate
+  // keys, whose shadowed targets would then be unreachable to the analysis; the binary search finds the first listed.
+  s64 span = pairs_count ? (s64)keys[pairs_count - 1] - keys[0] + 1 : 0;
+  if (pairs_count >= 2 && span <= 2 * (s64)pairs_count && !has_duplicates) {
+    struct tableswitch_data *table = arena_alloc(ctx->arena, 1, sizeof(*table) + span * sizeof(int));
+    *table = (struct tableswitch_data){.default_target = default_target,
+                                       .low = keys[0],
+                                       .high = keys[pairs_count - 1],
+                                       .targets_count = (int)span};
+    for (int i = 0; i < span; ++i)
+      table->targets[i] = default_target;
+    for (int i = 0; i < pairs_count; ++i)
+      table->targets[keys[i] - keys[0]] = targets[i];
+    return (bytecode_insn){.kind = insn_tableswitch, .original_pc = original_pc, .tableswitch = table};
+  }
+
   struct lookupswitch_data *data = arena_alloc(ctx->arena, 1, sizeof(*data));
   *data = (struct lookupswitch_data){.default_target = default_target,
                                      .keys = keys,
@@ -209,7 +209,10 @@ typedef enum : u8 {
   insn_invokevtable_polymorphic, // slower vtable-based dispatch
   insn_invokeitable_monomorphic, // inline cache with previous object
   insn_invokeitable_polymorphic, // slower itable-based dispatch
+  insn_invokevtable_pic,         // polymorphic inline cache with a few previous objects
+  insn_invokeitable_pic,         // polymorphic inline cache with a few previous objects
   insn_invokespecial_resolved,   // resolved version of invokespecial
+  insn_invokevirtual_direct,     // invokevirtual of a method which no loaded class overrides
   insn_invokestatic_resolved,    // resolved version of invokestatic
   insn_invokecallsite,           // resolved version of invokedynamic
   insn_invokesigpoly,
@@ -224,6 +227,7 @@ typedef enum : u8 {
   insn_getfield_D,
   insn_getfield_Z,
   insn_getfield_L,
+  insn_getfield_N, // compressed reference (heap_ref)
 
   /** Resolved versions of putfield */
   insn_putfield_B,
@@ -235,6 +239,7 @@ typedef enum : u8 {
   insn_putfield_D,
   insn_putfield_Z,
   insn_putfield_L,
+  insn_putfield_N,
 
   /** Resolved versions of getstatic */
   insn_getstatic_B,
@@ -258,11 +263,65 @@ typedef enum : u8 {
   insn_putstatic_Z,
   insn_putstatic_L,
 
-  /** intrinsics understood by the interpreter */
-  insn_sqrt
+  /** intrinsics understood by the interpreter, which replace calls to the methods in the registry in linkage.c */
+  insn_sqrt,
+  insn_iabs,
+  insn_labs,
+  insn_fabs,
+  insn_dabs,
+  insn_imin,
+  insn_imax,
+  insn_lmin,
+  insn_lmax,
+  insn_fmin,
+  insn_fmax,
+  insn_dmin,
+  insn_dmax,
+  insn_ffma,
+  insn_dfma,
+  insn_floor,
+  insn_ceil,
+  insn_iclz,
+  insn_lclz,
+  insn_ipopcount,
+  insn_lpopcount,
+  insn_ibswap,
+  insn_lbswap,
+  insn_float_to_raw_int_bits,
+  insn_int_bits_to_float,
+  insn_double_to_raw_long_bits,
+  insn_long_bits_to_double,
+  insn_get_class,
+  insn_current_thread,
+  insn_identity_hash_code,
+
+  /** Superinstructions, selected by analyze_method_code for common sequences. Each replaces the first instruction of
+   * its sequence, and the rest are left in place after it. */
+  insn_aload_getfield, // becomes one of the below once the getfield is resolved
+  insn_aload_getfield_B,
+  insn_aload_getfield_C,
+  insn_aload_getfield_S,
+  insn_aload_getfield_I,
+  insn_aload_getfield_J,
+  insn_aload_getfield_F,
+  insn_aload_getfield_D,
+  insn_aload_getfield_Z,
+  insn_aload_getfield_L,
+  insn_aload_getfield_N,
+  insn_aload_arraylength,
+  insn_iload_iload_iadd,
+  insn_iload_iload_isub,
+  insn_iload_iconst_if_icmpeq,
+  insn_iload_iconst_if_icmpne,
+  insn_iload_iconst_if_icmplt,
+  insn_iload_iconst_if_icmpge,
+  insn_iload_iconst_if_icmpgt,
+  insn_iload_iconst_if_icmple,
+  insn_iinc_goto, // backward branches only
 } insn_code_kind;
 
-#define MAX_INSN_KIND (insn_sqrt + 1)
+#define MAX_INSN_KIND (insn_iinc_goto + 1)
+static_assert(MAX_INSN_KIND <= 256, "insn_code_kind must fit in a u8");
 
 // The four top-of-stack kinds considered by the interpreter. (All integer types, including long and reference, are
 // merged into one.)
@@ -308,6 +367,15 @@ typedef enum {
   CD_STATE_INITIALIZED = 4
 } classdesc_state;
 
+// Which subclass of java.lang.ref.Reference a class is or extends, if any. Determines how the GC treats the referent.
+typedef enum : u8 {
+  REFERENCE_KIND_NONE,
+  REFERENCE_KIND_SOFT,
+  REFERENCE_KIND_WEAK,
+  REFERENCE_KIND_FINAL, // finalization is disabled, so these are treated as strong
+  REFERENCE_KIND_PHANTOM
+} reference_kind;
+
 typedef struct classdesc classdesc;
 typedef struct bootstrap_method bootstrap_method;
 
@@ -589,10 +657,23 @@ struct lookupswitch_data {
   int *targets;
   int targets_count;
 
-  int *keys;
+  int *keys; // sorted in increasing order
   int keys_count;
 };
 
+// Index of the key in a lookupswitch's keys (and therefore of its target), or keys_count if it's absent
+static inline int lookupswitch_index(const struct lookupswitch_data *data, s32 key) {
+  int lo = 0, hi = data->keys_count;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (data->keys[mid] < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < data->keys_count && data->keys[lo] == key ? lo : data->keys_count;
+}
+
 struct iinc_data {
   u16 index;
   s16 const_;
@@ -639,6 +720,22 @@ typedef struct bytecode_insn {
   void *ic2;
 } bytecode_insn;
 
+// Number of receiver classes a polymorphic inline cache remembers before the call goes megamorphic
+#define POLYMORPHIC_IC_WAYS 4
+
+// Side table of an insn_invokevtable_pic or insn_invokeitable_pic (pointed to by its ic), allocated in the arena of the
+// class containing the call
+typedef struct polymorphic_ic {
+  classdesc *receivers[POLYMORPHIC_IC_WAYS];
+  cp_method *methods[POLYMORPHIC_IC_WAYS];
+  int count;
+  // Calls whose receiver class was found in the cache, and calls for which it wasn't
+  u64 hits;
+  u64 misses;
+  // Next in the class's list of caches given up by calls that went megamorphic (see classdesc::unused_pics)
+  struct polymorphic_ic *next_unused;
+} polymorphic_ic;
+
 typedef struct {
   u16 max_stack;
   u16 max_locals;
@@ -731,6 +828,15 @@ typedef struct attribute {
 
 typedef struct code_analysis code_analysis;
 
+// Methods simple enough that the invoke instructions execute them without pushing a frame. Set by analyze_method_code.
+typedef enum : u8 {
+  TRIVIAL_METHOD_NONE,
+  TRIVIAL_METHOD_EMPTY,    // return
+  TRIVIAL_METHOD_CONSTANT, // xconst; xreturn
+  TRIVIAL_METHOD_GETTER,   // aload_0; getfield; xreturn
+  TRIVIAL_METHOD_SETTER,   // aload_0; xload_1; putfield; return
+} trivial_method_kind;
+
 typedef struct cp_method {
   access_flags access_flags;
 
@@ -770,6 +876,14 @@ typedef struct cp_method {
 
   // This method overrides a method in a superclass
   bool overrides;
+  trivial_method_kind trivial;
+  // If not insn_nop, calls to this method are replaced with this instruction (see find_intrinsics in linkage.c)
+  insn_code_kind intrinsic;
+  // Some loaded class overrides this method
+  bool overridden;
+  // insn_invokevirtual_direct instructions calling this method which must be re-quickened if a class overriding it is
+  // loaded (stb_ds array)
+  bytecode_insn **devirtualized_calls;
 
   void *jit_entry;    // if NULL, there's no way to call this function from JITed code D:
   void *trampoline;   // if NULL, there's no way to call this function from the interpreter D:
@@ -799,13 +913,14 @@ typedef struct module module;
 
 typedef struct {
   u32 count;
-  u16 slots_unscaled[]; // must be scaled up by 4
+  u16 slots_unscaled[]; // must be scaled up by the size of a slot
 } reference_list;
 
 // Class descriptor. (Roughly equivalent to HotSpot's InstanceKlass)
 typedef struct classdesc {
   classdesc_kind kind;
   classdesc_state state;
+  reference_kind reference_kind;
   constant_pool *pool;
 
   access_flags access_flags;
@@ -839,9 +954,13 @@ typedef struct classdesc {
   struct native_ConstantPool *cp_mirror;
 
   // Non-array classes: which 4- (32-bit system) or 8-byte aligned offsets correspond to references that need to be
-  // followed. Only defined at linkage time.
+  // followed. Only defined at linkage time. Instance reference slots are in units of sizeof(heap_ref) if
+  // compressed_fields is set.
   reference_list *static_references;
   reference_list *instance_references; // duplicates all superclass fields for convenience/locality
+  // Whether the instance reference fields of this class, including inherited ones, are stored as heap_refs. Only ever
+  // set with COMPRESSED_REFS, and never for classes whose layout native code depends on (or their subclasses).
+  bool compressed_fields;
 
   classdesc *one_fewer_dim; // NULL for non-array types
   classdesc *base_component;
@@ -865,9 +984,21 @@ typedef struct classdesc {
   int hierarchy_len;
 
   arena arena; // most things are allocated in here
+  // Polymorphic inline caches in the arena which no call uses anymore, reused before allocating new ones
+  polymorphic_ic *unused_pics;
 
   // The tid of the thread which is initializing this class
   s32 initializing_thread;
+
+  // Class unloading. An unloadable class (see vm->unloadable_classes) is freed by a major GC once it's neither
+  // 'reached' -- by an instance, a running method or another live class -- nor kept alive by its mirrors, or by its
+  // class loader if 'kept_by_loader'. 'traced' is set once a GC has found it live and traced its roots.
+  bool unloadable;
+  bool kept_by_loader;
+  bool reached;
+  bool traced;
+  // Some call in this class's code caches an unloadable class (see vm->classes_caching_unloadable)
+  bool caches_unloadable;
 } classdesc;
 
 heap_string insn_to_string(const bytecode_insn *insn, int insn_index);
@@ -304,7 +304,7 @@ static expression load_jit_entry(expression method) {
 static expression upcall_impl([[maybe_unused]] void *fn, const char *fn_name, const char *sig, expression *args) {
   DCHECK(fn != nullptr);
   wasm_function *f = wasm_import_runtime_function_impl(ctx->module, fn_name, sig);
-  return wasm_call(ctx->module, f, args, arrlen(args));
+  return wasm_call(ctx->module, f, args, (int)strlen(sig) - 1); // sig is the return type followed by the arguments
 }
 
 #define upcall(fn, sig, args) upcall_impl(&fn, #fn, sig, args)
@@ -355,12 +355,14 @@ static void lower_monomorphic_call(const bytecode_insn *insn) {
       insn->kind == insn_invokevtable_monomorphic || insn->kind == insn_invokeitable_monomorphic;
   bool is_invokespecial = insn->kind == insn_invokespecial_resolved;
   bool is_invokestatic = insn->kind == insn_invokestatic_resolved;
+  bool is_direct = insn->kind == insn_invokevirtual_direct;
 
-  DCHECK(is_monomorphic_vtable || is_invokespecial || is_invokestatic);
+  DCHECK(is_monomorphic_vtable || is_invokespecial || is_invokestatic || is_direct);
 
   // For this instruction, we have to de-opt if the observed class descriptor is different from the IC descriptor.
   classdesc *ic = insn->ic;
-  cp_method *method = insn->ic2;
+  // A devirtualized call only caches the method
+  cp_method *method = is_direct ? insn->ic : insn->ic2;
   int argc = method_argc(method);
 
   expression if_null_then_npe = nullptr;
@@ -411,12 +413,21 @@ static void lower_monomorphic_call(const bytecode_insn *insn) {
 }
 
 static void lower_vtable_call(const bytecode_insn *insn) {
-  DCHECK(insn->kind == insn_invokevtable_polymorphic);
+  DCHECK(insn->kind == insn_invokevtable_polymorphic || insn->kind == insn_invokevtable_pic ||
+         insn->kind == insn_invokevirtual_direct);
 
   int argc = insn->args;
   expression receiver = get_stack(ctx->curr_sd - argc);
   type_kind returns = insn->cp->methodref.descriptor->return_type.repr_kind;
-  size_t vtable_i = (size_t)insn->ic2;
+  // JITed code isn't thrown away when a class overriding a devirtualized method is loaded, so dispatch through the
+  // vtable anyway. A polymorphic inline cache only saves the interpreter its lookup, so it's dispatched the same way.
+  size_t vtable_i;
+  if (insn->kind == insn_invokevirtual_direct)
+    vtable_i = ((cp_method *)insn->ic)->vtable_index;
+  else if (insn->kind == insn_invokevtable_pic)
+    vtable_i = insn->cp->methodref.resolved->vtable_index;
+  else
+    vtable_i = (size_t)insn->ic2;
 
   // Look in classdesc->vtable.methods[vtable_i] for the method
   expression exit_on_npe = wasm_if_else(ctx->module, wasm_unop(ctx->module, WASM_OP_KIND_REF_EQZ, receiver),
@@ -460,18 +471,22 @@ static cp_method *wasm_runtime_itable_lookup(vm_thread *thread, object target, c
 }
 
 static void lower_itable_call(const bytecode_insn *insn) {
-  DCHECK(insn->kind == insn_invokeitable_polymorphic);
+  DCHECK(insn->kind == insn_invokeitable_polymorphic || insn->kind == insn_invokeitable_pic);
   // The logic here is painful so for now do an upcall to itable_lookup
   expression receiver = get_stack(ctx->curr_sd - insn->args);
   type_kind returns = insn->cp->methodref.descriptor->return_type.repr_kind;
-  size_t itable_i = (size_t)insn->ic2;
+  cp_method *resolved = insn->cp->methodref.resolved;
+  // The interface and itable index of a polymorphic inline cache are those of the resolved method
+  bool is_pic = insn->kind == insn_invokeitable_pic;
+  classdesc *iface = is_pic ? resolved->my_class : insn->ic;
+  size_t itable_i = is_pic ? resolved->itable_index : (size_t)insn->ic2;
   int argc = insn->args;
 
   expression exit_on_npe = wasm_if_else(ctx->module, wasm_unop(ctx->module, WASM_OP_KIND_REF_EQZ, receiver),
                                         npe_and_exit(), nullptr, wasm_void());
-  expression itable_lookup_args[5] = {thread_param(), receiver, wasm_i32_const(ctx->module, (intptr_t)insn->ic),
+  expression itable_lookup_args[5] = {thread_param(), receiver, wasm_i32_const(ctx->module, (intptr_t)iface),
                                       wasm_i32_const(ctx->module, (intptr_t)itable_i),
-                                      wasm_i32_const(ctx->module, (intptr_t)insn->cp->methodref.resolved)};
+                                      wasm_i32_const(ctx->module, (intptr_t)resolved)};
   expression found_method = get_stack_slot_of_type(ctx->curr_sd, WASM_TYPE_KIND_INT32);
 
   emit(exit_on_npe);
@@ -489,7 +504,7 @@ static void lower_itable_call(const bytecode_insn *insn) {
   }
 
   expression do_call = wasm_call_indirect(ctx->module, 0, load_jit_entry(found_method), args, argc + 2,
-                                          get_method_func_type(insn->cp->methodref.resolved));
+                                          get_method_func_type(resolved));
   if (returns != TYPE_KIND_VOID) {
     do_call = set_stack(ctx->curr_sd - argc, do_call, to_wasm_type(returns));
   }
@@ -649,7 +664,9 @@ static void lower_direct_binop(const bytecode_insn *insn) {
       CASE(insn_fsub, FLOAT32, FLOAT32, FLOAT32, F32_SUB), CASE(insn_fmul, FLOAT32, FLOAT32, FLOAT32, F32_MUL),
       CASE(insn_fdiv, FLOAT32, FLOAT32, FLOAT32, F32_DIV), CASE(insn_dadd, FLOAT64, FLOAT64, FLOAT64, F64_ADD),
       CASE(insn_dsub, FLOAT64, FLOAT64, FLOAT64, F64_SUB), CASE(insn_dmul, FLOAT64, FLOAT64, FLOAT64, F64_MUL),
-      CASE(insn_ddiv, FLOAT64, FLOAT64, FLOAT64, F64_DIV)};
+      CASE(insn_ddiv, FLOAT64, FLOAT64, FLOAT64, F64_DIV), CASE(insn_fmin, FLOAT32, FLOAT32, FLOAT32, F32_MIN),
+      CASE(insn_fmax, FLOAT32, FLOAT32, FLOAT32, F32_MAX), CASE(insn_dmin, FLOAT64, FLOAT64, FLOAT64, F64_MIN),
+      CASE(insn_dmax, FLOAT64, FLOAT64, FLOAT64, F64_MAX)};
 
 #undef CASE
 
@@ -705,7 +722,14 @@ static void lower_direct_unop(const bytecode_insn *insn) {
       CASE(insn_i2f, INT32, FLOAT32, F32_CONVERT_S_I32),   CASE(insn_i2l, INT32, INT64, I64_EXTEND_S_I32),
       CASE(insn_i2s, INT32, INT32, I32_EXTEND_S_I16),      CASE(insn_l2d, INT64, FLOAT64, F64_CONVERT_S_I64),
       CASE(insn_l2f, INT64, FLOAT32, F32_CONVERT_S_I64),   CASE(insn_l2i, INT64, INT32, I32_WRAP_I64),
-      CASE(insn_dneg, FLOAT64, FLOAT64, F64_NEG),          CASE(insn_fneg, FLOAT32, FLOAT32, F32_NEG)};
+      CASE(insn_dneg, FLOAT64, FLOAT64, F64_NEG),          CASE(insn_fneg, FLOAT32, FLOAT32, F32_NEG),
+      CASE(insn_fabs, FLOAT32, FLOAT32, F32_ABS),          CASE(insn_dabs, FLOAT64, FLOAT64, F64_ABS),
+      CASE(insn_floor, FLOAT64, FLOAT64, F64_FLOOR),       CASE(insn_ceil, FLOAT64, FLOAT64, F64_CEIL),
+      CASE(insn_iclz, INT32, INT32, I32_CLZ),              CASE(insn_ipopcount, INT32, INT32, I32_POPCNT),
+      CASE(insn_float_to_raw_int_bits, FLOAT32, INT32, I32_REINTERPRET_F32),
+      CASE(insn_int_bits_to_float, INT32, FLOAT32, F32_REINTERPRET_I32),
+      CASE(insn_double_to_raw_long_bits, FLOAT64, INT64, I64_REINTERPRET_F64),
+      CASE(insn_long_bits_to_double, INT64, FLOAT64, F64_REINTERPRET_I64)};
 #undef CASE
 
   expression operand = get_stack_assert(ctx->curr_sd - 1, tbl[insn->kind].operand);
@@ -747,6 +771,28 @@ static void lower_arraylength(const bytecode_insn *insn) {
   emit(length);
 }
 
+// Load a field of the VM. The heap, nursery bounds and card table are reloaded at every use because they change
+// when the heap is resized.
+static expression load_vm_field(size_t offset) {
+  expression vm = wasm_load(ctx->module, WASM_OP_KIND_I32_LOAD, thread_param(), 0, offsetof(vm_thread, vm));
+  return wasm_load(ctx->module, WASM_OP_KIND_I32_LOAD, vm, 0, (int)offset);
+}
+
+// Inline gc_write_barrier for the object at the given stack slot, after a reference has been stored into it
+static void emit_write_barrier(int holder_slot) {
+  expression offset =
+      wasm_binop(ctx->module, WASM_OP_KIND_I32_SUB, get_stack(holder_slot), load_vm_field(offsetof(vm, heap)));
+  expression is_old =
+      wasm_binop(ctx->module, WASM_OP_KIND_I32_LT_U, offset, load_vm_field(offsetof(vm, nursery_start)));
+
+  offset = wasm_binop(ctx->module, WASM_OP_KIND_I32_SUB, get_stack(holder_slot), load_vm_field(offsetof(vm, heap)));
+  expression card = wasm_binop(ctx->module, WASM_OP_KIND_I32_ADD, load_vm_field(offsetof(vm, card_table)),
+                               wasm_binop(ctx->module, WASM_OP_KIND_I32_DIV_U, offset,
+                                          wasm_i32_const(ctx->module, CARD_BYTES)));
+  expression mark = wasm_store(ctx->module, WASM_OP_KIND_I32_STORE8, card, wasm_i32_const(ctx->module, 1), 0, 0);
+  emit(wasm_if_else(ctx->module, is_old, mark, nullptr, wasm_void()));
+}
+
 EMSCRIPTEN_KEEPALIVE
 static void wasm_runtime_array_oob(vm_thread *thread, int index, int length) {
   raise_array_index_oob_exception(thread, index, length);
@@ -839,9 +885,11 @@ static void lower_array_load_store(const bytecode_insn *insn) {
     load = set_stack(ctx->curr_sd - 2, load, to_wasm_type(data_type));
     emit(load);
   } else {
-    expression value = get_stack_assert(ctx->curr_sd - 3, to_wasm_type(data_type));
+    expression value = get_stack_assert(ctx->curr_sd - 1, to_wasm_type(data_type));
     // TODO ArrayStoreException
     emit(wasm_store(ctx->module, store_op, addr, value, 0, kArrayDataOffset));
+    if (data_type == TYPE_KIND_REFERENCE)
+      emit_write_barrier(ctx->curr_sd - 3);
   }
 }
 
@@ -1082,6 +1130,39 @@ static void lower_branch(const bytecode_insn *insn) {
   emit(wasm_br(ctx->module, nullptr, branch_target(ctx->curr_pc + 1)));
 }
 
+// Jump to targets[index], or the default target if index is out of range (as an unsigned integer)
+static void emit_switch(expression index, const int *targets, int targets_count, int default_target) {
+  expression *exprs = nullptr;
+  for (int i = 0; i < targets_count; ++i) {
+    arrput(exprs, branch_target(targets[i]));
+  }
+  emit(wasm_br_table(ctx->module, index, exprs, targets_count, branch_target(default_target)));
+  arrfree(exprs);
+}
+
+static void lower_tableswitch(const bytecode_insn *insn) {
+  DCHECK(insn->kind == insn_tableswitch);
+  const struct tableswitch_data *data = insn->tableswitch;
+  expression key = get_stack_assert(ctx->curr_sd - 1, WASM_TYPE_KIND_INT32);
+  expression index = wasm_binop(ctx->module, WASM_OP_KIND_I32_SUB, key, wasm_i32_const(ctx->module, data->low));
+  emit_switch(index, data->targets, data->targets_count, data->default_target);
+}
+
+EMSCRIPTEN_KEEPALIVE
+static int wasm_runtime_lookupswitch(const struct lookupswitch_data *data, s32 key) {
+  return lookupswitch_index(data, key);
+}
+
+static void lower_lookupswitch(const bytecode_insn *insn) {
+  DCHECK(insn->kind == insn_lookupswitch);
+  const struct lookupswitch_data *data = insn->lookupswitch;
+  expression args[2] = {wasm_i32_const(ctx->module, (intptr_t)data),
+                        get_stack_assert(ctx->curr_sd - 1, WASM_TYPE_KIND_INT32)};
+  // Binary search for the key's index, then branch through a table as for tableswitch
+  expression index = upcall(wasm_runtime_lookupswitch, "iii", args);
+  emit_switch(index, data->targets, data->targets_count, data->default_target);
+}
+
 void lower_get_put_resolved(const bytecode_insn *insn) {
   wasm_load_op_kind load_op;
   wasm_store_op_kind store_op;
@@ -1177,6 +1258,8 @@ void lower_get_put_resolved(const bytecode_insn *insn) {
 
   if (is_putfield || is_putstatic) {
     emit(wasm_store(ctx->module, store_op, addr, get_stack(ctx->curr_sd - 1), 0, offset));
+    if (insn->kind == insn_putfield_L)
+      emit_write_barrier(ctx->curr_sd - 2);
   } else {
     int store_to = is_getstatic ? ctx->curr_sd : ctx->curr_sd - 1 - is_putfield;
     emit(set_stack(store_to, wasm_load(ctx->module, load_op, addr, 0, offset), to_wasm_type(type)));
@@ -1199,6 +1282,7 @@ void lower_local_load(const bytecode_insn *insn) {
     type = WASM_TYPE_KIND_FLOAT32;
     break;
   case insn_iload:
+  case insn_aload:
     type = WASM_TYPE_KIND_INT32;
     break;
   case insn_lload:
@@ -1220,6 +1304,7 @@ void lower_local_store(const bytecode_insn *insn) {
     type = WASM_TYPE_KIND_FLOAT32;
     break;
   case insn_istore:
+  case insn_astore:
     type = WASM_TYPE_KIND_INT32;
     break;
   case insn_lstore:
@@ -1286,6 +1371,118 @@ void lower_sqrt(const bytecode_insn *insn) {
   emit(set_stack(ctx->curr_sd - 1, sqrt, type));
 }
 
+static void lower_long_bit_count(const bytecode_insn *insn) {
+  wasm_unary_op_kind op = insn->kind == insn_lclz ? WASM_OP_KIND_I64_CLZ : WASM_OP_KIND_I64_POPCNT;
+  expression value = get_stack_assert(ctx->curr_sd - 1, WASM_TYPE_KIND_INT64);
+  expression count = wasm_unop(ctx->module, WASM_OP_KIND_I32_WRAP_I64, wasm_unop(ctx->module, op, value));
+  emit(set_stack(ctx->curr_sd - 1, count, WASM_TYPE_KIND_INT32));
+}
+
+static void lower_integral_abs(const bytecode_insn *insn) {
+  bool is_long = insn->kind == insn_labs;
+  wasm_value_type type = is_long ? WASM_TYPE_KIND_INT64 : WASM_TYPE_KIND_INT32;
+  expression zero = is_long ? wasm_i64_const(ctx->module, 0) : wasm_i32_const(ctx->module, 0);
+  expression neg = wasm_binop(ctx->module, is_long ? WASM_OP_KIND_I64_SUB : WASM_OP_KIND_I32_SUB, zero,
+                              get_stack_assert(ctx->curr_sd - 1, type));
+  zero = is_long ? wasm_i64_const(ctx->module, 0) : wasm_i32_const(ctx->module, 0);
+  expression is_negative = wasm_binop(ctx->module, is_long ? WASM_OP_KIND_I64_LT_S : WASM_OP_KIND_I32_LT_S,
+                                      get_stack_assert(ctx->curr_sd - 1, type), zero);
+  expression abs = wasm_select(ctx->module, is_negative, neg, get_stack_assert(ctx->curr_sd - 1, type));
+  emit(set_stack(ctx->curr_sd - 1, abs, type));
+}
+
+static void lower_integral_min_max(const bytecode_insn *insn) {
+  bool is_long = insn->kind == insn_lmin || insn->kind == insn_lmax;
+  bool is_min = insn->kind == insn_imin || insn->kind == insn_lmin;
+  wasm_value_type type = is_long ? WASM_TYPE_KIND_INT64 : WASM_TYPE_KIND_INT32;
+  wasm_binary_op_kind op = is_long ? (is_min ? WASM_OP_KIND_I64_LT_S : WASM_OP_KIND_I64_GT_S)
+                                   : (is_min ? WASM_OP_KIND_I32_LT_S : WASM_OP_KIND_I32_GT_S);
+  expression take_left = wasm_binop(ctx->module, op, get_stack_assert(ctx->curr_sd - 2, type),
+                                    get_stack_assert(ctx->curr_sd - 1, type));
+  expression result = wasm_select(ctx->module, take_left, get_stack_assert(ctx->curr_sd - 2, type),
+                                  get_stack_assert(ctx->curr_sd - 1, type));
+  emit(set_stack(ctx->curr_sd - 2, result, type));
+}
+
+EMSCRIPTEN_KEEPALIVE
+static float wasm_runtime_ffma(float a, float b, float c) { return fmaf(a, b, c); }
+
+EMSCRIPTEN_KEEPALIVE
+static double wasm_runtime_dfma(double a, double b, double c) { return fma(a, b, c); }
+
+static void lower_fma(const bytecode_insn *insn) {
+  bool is_double = insn->kind == insn_dfma;
+  wasm_value_type type = is_double ? WASM_TYPE_KIND_FLOAT64 : WASM_TYPE_KIND_FLOAT32;
+  expression args[3] = {get_stack_assert(ctx->curr_sd - 3, type), get_stack_assert(ctx->curr_sd - 2, type),
+                        get_stack_assert(ctx->curr_sd - 1, type)};
+  expression result = is_double ? upcall(wasm_runtime_dfma, "dddd", args) : upcall(wasm_runtime_ffma, "ffff", args);
+  emit(set_stack(ctx->curr_sd - 3, result, type));
+}
+
+EMSCRIPTEN_KEEPALIVE
+static s32 wasm_runtime_ibswap(s32 value) { return (s32)__builtin_bswap32((u32)value); }
+
+EMSCRIPTEN_KEEPALIVE
+static s64 wasm_runtime_lbswap(s64 value) { return (s64)__builtin_bswap64((u64)value); }
+
+static void lower_bswap(const bytecode_insn *insn) {
+  bool is_long = insn->kind == insn_lbswap;
+  wasm_value_type type = is_long ? WASM_TYPE_KIND_INT64 : WASM_TYPE_KIND_INT32;
+  expression args[1] = {get_stack_assert(ctx->curr_sd - 1, type)};
+  expression result = is_long ? upcall(wasm_runtime_lbswap, "jj", args) : upcall(wasm_runtime_ibswap, "ii", args);
+  emit(set_stack(ctx->curr_sd - 1, result, type));
+}
+
+EMSCRIPTEN_KEEPALIVE
+static object wasm_runtime_get_class(vm_thread *thread, object o) {
+  if (unlikely(!o)) {
+    raise_null_pointer_exception(thread);
+    return nullptr;
+  }
+  return o->descriptor->mirror ? (object)o->descriptor->mirror : (object)get_class_mirror(thread, o->descriptor);
+}
+
+static void lower_get_class(const bytecode_insn *insn) {
+  DCHECK(insn->kind == insn_get_class);
+  emit(spill_oops(0));
+  expression args[2] = {thread_param(), get_stack_assert(ctx->curr_sd - 1, WASM_TYPE_KIND_INT32)};
+  emit(set_stack(ctx->curr_sd - 1, upcall(wasm_runtime_get_class, "iii", args), WASM_TYPE_KIND_INT32));
+
+  expression mirror = get_stack_slot_of_type(ctx->curr_sd - 1, WASM_TYPE_KIND_INT32);
+  // Return immediately if null (NPE or OOM)
+  emit(wasm_if_else(ctx->module, wasm_unop(ctx->module, WASM_OP_KIND_REF_EQZ, mirror), do_exit(), nullptr,
+                    wasm_void()));
+}
+
+static void lower_current_thread(const bytecode_insn *insn) {
+  DCHECK(insn->kind == insn_current_thread);
+  expression thread_obj =
+      wasm_load(ctx->module, WASM_OP_KIND_I32_LOAD, thread_param(), 0, offsetof(vm_thread, thread_obj));
+  emit(set_stack(ctx->curr_sd, thread_obj, WASM_TYPE_KIND_INT32));
+}
+
+EMSCRIPTEN_KEEPALIVE
+static s32 wasm_runtime_identity_hash_code(vm_thread *thread, object o) {
+  return o ? get_object_hash_code(thread->vm, o) : 0;
+}
+
+static void lower_identity_hash_code(const bytecode_insn *insn) {
+  DCHECK(insn->kind == insn_identity_hash_code);
+  expression args[2] = {thread_param(), get_stack_assert(ctx->curr_sd - 1, WASM_TYPE_KIND_INT32)};
+  emit(set_stack(ctx->curr_sd - 1, upcall(wasm_runtime_identity_hash_code, "iii", args), WASM_TYPE_KIND_INT32));
+}
+
+// The instruction a superinstruction replaced, which is the first of the fused sequence
+static insn_code_kind unfused_kind(insn_code_kind kind) {
+  if (kind >= insn_aload_getfield && kind <= insn_aload_arraylength)
+    return insn_aload;
+  if (kind >= insn_iload_iload_iadd && kind <= insn_iload_iconst_if_icmple)
+    return insn_iload;
+  DCHECK(kind == insn_iinc_goto);
+  return insn_iinc;
+}
+
+// NOLINTNEXTLINE(misc-no-recursion)
 static int lower_instruction(const bytecode_insn *insn) {
   switch (insn->kind) {
   default:
@@ -1349,6 +1546,55 @@ static int lower_instruction(const bytecode_insn *insn) {
   case insn_sqrt:
     lower_sqrt(insn);
     return 0;
+  case insn_fabs:
+  case insn_dabs:
+  case insn_floor:
+  case insn_ceil:
+  case insn_iclz:
+  case insn_ipopcount:
+  case insn_float_to_raw_int_bits:
+  case insn_int_bits_to_float:
+  case insn_double_to_raw_long_bits:
+  case insn_long_bits_to_double:
+    lower_direct_unop(insn);
+    return 0;
+  case insn_fmin:
+  case insn_fmax:
+  case insn_dmin:
+  case insn_dmax:
+    lower_direct_binop(insn);
+    return 0;
+  case insn_lclz:
+  case insn_lpopcount:
+    lower_long_bit_count(insn);
+    return 0;
+  case insn_iabs:
+  case insn_labs:
+    lower_integral_abs(insn);
+    return 0;
+  case insn_imin:
+  case insn_imax:
+  case insn_lmin:
+  case insn_lmax:
+    lower_integral_min_max(insn);
+    return 0;
+  case insn_ffma:
+  case insn_dfma:
+    lower_fma(insn);
+    return 0;
+  case insn_ibswap:
+  case insn_lbswap:
+    lower_bswap(insn);
+    return 0;
+  case insn_get_class:
+    lower_get_class(insn);
+    return 0;
+  case insn_current_thread:
+    lower_current_thread(insn);
+    return 0;
+  case insn_identity_hash_code:
+    lower_identity_hash_code(insn);
+    return 0;
   case insn_dadd:
   case insn_ddiv:
   case insn_dmul:
@@ -1487,12 +1733,12 @@ static int lower_instruction(const bytecode_insn *insn) {
   case insn_newarray:
     lower_newarray(insn);
     return 0;
-  case insn_tableswitch: // TODO
-    // lower_tableswitch(insn);
-    break;
+  case insn_tableswitch:
+    lower_tableswitch(insn);
+    return 0;
   case insn_lookupswitch:
-    // lower_lookupswitch(insn);
-    break;
+    lower_lookupswitch(insn);
+    return 0;
   case insn_ret:
     break;
   case insn_anewarray_resolved:
@@ -1513,10 +1759,22 @@ static int lower_instruction(const bytecode_insn *insn) {
   case insn_invokestatic_resolved:
     lower_monomorphic_call(insn);
     return 0;
+  case insn_invokevirtual_direct: {
+    // Private and final targets can never be overridden, so they're called directly. Other devirtualized calls are
+    // undone when an overriding class is loaded, which doesn't throw away JITed code, so they go through the vtable.
+    cp_method *target = insn->ic;
+    if (target->access_flags & (ACCESS_PRIVATE | ACCESS_FINAL) || target->my_class->access_flags & ACCESS_FINAL)
+      lower_monomorphic_call(insn);
+    else
+      lower_vtable_call(insn);
+    return 0;
+  }
   case insn_invokevtable_polymorphic:
+  case insn_invokevtable_pic:
     lower_vtable_call(insn);
     return 0;
   case insn_invokeitable_polymorphic:
+  case insn_invokeitable_pic:
     lower_itable_call(insn);
     return 0;
   case insn_invokecallsite:
@@ -1562,6 +1820,32 @@ static int lower_instruction(const bytecode_insn *insn) {
   case insn_putstatic_L:
     lower_get_put_resolved(insn);
     return 0;
+  case insn_aload_getfield:
+  case insn_aload_getfield_B:
+  case insn_aload_getfield_C:
+  case insn_aload_getfield_S:
+  case insn_aload_getfield_I:
+  case insn_aload_getfield_J:
+  case insn_aload_getfield_F:
+  case insn_aload_getfield_D:
+  case insn_aload_getfield_Z:
+  case insn_aload_getfield_L:
+  case insn_aload_getfield_N:
+  case insn_aload_arraylength:
+  case insn_iload_iload_iadd:
+  case insn_iload_iload_isub:
+  case insn_iload_iconst_if_icmpeq:
+  case insn_iload_iconst_if_icmpne:
+  case insn_iload_iconst_if_icmplt:
+  case insn_iload_iconst_if_icmpge:
+  case insn_iload_iconst_if_icmpgt:
+  case insn_iload_iconst_if_icmple:
+  case insn_iinc_goto: {
+    // The rest of the fused sequence is still in place after the head, so lower the head as what it replaced
+    bytecode_insn head = *insn;
+    head.kind = unfused_kind(insn->kind);
+    return lower_instruction(&head);
+  }
   }
 
   // De-opt if we can't lower this instruction
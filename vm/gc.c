@@ -4,21 +4,88 @@
 #include "arrays.h"
 #include "bjvm.h"
 #include <gc.h>
+#include <monitors.h>
 #include <roundrobin_scheduler.h>
 
-typedef struct gc_ctx {
+#if !defined(EMSCRIPTEN) || defined(__EMSCRIPTEN_PTHREADS__)
+#define PARALLEL_GC_SUPPORTED
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Where we can, reserve address space for the largest heap up front and commit pages as the heap grows, so that it
+// never moves. Otherwise (WASM) the heap is an ordinary allocation, and resizing it compacts into a new allocation of
+// the new size -- with ALLOW_MEMORY_GROWTH, malloc grows linear memory to fit.
+#if (defined(__linux__) || defined(__APPLE__)) && !defined(EMSCRIPTEN)
+#define RESERVE_HEAP 1
+#include <sys/mman.h>
+#else
+#define RESERVE_HEAP 0
+#endif
+
+typedef struct gc_ctx gc_ctx;
+
+// State of one thread participating in a parallel major GC.
+typedef struct gc_worker {
+  gc_ctx *ctx;
+  int index;
+
+  // Objects still to be scanned by this worker
+  object *stack;
+  // Reference objects found by this worker
+  object *discovered;
+
+#ifdef PARALLEL_GC_SUPPORTED
+  // Surplus objects which idle workers may steal, guarded by 'lock'. shared_count mirrors arrlen(shared) so that
+  // other workers can peek at it without taking the lock.
+  pthread_mutex_t lock;
+  object *shared;
+  size_t shared_count;
+#endif
+} gc_worker;
+
+struct gc_ctx {
   vm *vm;
 
   // Vector of pointer to things to rewrite
   object **roots;
 
-  // If lowest bit is a 1, it's a monitor_data*, otherwise it's an object.
-  void **objs;
-  object *new_location;
   object *worklist; // should contain a reachable object exactly once over its lifetime
 
-  object **relocations;
-} gc_ctx;
+  // Reachable Reference objects whose referents were not marked when they were scanned
+  object *discovered;
+
+  // Objects at or past this heap offset aren't marked. While marking incrementally this is the start of the nursery,
+  // whose objects may be moved by minor GCs, and the nursery is only traced in the final pause.
+  size_t mark_limit;
+  // For incremental marking, cards cleaned by minor GCs since marking started. Together with the card table, these
+  // are the objects which may have been written to since they were scanned, so must be scanned again.
+  u8 *mod_union;
+
+  // Whether unreachable unloadable classes are being collected. If so, the roots of an unloadable class are only
+  // traced once the class is found to be live (see trace_live_classes).
+  bool unload_classes;
+
+  // One bit per 8-byte granule of the heap. 'starts' has the first granule of each marked object set, while 'live'
+  // has every granule of every marked object set.
+  u64 *starts;
+  u64 *live;
+  size_t bitmap_words;
+
+  // For each word of 'live', the number of live granules in the words before it. The forwarding address of a live
+  // granule is then the block offset plus the live granules before it in its own word, so no per-object forwarding
+  // state is needed.
+  size_t *block_offsets;
+
+  // Parallel collection (all zero for a serial collection)
+  bool parallel;
+  gc_worker *workers;
+  int worker_count;
+  int idle_workers;
+  u8 *new_heap;
+  size_t next_region;
+  u8 *region_done;
+};
 
 int in_heap(const vm *vm, object field) {
   return (u8 *)field >= vm->heap && (u8 *)field < vm->heap + vm->true_heap_capacity;
@@ -100,6 +167,44 @@ static void enumerate_reflection_roots(gc_ctx *ctx, classdesc *desc) {
   }
 }
 
+// Note that an unloadable class is in use. A live array class keeps its element class alive.
+static void reach_class(classdesc *desc) {
+  if (desc && desc->unloadable)
+    __atomic_store_n(&desc->reached, true, __ATOMIC_RELAXED);
+}
+
+// A live class keeps alive its superclass, its interfaces, its nest host and the classes its constant pool resolved
+static void reach_class_dependencies(classdesc *desc) {
+  if (desc->super_class)
+    reach_class(desc->super_class->classdesc);
+  for (int i = 0; i < desc->interfaces_count; ++i) {
+    reach_class(desc->interfaces[i]->classdesc);
+  }
+  if (desc->nest_host)
+    reach_class(desc->nest_host->classdesc);
+  if (desc->pool) {
+    for (int i = 0; i < desc->pool->entries_len; ++i) {
+      cp_entry *ent = desc->pool->entries + i;
+      if (ent->kind == CP_KIND_CLASS)
+        reach_class(ent->class_info.classdesc);
+    }
+  }
+}
+
+// Static fields, mirrors and everything else a class holds on to
+static void enumerate_class_roots(gc_ctx *ctx, classdesc *desc) {
+  if (desc->static_references) {
+    for (size_t i = 0; i < desc->static_references->count; ++i) {
+      u16 offs = desc->static_references->slots_unscaled[i];
+      object *root = ((object *)desc->static_fields) + offs;
+      PUSH_ROOT(root);
+    }
+  }
+
+  // Also, push things like Class, Method and Constructors
+  enumerate_reflection_roots(ctx, desc);
+}
+
 static void push_thread_roots(gc_ctx *ctx, vm_thread *thr) {
   PUSH_ROOT(&thr->thread_obj);
   PUSH_ROOT(&thr->current_exception);
@@ -111,6 +216,9 @@ static void push_thread_roots(gc_ctx *ctx, vm_thread *thr) {
 
   stack_frame *frame = thr->stack.top;
   while (frame) {
+    // Classes with running methods can't be unloaded
+    if (ctx->unload_classes)
+      reach_class(get_frame_method(frame)->my_class);
     if (is_frame_native(frame)) {
       frame = frame->prev;
       continue;
@@ -163,7 +271,8 @@ static void push_thread_roots(gc_ctx *ctx, vm_thread *thr) {
   PUSH_ROOT(&thr->stack_overflow_error);
 }
 
-static void major_gc_enumerate_gc_roots(gc_ctx *ctx) {
+// Everything but the roots on thread stacks
+static void enumerate_vm_roots(gc_ctx *ctx) {
   vm *vm = ctx->vm;
   if (vm->primitive_classes[0]) {
     for (size_t i = 0; i < lengthof(vm->primitive_classes); ++i) {
@@ -176,28 +285,28 @@ static void major_gc_enumerate_gc_roots(gc_ctx *ctx) {
     PUSH_ROOT(&vm->js_handles[i]);
   }
 
-  // Static fields of bootstrap-loaded classes
+  // Static fields of bootstrap-loaded classes. Those of unloadable classes are only roots once the classes are found
+  // to be live, and the other classes are always live.
   hash_table_iterator it = hash_table_get_iterator(&vm->classes);
   char *key;
   size_t key_len;
   classdesc *desc;
   while (hash_table_iterator_has_next(it, &key, &key_len, (void **)&desc)) {
-    if (desc->static_references) {
-      for (size_t i = 0; i < desc->static_references->count; ++i) {
-        u16 offs = desc->static_references->slots_unscaled[i];
-        object *root = ((object *)desc->static_fields) + offs;
-        PUSH_ROOT(root);
-      }
+    if (!ctx->unload_classes) {
+      enumerate_class_roots(ctx, desc);
+    } else if (!desc->unloadable) {
+      reach_class_dependencies(desc);
+      enumerate_class_roots(ctx, desc);
     }
-
-    // Also, push things like Class, Method and Constructors
-    enumerate_reflection_roots(ctx, desc);
     hash_table_iterator_next(&it);
   }
 
   // main thread group
   PUSH_ROOT(&vm->main_thread_group);
 
+  // References waiting to be enqueued
+  PUSH_ROOT(&vm->reference_pending_list);
+
   // Modules
   it = hash_table_get_iterator(&vm->modules);
   module *module;
@@ -206,180 +315,1022 @@ static void major_gc_enumerate_gc_roots(gc_ctx *ctx) {
     hash_table_iterator_next(&it);
   }
 
+  // Objects locked while locking is elided
+  for (int i = 0; i < arrlen(vm->elided_locks); ++i) {
+    PUSH_ROOT(&vm->elided_locks[i].obj);
+  }
+
+  // Scheduler roots
+  if (vm->scheduler) {
+    rr_scheduler_enumerate_gc_roots(vm->scheduler, &ctx->roots);
+  }
+}
+
+static void major_gc_enumerate_gc_roots(gc_ctx *ctx) {
+  enumerate_vm_roots(ctx);
+
   // Stack and local variables on active threads
-  for (int thread_i = 0; thread_i < arrlen(vm->active_threads); ++thread_i) {
-    vm_thread *thr = vm->active_threads[thread_i];
+  for (int thread_i = 0; thread_i < arrlen(ctx->vm->active_threads); ++thread_i) {
+    vm_thread *thr = ctx->vm->active_threads[thread_i];
     push_thread_roots(ctx, thr);
   }
+}
 
-  // Interned strings (TODO remove)
-  it = hash_table_get_iterator(&vm->interned_strings);
-  object str;
-  while (hash_table_iterator_has_next(it, &key, &key_len, (void **)&str)) {
-    PUSH_ROOT(&it.current->data);
-    hash_table_iterator_next(&it);
+size_t size_of_object(object obj) {
+  if (obj->descriptor->kind == CD_KIND_ORDINARY) {
+    return obj->descriptor->instance_bytes;
   }
-
-  // Scheduler roots
-  if (vm->scheduler) {
-    rr_scheduler_enumerate_gc_roots(vm->scheduler, ctx->roots);
+  if (obj->descriptor->kind == CD_KIND_ORDINARY_ARRAY) {
+    return kArrayDataOffset + ArrayLength(obj) * sizeof(heap_ref);
   }
+  return kArrayDataOffset + ArrayLength(obj) * sizeof_type_kind(obj->descriptor->primitive_component);
 }
 
-static u32 *get_flags(vm *vm, object o) {
-  assert(o != nullptr);
-  return &get_mark_word(vm, &o->header_word)->data[0];
+
+static size_t granule_of(const gc_ctx *ctx, const void *ptr) { return ((u8 *)ptr - ctx->vm->heap) / 8; }
+
+static bool test_bit(const u64 *bits, size_t i) { return bits[i / 64] >> (i % 64) & 1; }
+
+// Sets the given bits of a bitmap word, returning the previous value of the word. Other workers may be setting bits in
+// the same word during a parallel collection.
+static u64 or_bits(const gc_ctx *ctx, u64 *word, u64 mask) {
+  if (ctx->parallel)
+    return __atomic_fetch_or(word, mask, __ATOMIC_RELAXED);
+  u64 old = *word;
+  *word = old | mask;
+  return old;
 }
 
-static void mark_reachable(gc_ctx *ctx, object obj) {
-  arrput(ctx->objs, obj);
-  if (has_expanded_data(&obj->header_word)) {
-    arrput(ctx->objs, (void *)((uintptr_t)obj->header_word.expanded_data | 1));
+// Set bits [begin, end)
+static void set_bit_range(const gc_ctx *ctx, u64 *bits, size_t begin, size_t end) {
+  if (begin / 64 == end / 64) {
+    if (begin < end)
+      or_bits(ctx, bits + begin / 64, (UINT64_MAX << (begin % 64)) & ~(UINT64_MAX << (end % 64)));
+    return;
+  }
+  if (begin % 64) {
+    or_bits(ctx, bits + begin / 64, UINT64_MAX << (begin % 64));
+    begin = align_up(begin, 64);
+  }
+  // Words strictly inside the range belong to this object alone, so no atomics are needed
+  for (; begin + 64 <= end; begin += 64) {
+    bits[begin / 64] = UINT64_MAX;
   }
+  if (begin < end) {
+    or_bits(ctx, bits + begin / 64, ~(UINT64_MAX << (end % 64)));
+  }
+}
+
+static bool is_marked(const gc_ctx *ctx, object obj) { return test_bit(ctx->starts, granule_of(ctx, obj)); }
+
+static void mark_live(const gc_ctx *ctx, void *ptr, size_t bytes) {
+  size_t g = granule_of(ctx, ptr);
+  set_bit_range(ctx, ctx->live, g, g + align_up(bytes, 8) / 8);
+}
+
+// Mark the object and push it onto the given mark stack, unless it was already marked.
+static void mark_object(gc_ctx *ctx, object **stack, object obj) {
+  if (!obj || (size_t)((u8 *)obj - ctx->vm->heap) >= ctx->mark_limit)
+    return;
+  size_t g = granule_of(ctx, obj);
+  u64 mask = 1ULL << (g % 64);
+  if (or_bits(ctx, ctx->starts + g / 64, mask) & mask)
+    return;
+  mark_live(ctx, obj, size_of_object(obj));
+  arrput(*stack, obj);
+}
+
+// Index of java.lang.ref.Reference#referent in an object's reference slots
+#define REFERENT_SLOT (offsetof(struct native_Reference, referent) / sizeof(object))
+
+static bool is_weak_reference(const classdesc *desc) {
+  return desc->reference_kind != REFERENCE_KIND_NONE && desc->reference_kind != REFERENCE_KIND_FINAL;
+}
 
+static void mark_reachable(gc_ctx *ctx, object **stack, object **discovered, object obj) {
   // Visit all instance fields
   classdesc *desc = obj->descriptor;
+  if (unlikely(desc->unloadable))
+    reach_class(desc);
   if (desc->kind == CD_KIND_ORDINARY) {
     reference_list *refs = desc->instance_references;
+    bool is_reference = is_weak_reference(desc);
     for (size_t i = 0; i < refs->count; ++i) {
-      object field_obj = *((object *)obj + refs->slots_unscaled[i]);
-      if (field_obj && in_heap(ctx->vm, field_obj) && !(*get_flags(ctx->vm, field_obj) & IS_REACHABLE)) {
-        *get_flags(ctx->vm, field_obj) |= IS_REACHABLE;
-        arrput(ctx->worklist, field_obj);
+      // The referent of a soft, weak or phantom reference is dealt with once strong marking is finished
+      if (is_reference && refs->slots_unscaled[i] == REFERENT_SLOT) {
+        object referent = ((struct native_Reference *)obj)->referent;
+        if (referent && in_heap(ctx->vm, referent) && !is_marked(ctx, referent))
+          arrput(*discovered, obj);
+        continue;
       }
+      mark_object(ctx, stack, load_ref_slot(instance_ref_slot(desc, obj, i), desc->compressed_fields));
     }
   } else if (desc->kind == CD_KIND_ORDINARY_ARRAY || (desc->kind == CD_KIND_PRIMITIVE_ARRAY && desc->dimensions > 1)) {
     // Visit all components
     int arr_len = ArrayLength(obj);
     for (size_t i = 0; i < (size_t)arr_len; ++i) {
-      object arr_element = ReferenceArrayLoad(obj, i);
-      if (arr_element && in_heap(ctx->vm, arr_element) && !(*get_flags(ctx->vm, arr_element) & IS_REACHABLE)) {
-        *get_flags(ctx->vm, arr_element) |= IS_REACHABLE;
-        arrput(ctx->worklist, arr_element);
+      mark_object(ctx, stack, ReferenceArrayLoad(obj, i));
+    }
+  }
+}
+
+// Prefix sum over the live bitmap.
+static void compute_block_offsets(gc_ctx *ctx) {
+  size_t live_so_far = 0;
+  for (size_t i = 0; i < ctx->bitmap_words; ++i) {
+    ctx->block_offsets[i] = live_so_far;
+    live_so_far += __builtin_popcountll(ctx->live[i]);
+  }
+}
+
+// Offset from the start of the heap that the live granule containing ptr will be moved to.
+static size_t forwarding_offset(const gc_ctx *ctx, const void *ptr) {
+  size_t g = granule_of(ctx, ptr);
+  u64 below = ctx->live[g / 64] & ((1ULL << (g % 64)) - 1);
+  return (ctx->block_offsets[g / 64] + __builtin_popcountll(below)) * 8;
+}
+
+static void relocate_object(gc_ctx *ctx, u8 *new_heap, object *obj) {
+  if (!*obj || !in_heap(ctx->vm, *obj))
+    return;
+  if (!is_marked(ctx, *obj)) {
+    fprintf(stderr, "Dangling reference! %p %p", obj, *obj);
+    CHECK(false);
+  }
+  *obj = (object)(new_heap + forwarding_offset(ctx, *obj));
+}
+
+// Relocate a reference held by a heap object, which is a heap_ref if narrow
+static void relocate_slot(gc_ctx *ctx, u8 *new_heap, void *slot, bool narrow) {
+  object obj = load_ref_slot(slot, narrow);
+  if (!obj)
+    return;
+  relocate_object(ctx, new_heap, &obj);
+  store_ref_slot(slot, narrow, obj);
+}
+
+// Rewrite every reference held by a marked object starting in bitmap words [first_word, end_word) to where it will be
+// after compaction. The objects themselves are still in place.
+static void relocate_instance_fields(gc_ctx *ctx, u8 *new_heap, size_t first_word, size_t end_word) {
+  for (size_t word = first_word; word < end_word; ++word) {
+    u64 bits = ctx->starts[word];
+    while (bits) {
+      object obj = (object)(ctx->vm->heap + (word * 64 + __builtin_ctzll(bits)) * 8);
+      bits &= bits - 1;
+
+      classdesc *desc = obj->descriptor;
+      if (desc->kind == CD_KIND_ORDINARY) {
+        reference_list *refs = desc->instance_references;
+        for (size_t j = 0; j < refs->count; ++j) {
+          relocate_slot(ctx, new_heap, instance_ref_slot(desc, obj, j), desc->compressed_fields);
+        }
+      } else if (desc->kind == CD_KIND_ORDINARY_ARRAY ||
+                 (desc->kind == CD_KIND_PRIMITIVE_ARRAY && desc->dimensions > 1)) {
+        int arr_len = ArrayLength(obj);
+        for (int j = 0; j < arr_len; ++j) {
+          relocate_slot(ctx, new_heap, (heap_ref *)ArrayData(obj) + j, true);
+        }
       }
     }
   }
 }
 
-size_t size_of_object(object obj) {
-  if (obj->descriptor->kind == CD_KIND_ORDINARY) {
-    return obj->descriptor->instance_bytes;
+// Slide each run of live granules in bitmap words [first_word, end_word) down to its forwarding address. Runs are
+// visited in address order and are never moved upwards, so nothing in the range is overwritten before it has been
+// copied.
+static void move_live_granules(gc_ctx *ctx, u8 *new_heap, size_t first_word, size_t end_word) {
+  for (size_t word = first_word; word < end_word; ++word) {
+    u64 bits = ctx->live[word];
+    while (bits) {
+      int begin = __builtin_ctzll(bits);
+      u64 run = bits >> begin;
+      int length = ~run ? __builtin_ctzll(~run) : 64 - begin;
+      u8 *src = ctx->vm->heap + (word * 64 + begin) * 8;
+      memmove(new_heap + forwarding_offset(ctx, src), src, length * 8);
+      bits &= length + begin == 64 ? 0 : UINT64_MAX << (begin + length);
+    }
   }
-  if (obj->descriptor->kind == CD_KIND_ORDINARY_ARRAY) {
-    return kArrayDataOffset + ArrayLength(obj) * sizeof(void *);
+}
+
+#ifdef PARALLEL_GC_SUPPORTED
+
+// Number of objects a worker keeps to itself before offering half of its mark stack to others.
+#define SHARE_THRESHOLD 64
+// Bitmap words per compaction region (32 KiB of heap)
+#define REGION_WORDS 64
+
+static void run_workers(gc_ctx *ctx, void *(*fn)(void *)) {
+  pthread_t threads[ctx->worker_count];
+  for (int i = 1; i < ctx->worker_count; ++i) {
+    CHECK(pthread_create(&threads[i], nullptr, fn, &ctx->workers[i]) == 0, "Failed to start GC worker");
+  }
+  fn(&ctx->workers[0]);
+  for (int i = 1; i < ctx->worker_count; ++i) {
+    pthread_join(threads[i], nullptr);
   }
-  return kArrayDataOffset + ArrayLength(obj) * sizeof_type_kind(obj->descriptor->primitive_component);
 }
 
-[[maybe_unused]] static void **binary_search_for_pointer(void *ptr, void **ptrs, s64 count) {
-  s64 low = 0, high = count - 1;
-  while (low <= high) {
-    size_t mid = (low + high) / 2;
-    if ((uintptr_t)ptrs[mid] == (uintptr_t)ptr) {
-      return &ptrs[mid];
+// Move up to half (or all) of the victim's shared objects onto the thief's own stack.
+static bool take_shared(gc_worker *victim, gc_worker *thief, bool half) {
+  if (__atomic_load_n(&victim->shared_count, __ATOMIC_RELAXED) == 0)
+    return false;
+  pthread_mutex_lock(&victim->lock);
+  size_t count = arrlenu(victim->shared), take = half ? (count + 1) / 2 : count;
+  for (size_t i = 0; i < take; ++i) {
+    arrput(thief->stack, arrpop(victim->shared));
+  }
+  __atomic_store_n(&victim->shared_count, arrlenu(victim->shared), __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&victim->lock);
+  return take > 0;
+}
+
+static void share_surplus(gc_worker *w) {
+  pthread_mutex_lock(&w->lock);
+  size_t give = arrlenu(w->stack) / 2;
+  // Give away the oldest entries, which tend to lead to the biggest subgraphs
+  for (size_t i = 0; i < give; ++i) {
+    arrput(w->shared, w->stack[i]);
+  }
+  memmove(w->stack, w->stack + give, (arrlenu(w->stack) - give) * sizeof(object));
+  arrsetlen(w->stack, arrlenu(w->stack) - give);
+  __atomic_store_n(&w->shared_count, arrlenu(w->shared), __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&w->lock);
+}
+
+static bool steal(gc_worker *w) {
+  gc_ctx *ctx = w->ctx;
+  for (int i = 1; i < ctx->worker_count; ++i) {
+    if (take_shared(&ctx->workers[(w->index + i) % ctx->worker_count], w, true))
+      return true;
+  }
+  return false;
+}
+
+static bool any_shared(gc_ctx *ctx) {
+  for (int i = 0; i < ctx->worker_count; ++i) {
+    if (__atomic_load_n(&ctx->workers[i].shared_count, __ATOMIC_RELAXED))
+      return true;
+  }
+  return false;
+}
+
+static void *parallel_mark(void *arg) {
+  gc_worker *w = arg;
+  gc_ctx *ctx = w->ctx;
+  for (;;) {
+    while (arrlen(w->stack) > 0) {
+      mark_reachable(ctx, &w->stack, &w->discovered, arrpop(w->stack));
+      if (arrlen(w->stack) > SHARE_THRESHOLD && __atomic_load_n(&w->shared_count, __ATOMIC_RELAXED) == 0)
+        share_surplus(w);
+    }
+    if (take_shared(w, w, false) || steal(w))
+      continue;
+
+    // Out of work. A worker only goes idle with an empty shared stack, and nobody else pushes onto it, so once every
+    // worker is idle there is nothing left to mark.
+    __atomic_fetch_add(&ctx->idle_workers, 1, __ATOMIC_ACQ_REL);
+    for (;;) {
+      if (__atomic_load_n(&ctx->idle_workers, __ATOMIC_ACQUIRE) == ctx->worker_count)
+        return nullptr;
+      if (any_shared(ctx)) {
+        __atomic_fetch_sub(&ctx->idle_workers, 1, __ATOMIC_ACQ_REL);
+        break;
+      }
+      sched_yield();
     }
-    if ((uintptr_t)ptrs[mid] < (uintptr_t)ptr) {
-      low = mid + 1;
-    } else {
-      high = mid - 1;
+  }
+}
+
+static void *parallel_relocate(void *arg) {
+  gc_worker *w = arg;
+  gc_ctx *ctx = w->ctx;
+  size_t n = ctx->worker_count;
+  relocate_instance_fields(ctx, ctx->new_heap, ctx->bitmap_words * w->index / n,
+                           ctx->bitmap_words * (w->index + 1) / n);
+  size_t roots = arrlenu(ctx->roots);
+  for (size_t i = roots * w->index / n; i < roots * (w->index + 1) / n; ++i) {
+    relocate_object(ctx, ctx->new_heap, ctx->roots[i]);
+  }
+  return nullptr;
+}
+
+// Regions are claimed in address order. A region may only be moved once every region whose contents its destination
+// overlaps has been moved out of the way, all of which are at lower addresses and so already claimed.
+static void *parallel_compact(void *arg) {
+  gc_worker *w = arg;
+  gc_ctx *ctx = w->ctx;
+  size_t region_count = (ctx->bitmap_words + REGION_WORDS - 1) / REGION_WORDS;
+  size_t r;
+  while ((r = __atomic_fetch_add(&ctx->next_region, 1, __ATOMIC_ACQ_REL)) < region_count) {
+    size_t first_word = r * REGION_WORDS;
+    size_t end_word = first_word + REGION_WORDS < ctx->bitmap_words ? first_word + REGION_WORDS : ctx->bitmap_words;
+    if (ctx->new_heap == ctx->vm->heap) {
+      size_t dest_granule = ctx->block_offsets[first_word];
+      for (size_t dep = dest_granule / 64 / REGION_WORDS; dep < r; ++dep) {
+        while (!__atomic_load_n(&ctx->region_done[dep], __ATOMIC_ACQUIRE))
+          sched_yield();
+      }
     }
+    move_live_granules(ctx, ctx->new_heap, first_word, end_word);
+    __atomic_store_n(&ctx->region_done[r], 1, __ATOMIC_RELEASE);
   }
   return nullptr;
 }
 
-// NOLINTNEXTLINE(misc-no-recursion)
-static void quicksort_pointers(void **ptrs, size_t count) {
-  if (count <= 1) {
+static void parallel_mark_phase(gc_ctx *ctx) {
+  int n = ctx->worker_count;
+  ctx->parallel = true;
+  ctx->workers = calloc(n, sizeof(gc_worker));
+  for (int i = 0; i < n; ++i) {
+    ctx->workers[i].ctx = ctx;
+    ctx->workers[i].index = i;
+    pthread_mutex_init(&ctx->workers[i].lock, nullptr);
+  }
+
+  // Deal the roots, and any objects already waiting to be scanned, out round-robin, then mark
+  for (int i = 0; i < arrlen(ctx->roots); ++i) {
+    mark_object(ctx, &ctx->workers[i % n].stack, *ctx->roots[i]);
+  }
+  for (int i = 0; i < arrlen(ctx->worklist); ++i) {
+    arrput(ctx->workers[i % n].stack, ctx->worklist[i]);
+  }
+  arrsetlen(ctx->worklist, 0);
+  run_workers(ctx, parallel_mark);
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < arrlen(ctx->workers[i].discovered); ++j) {
+      arrput(ctx->discovered, ctx->workers[i].discovered[j]);
+    }
+    arrfree(ctx->workers[i].discovered);
+  }
+}
+
+static void parallel_compact_phase(gc_ctx *ctx, u8 *new_heap) {
+  int n = ctx->worker_count;
+  ctx->new_heap = new_heap;
+  run_workers(ctx, parallel_relocate);
+
+  ctx->region_done = calloc((ctx->bitmap_words + REGION_WORDS - 1) / REGION_WORDS, 1);
+  run_workers(ctx, parallel_compact);
+
+  for (int i = 0; i < n; ++i) {
+    DCHECK(arrlen(ctx->workers[i].stack) == 0 && arrlen(ctx->workers[i].shared) == 0);
+    arrfree(ctx->workers[i].stack);
+    arrfree(ctx->workers[i].shared);
+    pthread_mutex_destroy(&ctx->workers[i].lock);
+  }
+  free(ctx->workers);
+  free(ctx->region_done);
+}
+
+#endif
+
+// Sized for the largest heap, so that they needn't be reallocated when it grows
+static size_t card_count(const vm *vm) { return vm->heap_reservation / CARD_BYTES + 1; }
+
+static size_t object_starts_words(const vm *vm) { return vm->heap_reservation / (8 * 64) + 1; }
+
+static void set_object_start(vm *vm, size_t offset) {
+  size_t granule = offset / 8;
+  vm->object_starts[granule / 64] |= 1ULL << (granule % 64);
+}
+
+void record_object_start(vm *vm, object obj) {
+  if (!vm->object_starts)
     return;
+  size_t offset = (u8 *)obj - vm->heap;
+  set_object_start(vm, offset);
+  // Natives initialise freshly allocated objects without a write barrier, so consider the card dirty right away
+  vm->card_table[offset / CARD_BYTES] = 1;
+}
+
+int init_generational_heap(vm *vm, size_t nursery_size) {
+  // The compacting space needs to be able to absorb a full nursery of survivors
+  nursery_size = align_up(nursery_size, CARD_BYTES);
+  if (nursery_size > vm->heap_capacity / 2)
+    nursery_size = vm->heap_capacity / 2 & ~(size_t)(CARD_BYTES - 1);
+  if (nursery_size == 0)
+    return 0;
+  vm->card_table = calloc(card_count(vm), 1);
+  vm->object_starts = calloc(object_starts_words(vm), sizeof(u64));
+  if (!vm->card_table || !vm->object_starts) {
+    free_generational_heap(vm);
+    return -1;
   }
-  void *pivot = ptrs[count / 2];
-  void **left = ptrs, **right = ptrs + count - 1;
-  while (left <= right) {
-    while (*left < pivot) {
-      left++;
+  vm->nursery_capacity = nursery_size;
+  vm->nursery_start = vm->heap_capacity - nursery_size;
+  vm->nursery_used = 0;
+  return 0;
+}
+
+static void free_mark_state(gc_ctx *ctx);
+
+void free_generational_heap(vm *vm) {
+  if (vm->incremental_mark) {
+    free_mark_state(vm->incremental_mark);
+    free(vm->incremental_mark);
+    vm->incremental_mark = nullptr;
+  }
+  free(vm->card_table);
+  free(vm->object_starts);
+  vm->card_table = nullptr;
+  vm->object_starts = nullptr;
+  vm->nursery_capacity = vm->nursery_start = vm->nursery_used = 0;
+}
+
+// The low bit of the descriptor of a nursery object is set once it has been copied, and the rest of the word is the
+// address of the copy.
+static object evacuate(vm *vm, object obj) {
+  uintptr_t desc = (uintptr_t)obj->descriptor;
+  if (desc & 1)
+    return (object)(desc & ~(uintptr_t)1);
+
+  size_t sz = align_up(size_of_object(obj), 8);
+  DCHECK(vm->heap_used + sz <= vm->nursery_start);
+  object copy = (object)(vm->heap + vm->heap_used);
+  memcpy(copy, obj, sz);
+  set_object_start(vm, vm->heap_used);
+  vm->heap_used += sz;
+  obj->descriptor = (classdesc *)((uintptr_t)copy | 1);
+  return copy;
+}
+
+// Evacuate the object referred to by a slot, which holds a heap_ref if narrow
+static void evacuate_slot(vm *vm, void *slot, bool narrow) {
+  object obj = load_ref_slot(slot, narrow);
+  if (obj && in_nursery(vm, obj))
+    store_ref_slot(slot, narrow, evacuate(vm, obj));
+}
+
+static void evacuate_fields(vm *vm, object obj) {
+  classdesc *desc = obj->descriptor;
+  if (desc->kind == CD_KIND_ORDINARY) {
+    reference_list *refs = desc->instance_references;
+    for (size_t i = 0; i < refs->count; ++i) {
+      evacuate_slot(vm, instance_ref_slot(desc, obj, i), desc->compressed_fields);
+    }
+  } else if (desc->kind == CD_KIND_ORDINARY_ARRAY || (desc->kind == CD_KIND_PRIMITIVE_ARRAY && desc->dimensions > 1)) {
+    int arr_len = ArrayLength(obj);
+    for (int i = 0; i < arr_len; ++i) {
+      evacuate_slot(vm, (heap_ref *)ArrayData(obj) + i, true);
     }
-    while (*right > pivot) {
-      right--;
+  }
+}
+
+// Call visit on every object starting in the given card, below 'limit'
+static void visit_card(vm *vm, size_t card, size_t limit, void (*visit)(void *arg, object obj), void *arg) {
+  size_t card_end = (card + 1) * CARD_BYTES;
+  size_t begin = card * CARD_BYTES / 8, end = (card_end < limit ? card_end : limit) / 8; // in granules
+  for (size_t word = begin / 64; word * 64 < end; ++word) {
+    u64 bits = vm->object_starts[word];
+    while (bits) {
+      size_t granule = word * 64 + __builtin_ctzll(bits);
+      if (granule >= end)
+        break;
+      bits &= bits - 1;
+      visit(arg, (object)(vm->heap + granule * 8));
     }
-    if (left <= right) {
-      void *tmp = *left;
-      *left = *right;
-      *right = tmp;
-      left++;
-      right--;
+  }
+}
+
+static void evacuate_card_object(void *vm, object obj) { evacuate_fields(vm, obj); }
+
+// Visit every object starting in a dirty card below 'limit', cleaning the card. If a major GC is marking, the card is
+// remembered so that its objects are scanned again at the end of marking.
+static void scan_dirty_cards(vm *vm, size_t limit) {
+  size_t cards = (limit + CARD_BYTES - 1) / CARD_BYTES;
+  gc_ctx *marking = vm->incremental_mark;
+  for (size_t card = 0; card < cards; ++card) {
+    if (!vm->card_table[card])
+      continue;
+    vm->card_table[card] = 0;
+    if (marking)
+      marking->mod_union[card] = 1;
+    visit_card(vm, card, limit, evacuate_card_object, vm);
+  }
+}
+
+// Objects may move, so threads must start new allocation buffers after a collection
+static void retire_tlabs(vm *vm) {
+  for (int i = 0; i < arrlen(vm->active_threads); ++i) {
+    retire_tlab(vm->active_threads[i]);
+  }
+}
+
+static void init_mark_bitmaps(gc_ctx *ctx) {
+  ctx->bitmap_words = ctx->vm->true_heap_capacity / (8 * 64) + 1;
+  ctx->starts = calloc(ctx->bitmap_words, sizeof(u64));
+  ctx->live = calloc(ctx->bitmap_words, sizeof(u64));
+  ctx->block_offsets = malloc(ctx->bitmap_words * sizeof(size_t));
+  CHECK(ctx->starts && ctx->live && ctx->block_offsets, "Out of memory for the mark bitmaps");
+}
+
+// Decide whether the collection that's starting to mark will unload classes, and forget what the last one found.
+// Classes aren't unloaded while the allocation profiler, whose samples point at them, is running.
+static void begin_class_unloading(gc_ctx *ctx) {
+  vm *vm = ctx->vm;
+  ctx->unload_classes = arrlen(vm->unloadable_classes) && !vm->allocation_profiler;
+  for (int i = 0; i < arrlen(vm->unloadable_classes); ++i) {
+    classdesc *desc = vm->unloadable_classes[i];
+    desc->traced = false;
+    for (classdesc *array = desc; array; array = array->array_type) {
+      array->reached = false;
     }
   }
-  quicksort_pointers(ptrs, right - ptrs + 1);
-  quicksort_pointers(left, ptrs + count - left);
 }
 
-static void relocate_object(gc_ctx *ctx, object *obj) {
-  if (!*obj)
+// With a pause budget, marking starts once a minor GC leaves the compacting space this full
+#define INCREMENTAL_MARK_PERCENT 70
+
+// Start marking the compacting space from the current roots. Marking then proceeds in slices in incremental_gc_step,
+// while the mutator runs, and the next major GC finishes the collection.
+//
+// Marking is incremental-update: the card table doubles as the write barrier, so an object written to after it was
+// scanned is in a dirty card (or one in the mod union table, if a minor GC has since cleaned it). The final pause
+// rescans those objects and the roots -- static fields included, so putstatic needs no barrier -- and traces the
+// nursery, after which every reachable object is marked.
+static void start_incremental_mark(vm *vm) {
+  gc_ctx *ctx = calloc(1, sizeof(gc_ctx));
+  CHECK(ctx, "Out of memory for the mark bitmaps");
+  ctx->vm = vm;
+  init_mark_bitmaps(ctx);
+  ctx->mod_union = calloc(card_count(vm), 1);
+  CHECK(ctx->mod_union, "Out of memory for the mark bitmaps");
+  ctx->mark_limit = vm->nursery_start;
+  begin_class_unloading(ctx);
+
+  major_gc_enumerate_gc_roots(ctx);
+  for (int i = 0; i < arrlen(ctx->roots); ++i) {
+    mark_object(ctx, &ctx->worklist, *ctx->roots[i]);
+  }
+  arrfree(ctx->roots);
+  vm->incremental_mark = ctx;
+}
+
+static void free_mark_state(gc_ctx *ctx) {
+  free(ctx->starts);
+  free(ctx->live);
+  free(ctx->block_offsets);
+  free(ctx->mod_union);
+  arrfree(ctx->worklist);
+  arrfree(ctx->discovered);
+}
+
+// How many objects to scan between checks of the clock
+#define MARK_SLICE_OBJECTS 256
+
+void incremental_gc_step(vm *vm) {
+  gc_ctx *ctx = vm->incremental_mark;
+  if (!ctx)
     return;
+  if (arrlen(ctx->worklist) == 0) {
+    major_gc(vm); // finish up
+    return;
+  }
+  u64 deadline = get_unix_us() + vm->gc_pause_budget_us;
+  do {
+    for (int i = 0; i < MARK_SLICE_OBJECTS && arrlen(ctx->worklist) > 0; ++i) {
+      mark_reachable(ctx, &ctx->worklist, &ctx->discovered, arrpop(ctx->worklist));
+    }
+  } while (arrlen(ctx->worklist) > 0 && get_unix_us() < deadline);
+}
 
-  DCHECK(((uintptr_t)obj & 1) == 0);
+static void push_if_marked(void *ctx, object obj) {
+  if (is_marked(ctx, obj))
+    arrput(((gc_ctx *)ctx)->worklist, obj);
+}
 
-#if DCHECKS_ENABLED
-  arrput(ctx->relocations, obj);
-#endif
+// Queue up the marked objects which may have been written to since they were scanned
+static void rescan_dirty_cards(gc_ctx *ctx) {
+  vm *vm = ctx->vm;
+  size_t cards = (vm->heap_used + CARD_BYTES - 1) / CARD_BYTES;
+  for (size_t card = 0; card < cards; ++card) {
+    if (vm->card_table[card] || ctx->mod_union[card])
+      visit_card(vm, card, vm->heap_used, push_if_marked, ctx);
+  }
+  free(ctx->mod_union);
+  ctx->mod_union = nullptr;
+}
 
-  // Binary search for obj in ctx->roots
-  void **found = binary_search_for_pointer(*obj, ctx->objs, arrlen(ctx->objs));
-  if (found) {
-    object relocated = ctx->new_location[found - ctx->objs];
-    DCHECK(relocated);
-    DCHECK(!((uintptr_t)relocated & 1));
-    *obj = relocated;
-  } else {
-    if (in_heap(ctx->vm, *obj)) {
-      // Check for a double relocation
-      for (int i = 0; i < arrlen(ctx->relocations); ++i) {
-        if (ctx->relocations[i] == obj) {
-          fprintf(stderr, "Double relocation.");
+// The intern table holds its strings weakly: remove the unmarked ones, and have the rest relocated along with the roots
+static void sweep_interned_strings(gc_ctx *ctx) {
+  intern_table *table = &ctx->vm->interned_strings;
+  for (u32 i = 0; i < table->capacity; ++i) {
+    object *string = &table->entries[i].string;
+    if (!*string || *string == INTERNED_TOMBSTONE)
+      continue;
+    if (is_marked(ctx, *string))
+      arrput(ctx->roots, string);
+    else
+      *string = INTERNED_TOMBSTONE;
+  }
+}
+
+// Deflate the idle monitors of marked objects, and free those of unmarked ones
+static void sweep_dead_and_idle_monitors(gc_ctx *ctx) {
+  vm *vm = ctx->vm;
+  if (!arrlen(vm->monitor_chunks))
+    return;
+  for (size_t word = 0; word < ctx->bitmap_words; ++word) {
+    u64 bits = ctx->starts[word];
+    while (bits) {
+      object obj = (object)(vm->heap + (word * 64 + __builtin_ctzll(bits)) * 8);
+      bits &= bits - 1;
+      retain_or_deflate_monitor(vm, obj);
+    }
+  }
+  sweep_monitors(vm);
+}
+
+static bool is_live_class(const gc_ctx *ctx, const classdesc *desc) {
+  if (desc->kept_by_loader && desc->classloader && is_marked(ctx, desc->classloader))
+    return true;
+  for (const classdesc *array = desc; array; array = array->array_type) {
+    if (array->reached || (array->mirror && is_marked(ctx, (object)array->mirror)) ||
+        (array->cp_mirror && is_marked(ctx, (object)array->cp_mirror)))
+      return true;
+  }
+  return false;
+}
+
+// Mark from the roots of the unloadable classes newly found to be live, returning whether there were any. Marking is
+// finished once this finds nothing new.
+static bool trace_live_classes(gc_ctx *ctx) {
+  bool any = false;
+  classdesc **classes = ctx->vm->unloadable_classes;
+  for (int i = 0; i < arrlen(classes); ++i) {
+    classdesc *desc = classes[i];
+    if (desc->traced || !is_live_class(ctx, desc))
+      continue;
+    desc->traced = any = true;
+    reach_class_dependencies(desc);
+    int first_root = arrlen(ctx->roots);
+    enumerate_class_roots(ctx, desc);
+    for (int j = first_root; j < arrlen(ctx->roots); ++j) {
+      mark_object(ctx, &ctx->worklist, *ctx->roots[j]);
+    }
+  }
+  return any;
+}
+
+static bool is_dying_class(const classdesc *desc) {
+  return desc->unloadable && !(desc->base_component ? desc->base_component : desc)->traced;
+}
+
+// Drop the entries of a polymorphic inline cache whose receiver classes are being unloaded, returning whether any
+// entry left is for an unloadable class
+static bool purge_polymorphic_ic(polymorphic_ic *pic) {
+  int kept = 0;
+  bool caches_unloadable = false;
+  for (int i = 0; i < pic->count; ++i) {
+    if (is_dying_class(pic->receivers[i]))
+      continue;
+    caches_unloadable |= pic->receivers[i]->unloadable;
+    pic->receivers[kept] = pic->receivers[i];
+    pic->methods[kept++] = pic->methods[i];
+  }
+  pic->count = kept;
+  return caches_unloadable;
+}
+
+// Fix up the calls in a live class's code which cache dying classes, returning whether any call still caches an
+// unloadable class
+static bool purge_inline_caches(classdesc *desc) {
+  bool caches_unloadable = false;
+  for (int i = 0; i < desc->methods_count; ++i) {
+    attribute_code *code = desc->methods[i].code;
+    for (int j = 0; code && j < code->insn_count; ++j) {
+      bytecode_insn *insn = code->code + j;
+      if (insn->kind == insn_invokevtable_monomorphic || insn->kind == insn_invokeitable_monomorphic) {
+        if (is_dying_class(insn->ic2))
+          make_invoke_polymorphic(insn);
+        else
+          caches_unloadable |= ((classdesc *)insn->ic2)->unloadable;
+      } else if (insn->kind == insn_invokevtable_pic || insn->kind == insn_invokeitable_pic) {
+        caches_unloadable |= purge_polymorphic_ic(insn->ic);
+      } else if (insn->kind == insn_invokevirtual_direct) {
+        classdesc *target_class = ((cp_method *)insn->ic)->my_class;
+        if (is_dying_class(target_class))
+          insn->kind = insn_invokevirtual;
+        else
+          caches_unloadable |= target_class->unloadable;
+      }
+    }
+  }
+  return caches_unloadable;
+}
+
+// Remove a dying class's devirtualized calls from the dependencies of the methods they call
+static void forget_devirtualized_calls(const classdesc *desc) {
+  for (int i = 0; i < desc->methods_count; ++i) {
+    attribute_code *code = desc->methods[i].code;
+    for (int j = 0; code && j < code->insn_count; ++j) {
+      bytecode_insn *insn = code->code + j;
+      if (insn->kind != insn_invokevirtual_direct)
+        continue;
+      cp_method *target = insn->ic;
+      if (is_dying_class(target->my_class))
+        continue;
+      for (int k = 0; k < arrlen(target->devirtualized_calls); ++k) {
+        if (target->devirtualized_calls[k] == insn) {
+          arrdelswap(target->devirtualized_calls, k);
           break;
         }
       }
-      fprintf(stderr, "Dangling reference! %p %p", obj, *obj);
-      CHECK(false);
     }
   }
 }
 
-void relocate_instance_fields(gc_ctx *ctx) {
-  for (int i = 0; i < arrlen(ctx->objs); ++i) {
-    if ((uintptr_t)ctx->objs[i] & 1) { // monitor
+// Free the unloadable classes which weren't found to be live. Nothing live refers to them any more, except perhaps
+// the inline caches of calls whose receivers were once instances of them, and the dependency lists of methods they
+// made devirtualized calls to.
+static void unload_dead_classes(gc_ctx *ctx) {
+  vm *vm = ctx->vm;
+  if (!ctx->unload_classes)
+    return;
+  bool any_dying = false;
+  for (int i = 0; i < arrlen(vm->unloadable_classes); ++i) {
+    any_dying |= !vm->unloadable_classes[i]->traced;
+  }
+  if (!any_dying)
+    return;
+
+  // Only the classes which noted caching an unloadable class (see note_cached_class) need looking at. Dying ones, and
+  // ones left caching none, are dropped from the list.
+  int kept = 0;
+  for (int i = 0; i < arrlen(vm->classes_caching_unloadable); ++i) {
+    classdesc *caller = vm->classes_caching_unloadable[i];
+    if (is_dying_class(caller))
+      continue;
+    if (purge_inline_caches(caller))
+      vm->classes_caching_unloadable[kept++] = caller;
+    else
+      caller->caches_unloadable = false;
+  }
+  arrsetlen(vm->classes_caching_unloadable, kept);
+
+  for (int i = 0; i < arrlen(vm->unloadable_classes); ++i) {
+    if (!vm->unloadable_classes[i]->traced)
+      forget_devirtualized_calls(vm->unloadable_classes[i]);
+  }
+
+  kept = 0;
+  for (int i = 0; i < arrlen(vm->unloadable_classes); ++i) {
+    classdesc *desc = vm->unloadable_classes[i];
+    if (desc->traced) {
+      vm->unloadable_classes[kept++] = desc;
       continue;
     }
-    object obj = ctx->new_location[i];
+    // Another class may since have been defined with the same name
+    if (hash_table_lookup(&vm->classes, desc->name.chars, (int)desc->name.len) == desc)
+      (void)hash_table_delete(&vm->classes, desc->name.chars, (int)desc->name.len);
+    desc->dtor(desc);
+  }
+  arrsetlen(vm->unloadable_classes, kept);
+}
 
-    // Re-map the monitor, if any
-    if (has_expanded_data(&obj->header_word)) {
-      monitor_data *monitor = obj->header_word.expanded_data;
-      void *key = (void *)((uintptr_t)monitor | 1);
-      void **found = binary_search_for_pointer(key, ctx->objs, arrlen(ctx->objs));
-      if (!found) {
-        fprintf(stderr, "Can't find monitor %p!\n", monitor);
-        abort();
-      }
-      obj->header_word.expanded_data = (void *)ctx->new_location[found - ctx->objs];
+int minor_gc(vm *vm) {
+  DCHECK(vm->nursery_capacity);
+  // Promotion guarantee: if everything in the nursery survives, it must fit below the nursery
+  if (vm->nursery_start - vm->heap_used < vm->nursery_used)
+    return -1;
+
+  u64 start = get_unix_us();
+  retire_tlabs(vm);
+  gc_ctx ctx = {.vm = vm};
+  major_gc_enumerate_gc_roots(&ctx);
+
+  size_t promoted_start = vm->heap_used;
+  scan_dirty_cards(vm, promoted_start);
+  for (int i = 0; i < arrlen(ctx.roots); ++i) {
+    evacuate_slot(vm, ctx.roots[i], false);
+  }
+
+  // Cheney-style scan of the promoted objects, which are laid out contiguously
+  size_t scan = promoted_start;
+  while (scan < vm->heap_used) {
+    object obj = (object)(vm->heap + scan);
+    evacuate_fields(vm, obj);
+    // Keep promoted objects dirty until the next minor GC, in case native code is still initialising them
+    vm->card_table[scan / CARD_BYTES] = 1;
+    scan += align_up(size_of_object(obj), 8);
+  }
+
+  // Interned strings which weren't copied are garbage
+  intern_table *interned = &vm->interned_strings;
+  for (u32 i = 0; i < interned->capacity; ++i) {
+    object string = interned->entries[i].string;
+    if (string && string != INTERNED_TOMBSTONE && in_nursery(vm, string)) {
+      uintptr_t desc = (uintptr_t)string->descriptor;
+      interned->entries[i].string = desc & 1 ? (object)(desc & ~(uintptr_t)1) : INTERNED_TOMBSTONE;
     }
+  }
 
-    if (obj->descriptor->kind == CD_KIND_ORDINARY) {
-      classdesc *desc = obj->descriptor;
-      reference_list *refs = desc->instance_references;
-      for (size_t j = 0; j < refs->count; ++j) {
-        object *field = (object *)obj + refs->slots_unscaled[j];
-        relocate_object(ctx, field);
-      }
-    } else if (obj->descriptor->kind == CD_KIND_ORDINARY_ARRAY ||
-               (obj->descriptor->kind == CD_KIND_PRIMITIVE_ARRAY && obj->descriptor->dimensions > 1)) {
-      int arr_len = ArrayLength(obj);
-      for (int j = 0; j < arr_len; ++j) {
-        object *field = (object *)ArrayData(obj) + j;
-        relocate_object(ctx, field);
-      }
+  // Everything left in the nursery is garbage
+  memset(vm->heap + vm->nursery_start, 0, vm->nursery_used);
+  vm->nursery_used = 0;
+  arrfree(ctx.roots);
+  vm->minor_gc_us += get_unix_us() - start;
+
+  // Right after a minor GC is the best time to start marking, as there is nothing in the nursery to trace at the end
+  if (vm->gc_pause_budget_us && !vm->incremental_mark &&
+      vm->heap_used * 100 > vm->nursery_start * INCREMENTAL_MARK_PERCENT)
+    start_incremental_mark(vm);
+  return 0;
+}
+
+// Heap sizes are kept a multiple of this, which is at least the page size
+#define HEAP_PAGE (1 << 16)
+
+static size_t committed_bytes(size_t true_capacity) { return align_up(true_capacity, HEAP_PAGE); }
+
+#if COMPRESSED_REFS
+#if !RESERVE_HEAP
+#error "Compressed references need the heap to be reserved up front"
+#endif
+
+// A heap_ref addresses 32 GiB in units of 8 bytes. The whole range is reserved the first time it's needed and shared
+// by every VM in the process, whose heaps and static field areas are handed out from it first-fit. The first page is
+// never handed out, so that no object is at offset 0 (null).
+#define COMPRESSED_REGION_BYTES ((size_t)1 << 35)
+// Address space reserved for the static fields of each VM
+#define STATIC_FIELD_AREA_BYTES ((size_t)1 << 26)
+
+u8 *compressed_heap_base;
+
+typedef struct {
+  size_t start, size;
+} region_range;
+
+// Unused parts of the region, in address order, guarded by region_lock
+static region_range *free_ranges;
+static pthread_mutex_t region_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Returns an inaccessible range of the given size (a multiple of HEAP_PAGE), or null if the region is full
+static u8 *reserve_from_region(size_t bytes) {
+  u8 *result = nullptr;
+  pthread_mutex_lock(&region_lock);
+  if (!compressed_heap_base) {
+    void *base =
+        mmap(nullptr, COMPRESSED_REGION_BYTES, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base != MAP_FAILED) {
+      compressed_heap_base = base;
+      region_range all = {HEAP_PAGE, COMPRESSED_REGION_BYTES - HEAP_PAGE};
+      arrput(free_ranges, all);
     }
   }
+  for (int i = 0; i < arrlen(free_ranges); ++i) {
+    region_range *range = free_ranges + i;
+    if (range->size >= bytes) {
+      result = compressed_heap_base + range->start;
+      range->start += bytes;
+      range->size -= bytes;
+      if (!range->size)
+        arrdel(free_ranges, i);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&region_lock);
+  return result;
+}
+
+// Decommit a range from reserve_from_region and make it available again
+static void return_to_region(u8 *ptr, size_t bytes) {
+  mmap(ptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+  region_range returned = {ptr - compressed_heap_base, bytes};
+  pthread_mutex_lock(&region_lock);
+  size_t i = 0;
+  while (i < arrlenu(free_ranges) && free_ranges[i].start < returned.start)
+    ++i;
+  arrput(free_ranges, returned);
+  memmove(free_ranges + i + 1, free_ranges + i, (arrlenu(free_ranges) - i - 1) * sizeof(region_range));
+  free_ranges[i] = returned;
+  // Coalesce with the neighbours
+  if (i + 1 < arrlenu(free_ranges) && free_ranges[i].start + free_ranges[i].size == free_ranges[i + 1].start) {
+    free_ranges[i].size += free_ranges[i + 1].size;
+    arrdel(free_ranges, i + 1);
+  }
+  if (i > 0 && free_ranges[i - 1].start + free_ranges[i - 1].size == free_ranges[i].start) {
+    free_ranges[i - 1].size += free_ranges[i].size;
+    arrdel(free_ranges, i);
+  }
+  pthread_mutex_unlock(&region_lock);
+}
+
+void *allocate_static_fields(vm *vm, size_t bytes) {
+  if (!vm->static_field_area && !(vm->static_field_area = reserve_from_region(STATIC_FIELD_AREA_BYTES)))
+    return nullptr;
+  size_t start = align_up(vm->static_field_area_used, 8), end = start + bytes;
+  if (end > STATIC_FIELD_AREA_BYTES)
+    return nullptr;
+  size_t committed = committed_bytes(vm->static_field_area_used), needed = committed_bytes(end);
+  if (needed > committed && mprotect(vm->static_field_area + committed, needed - committed, PROT_READ | PROT_WRITE))
+    return nullptr;
+  vm->static_field_area_used = end;
+  return vm->static_field_area + start;
+}
+#endif
+
+// Reserve the VM's heap reservation and commit the first true_capacity bytes of it
+static u8 *map_heap(const vm *vm, size_t true_capacity) {
+#if COMPRESSED_REFS
+  u8 *heap = reserve_from_region(vm->heap_reservation);
+  if (!heap)
+    return nullptr;
+  if (mprotect(heap, committed_bytes(true_capacity), PROT_READ | PROT_WRITE)) {
+    return_to_region(heap, vm->heap_reservation);
+    return nullptr;
+  }
+  return heap;
+#elif RESERVE_HEAP
+  u8 *heap = mmap(nullptr, vm->heap_reservation, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (heap == MAP_FAILED)
+    return nullptr;
+  if (mprotect(heap, committed_bytes(true_capacity), PROT_READ | PROT_WRITE)) {
+    munmap(heap, vm->heap_reservation);
+    return nullptr;
+  }
+  return heap;
+#else
+  (void)vm;
+  return aligned_alloc(HEAP_PAGE, committed_bytes(true_capacity));
+#endif
+}
+
+static void unmap_heap(const vm *vm, u8 *heap) {
+#if COMPRESSED_REFS
+  return_to_region(heap, vm->heap_reservation);
+#elif RESERVE_HEAP
+  munmap(heap, vm->heap_reservation);
+#else
+  (void)vm;
+  free(heap);
+#endif
+}
+
+#if RESERVE_HEAP
+// Change how much of a reserved heap is committed. Decommitted pages are handed back to the OS.
+static int recommit_heap(u8 *heap, size_t old_true_capacity, size_t new_true_capacity) {
+  size_t from = committed_bytes(old_true_capacity), to = committed_bytes(new_true_capacity);
+  if (to > from)
+    return mprotect(heap + from, to - from, PROT_READ | PROT_WRITE);
+  if (to < from && mmap(heap + to, from - to, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1,
+                        0) == MAP_FAILED)
+    return -1;
+  return 0;
+}
+#endif
+
+int init_heap(vm *vm) {
+  size_t slop = vm->true_heap_capacity - vm->heap_capacity;
+  vm->min_heap_capacity = align_up(vm->min_heap_capacity, HEAP_PAGE);
+  vm->max_heap_capacity = align_up(vm->max_heap_capacity, HEAP_PAGE);
+  vm->heap_capacity = vm->min_heap_capacity;
+  vm->true_heap_capacity = vm->heap_capacity + slop;
+  vm->heap_reservation = committed_bytes(vm->max_heap_capacity + slop);
+  vm->heap = map_heap(vm, vm->true_heap_capacity);
+  vm->last_major_gc_end_us = get_unix_us();
+  if (!vm->heap)
+    return -1;
+  if (!RESERVE_HEAP) // fresh mappings are already zero
+    memset(vm->heap, 0, vm->true_heap_capacity);
+  return 0;
+}
+
+void release_heap(vm *vm) {
+  unmap_heap(vm, vm->heap);
+  vm->heap = nullptr;
+#if COMPRESSED_REFS
+  if (vm->static_field_area)
+    return_to_region(vm->static_field_area, STATIC_FIELD_AREA_BYTES);
+  vm->static_field_area = nullptr;
+#endif
+}
+
+// Grow the heap if more than this percentage of it is live after a major GC, or if more than GROW_GC_PERCENT of the
+// time since the last major GC went into collecting.
+#define GROW_LIVE_PERCENT 60
+#define GROW_GC_PERCENT 10
+// Halve the heap if less than this percentage of it is live after a major GC
+#define SHRINK_LIVE_PERCENT 20
+
+static size_t choose_heap_capacity(const vm *vm, size_t live, size_t bytes, int gc_percent) {
+  size_t capacity = vm->heap_capacity;
+  if (live * 100 > capacity * GROW_LIVE_PERCENT || gc_percent > GROW_GC_PERCENT) {
+    capacity *= 2;
+  } else if (live * 100 < capacity * SHRINK_LIVE_PERCENT) {
+    capacity /= 2;
+  }
+  // Leave room for the pending allocation, and for the nursery along with a nursery's worth of promotions
+  size_t required = live + bytes + 2 * vm->nursery_capacity;
+  if (capacity < required)
+    capacity = 2 * required;
+  capacity = align_up(capacity, HEAP_PAGE);
+  if (capacity < vm->min_heap_capacity)
+    capacity = vm->min_heap_capacity;
+  if (capacity > vm->max_heap_capacity)
+    capacity = vm->max_heap_capacity;
+  return capacity;
 }
 
 #if DCHECKS_ENABLED
@@ -388,83 +1339,231 @@ void relocate_instance_fields(gc_ctx *ctx) {
 #define NEW_HEAP_EACH_GC 0
 #endif
 
-void major_gc(vm *vm) {
+static void drain_worklist(gc_ctx *ctx) {
+  do {
+    while (arrlen(ctx->worklist) > 0) {
+      mark_reachable(ctx, &ctx->worklist, &ctx->discovered, arrpop(ctx->worklist));
+    }
+  } while (ctx->unload_classes && trace_live_classes(ctx));
+}
+
+// Decide the fate of the references discovered while marking. Soft referents are kept, and traced, unless memory is
+// tight. Any reference whose referent is still unmarked after that is cleared and put on the pending list, from which
+// the ReferenceHandler thread enqueues it (or runs its Cleaner).
+static void process_references(gc_ctx *ctx, bool clear_soft) {
+  if (!clear_soft) {
+    // Tracing soft referents may discover more references, which are appended as we go
+    for (int i = 0; i < arrlen(ctx->discovered); ++i) {
+      object ref = ctx->discovered[i];
+      if (ref->descriptor->reference_kind == REFERENCE_KIND_SOFT) {
+        mark_object(ctx, &ctx->worklist, ((struct native_Reference *)ref)->referent);
+        drain_worklist(ctx);
+      }
+    }
+  }
+  vm *vm = ctx->vm;
+  bool was_empty = !vm->reference_pending_list;
+  for (int i = 0; i < arrlen(ctx->discovered); ++i) {
+    struct native_Reference *ref = (struct native_Reference *)ctx->discovered[i];
+    // References rescanned at the end of incremental marking may have been discovered twice
+    if (ref->referent && !is_marked(ctx, ref->referent)) {
+      ref->referent = nullptr;
+      ref->discovered = vm->reference_pending_list;
+      vm->reference_pending_list = (object)ref;
+    }
+  }
+  // An empty list wasn't enumerated as a root, but the references now on it are about to move
+  if (was_empty && vm->reference_pending_list)
+    arrput(ctx->roots, &vm->reference_pending_list);
+  arrfree(ctx->discovered);
+  arrfree(ctx->worklist);
+}
+
+static void zero_range(u8 *heap, size_t begin, size_t end) {
+  if (begin < end)
+    memset(heap + begin, 0, end - begin);
+}
+
+static void collect(vm *vm, bool for_allocation, size_t bytes, bool clear_soft) {
   // TODO wait for all threads to get ready (for now we'll just call this from
   // an already-running thread)
+  u64 start = get_unix_us();
+  retire_tlabs(vm);
   gc_ctx ctx = {.vm = vm};
+  bool finish_incremental = vm->incremental_mark;
+  if (finish_incremental) {
+    ctx = *vm->incremental_mark;
+    free(vm->incremental_mark);
+    vm->incremental_mark = nullptr;
+    // The profiler may have started since, in which case every class is kept after all
+    ctx.unload_classes &= !vm->allocation_profiler;
+  } else {
+    init_mark_bitmaps(&ctx);
+    begin_class_unloading(&ctx);
+  }
+  ctx.mark_limit = vm->true_heap_capacity;
   major_gc_enumerate_gc_roots(&ctx);
+  if (finish_incremental)
+    rescan_dirty_cards(&ctx);
 
+#ifdef PARALLEL_GC_SUPPORTED
+  ctx.worker_count = vm->gc_threads;
+#endif
   // Mark phase
-  for (int i = 0; i < arrlen(ctx.roots); ++i) {
-    object root = *ctx.roots[i];
-    if (!in_heap(vm, root) || *get_flags(vm, root) & IS_REACHABLE) // already visited
-      continue;
-    *get_flags(vm, root) |= IS_REACHABLE;
-    arrput(ctx.worklist, root);
+  if (ctx.worker_count > 1) {
+#ifdef PARALLEL_GC_SUPPORTED
+    parallel_mark_phase(&ctx);
+    drain_worklist(&ctx); // the live unloadable classes
+#endif
+  } else {
+    for (int i = 0; i < arrlen(ctx.roots); ++i) {
+      mark_object(&ctx, &ctx.worklist, *ctx.roots[i]);
+    }
+    drain_worklist(&ctx);
   }
+  process_references(&ctx, clear_soft || vm->clear_soft_references);
+  sweep_interned_strings(&ctx);
+  sweep_dead_and_idle_monitors(&ctx);
+  unload_dead_classes(&ctx);
 
-  int *bitset[1] = {nullptr};
-  while (arrlen(ctx.worklist) > 0) {
-    object obj = arrpop(ctx.worklist);
-    *get_flags(vm, obj) |= IS_REACHABLE;
-    mark_reachable(&ctx, obj);
-  }
-  arrfree(ctx.worklist);
-  arrfree(bitset[0]);
+  compute_block_offsets(&ctx);
+  size_t last = ctx.bitmap_words - 1;
+  size_t live_granules = ctx.block_offsets[last] + __builtin_popcountll(ctx.live[last]);
 
-  // Sort roots by address
-  quicksort_pointers(ctx.objs, arrlen(ctx.objs));
-  object *new_location = ctx.new_location = malloc(arrlen(ctx.objs) * sizeof(object));
+  // Now that the amount of live data is known, pick the new heap size. Leave it alone while an OutOfMemoryError is
+  // being constructed in the slop.
+  size_t slop = vm->true_heap_capacity - vm->heap_capacity;
+  size_t capacity = vm->heap_capacity;
+  if (slop) {
+    u64 now = get_unix_us(), elapsed = now - vm->last_major_gc_end_us;
+    int gc_percent = for_allocation && elapsed ? (int)((vm->minor_gc_us + now - start) * 100 / elapsed) : 0;
+    capacity = choose_heap_capacity(vm, live_granules * 8, bytes, gc_percent);
+  }
 
-  // Create a new heap of the same size so ASAN can enjoy itself
+  u8 *new_heap = vm->heap;
 #if NEW_HEAP_EACH_GC
-  u8 *new_heap = aligned_alloc(4096, vm->true_heap_capacity), *end = new_heap + vm->true_heap_capacity;
+  // Create a new heap so ASAN can enjoy itself
+  bool move_heap = slop;
 #else
-  u8 *new_heap = vm->heap, *end = vm->heap + vm->true_heap_capacity;
+  bool move_heap = !RESERVE_HEAP && capacity != vm->heap_capacity;
+#endif
+  if (move_heap) {
+    new_heap = map_heap(vm, capacity + slop);
+    if (!new_heap) {
+      new_heap = vm->heap;
+      capacity = vm->heap_capacity;
+    }
+  }
+#if RESERVE_HEAP
+  else if (capacity > vm->heap_capacity && recommit_heap(vm->heap, vm->true_heap_capacity, capacity + slop)) {
+    capacity = vm->heap_capacity;
+  }
 #endif
 
-  u8 *write_ptr = new_heap;
+  if (ctx.worker_count > 1) {
+#ifdef PARALLEL_GC_SUPPORTED
+    parallel_compact_phase(&ctx, new_heap);
+#endif
+  } else {
+    // Go through all static and instance fields and rewrite in place
+    relocate_instance_fields(&ctx, new_heap, 0, ctx.bitmap_words);
+    for (int i = 0; i < arrlen(ctx.roots); ++i) {
+      relocate_object(&ctx, new_heap, ctx.roots[i]);
+    }
 
-  // Copy object by object. Monitors are "objects" with a low bit of 1 to differentiate them.
-  for (size_t i = 0; i < arrlenu(ctx.objs); ++i) {
-    // Align to 8 bytes
-    write_ptr = (u8 *)align_up((uintptr_t)write_ptr, 8);
-    object obj = ctx.objs[i];
+    move_live_granules(&ctx, new_heap, 0, ctx.bitmap_words);
+  }
+  arrfree(ctx.roots);
 
-#if !NEW_HEAP_EACH_GC
-    DCHECK((uintptr_t)obj >= (uintptr_t)write_ptr);
-#endif
+  if (vm->object_starts) {
+    memset(vm->object_starts, 0, ctx.bitmap_words * sizeof(u64));
+    for (size_t word = 0; word < ctx.bitmap_words; ++word) {
+      u64 bits = ctx.starts[word];
+      while (bits) {
+        u8 *obj = vm->heap + (word * 64 + __builtin_ctzll(bits)) * 8;
+        bits &= bits - 1;
+        set_object_start(vm, forwarding_offset(&ctx, obj));
+      }
+    }
+  }
 
-    bool is_monitor = (uintptr_t)obj & 1;
-    size_t sz = is_monitor ? sizeof(monitor_data) : size_of_object(obj);
-    sz = align_up(sz, 8);
-    obj = (void *)((uintptr_t)obj & ~1ULL); // get the actual underlying pointer
-    DCHECK(write_ptr + sz <= end);
-    if (!is_monitor) {
-      *get_flags(vm, obj) &= ~IS_REACHABLE; // clear the reachable flag
+  free(ctx.starts);
+  free(ctx.live);
+  free(ctx.block_offsets);
+
+  // Re-establish that free memory is zero: clear the garbage left behind in the heap, or everything past the survivors
+  // in a fresh allocation. Fresh mappings and newly committed pages are zero already.
+  size_t live_bytes = live_granules * 8;
+  if (new_heap != vm->heap) {
+    unmap_heap(vm, vm->heap);
+    if (!RESERVE_HEAP)
+      memset(new_heap + live_bytes, 0, capacity + slop - live_bytes);
+  } else {
+    zero_range(vm->heap, live_bytes, vm->heap_used);
+    if (vm->nursery_capacity) {
+      size_t nursery_garbage = vm->nursery_start > live_bytes ? vm->nursery_start : live_bytes;
+      zero_range(vm->heap, nursery_garbage, vm->nursery_start + vm->nursery_used);
     }
-    memmove(write_ptr, obj, sz); // not memcpy because the heap is the same; overlap is possible
-    object new_obj = (object)write_ptr;
-    new_location[i] = new_obj;
-    write_ptr += sz;
+#if RESERVE_HEAP
+    if (capacity < vm->heap_capacity)
+      recommit_heap(vm->heap, vm->true_heap_capacity, capacity + slop);
+#endif
   }
 
-  // Go through all static and instance fields and rewrite in place
-  relocate_instance_fields(&ctx);
-  for (int i = 0; i < arrlen(ctx.roots); ++i) {
-    object *obj = ctx.roots[i];
-    relocate_object(&ctx, obj);
+  // The nursery is now empty. If the survivors spilled into it, it shrinks until the next major GC.
+  if (vm->nursery_capacity) {
+    memset(vm->card_table, 0, vm->true_heap_capacity / CARD_BYTES + 1);
+    vm->nursery_used = 0;
+    size_t nursery_start = capacity - vm->nursery_capacity;
+    vm->nursery_start = nursery_start > live_bytes ? nursery_start : live_bytes;
   }
 
-  arrfree(ctx.objs);
-  free(ctx.new_location);
+  vm->heap = new_heap;
+  vm->heap_used = live_bytes;
+  vm->heap_capacity = capacity;
+  vm->true_heap_capacity = capacity + slop;
+  vm->minor_gc_us = 0;
+  vm->last_major_gc_end_us = get_unix_us();
+  vm->clear_soft_references = capacity == vm->max_heap_capacity && live_bytes * 100 > capacity * GROW_LIVE_PERCENT;
+}
+
+void major_gc(vm *vm) { collect(vm, false, 0, false); }
+
+void major_gc_for_allocation(vm *vm, size_t bytes, bool clear_soft_references) {
+  collect(vm, true, bytes, clear_soft_references);
+}
+
+void visit_vm_roots(vm *vm, void (*visit)(void *arg, object *root), void *arg) {
+  gc_ctx ctx = {.vm = vm};
+  enumerate_vm_roots(&ctx);
+  for (int i = 0; i < arrlen(ctx.roots); ++i) {
+    visit(arg, ctx.roots[i]);
+  }
   arrfree(ctx.roots);
-  arrfree(ctx.relocations);
+}
 
-#if NEW_HEAP_EACH_GC
-  free(vm->heap);
-#endif
+void visit_reachable_objects(vm *vm, void (*visit)(void *arg, object obj), void *arg) {
+  gc_ctx ctx = {.vm = vm, .mark_limit = vm->true_heap_capacity};
+  init_mark_bitmaps(&ctx);
+  major_gc_enumerate_gc_roots(&ctx);
+  for (int i = 0; i < arrlen(ctx.roots); ++i) {
+    mark_object(&ctx, &ctx.worklist, *ctx.roots[i]);
+  }
+  drain_worklist(&ctx);
+  // Weakly reachable objects too, as they're still there for all the program knows
+  for (int i = 0; i < arrlen(ctx.discovered); ++i) {
+    mark_object(&ctx, &ctx.worklist, ((struct native_Reference *)ctx.discovered[i])->referent);
+    drain_worklist(&ctx);
+  }
 
-  vm->heap = new_heap;
-  vm->heap_used = align_up(write_ptr - new_heap, 8);
-}
\ No newline at end of file
+  // Free space can't be told apart from objects by looking at the heap, so walk the mark bitmap instead
+  for (size_t word = 0; word < ctx.bitmap_words; ++word) {
+    u64 bits = ctx.starts[word];
+    while (bits) {
+      visit(arg, (object)(vm->heap + (word * 64 + __builtin_ctzll(bits)) * 8));
+      bits &= bits - 1;
+    }
+  }
+  arrfree(ctx.roots);
+  free_mark_state(&ctx);
+}
@@ -3,8 +3,74 @@
 
 #include <bjvm.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 int in_heap(const vm *vm, object field);
 void major_gc(vm *vm);
+// Major GC triggered by an allocation failing. Besides resizing the heap like major_gc, this grows it if collections
+// are taking up too much time, and makes room for an allocation of the given size if the maximum heap size allows.
+// Softly reachable objects are freed if clear_soft_references is set, or if the heap was nearly full last time.
+void major_gc_for_allocation(vm *vm, size_t bytes, bool clear_soft_references);
+
+// Reserve and commit the heap described by the capacities in the VM. Returns -1 if out of memory.
+int init_heap(vm *vm);
+// Also releases the static field area, if any
+void release_heap(vm *vm);
+#if COMPRESSED_REFS
+// Zeroed memory for the static fields of a class, which (unlike an arena allocation) can be referred to by a
+// heap_ref. Lives until the VM is freed. Returns null if out of memory.
+void *allocate_static_fields(vm *vm, size_t bytes);
+#endif
 size_t size_of_object(obj_header *obj);
 
-#endif
\ No newline at end of file
+// Set up the nursery, card table and object start bitmap for a freshly created VM. Returns -1 if out of memory.
+int init_generational_heap(vm *vm, size_t nursery_size);
+void free_generational_heap(vm *vm);
+
+// If a major GC is marking incrementally, mark for up to vm->gc_pause_budget_us, or finish the collection if marking
+// is done. Called between scheduler steps.
+void incremental_gc_step(vm *vm);
+
+// Promote all live objects in the nursery into the compacting space. Returns -1 (without doing anything) if the
+// compacting space can't be guaranteed to hold all survivors, in which case a major GC should be done instead.
+int minor_gc(vm *vm);
+
+// Free heap memory -- everything past the allocation pointers of the compacting space and nursery, up to the true
+// heap capacity -- is kept zeroed by the collectors, so allocation never needs to clear memory.
+[[maybe_unused]] static bool heap_is_zeroed(const void *ptr, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    if (((const u8 *)ptr)[i])
+      return false;
+  }
+  return true;
+}
+
+// For inspecting the heap between collections, e.g. to dump it. Calls visit with the address of every root except those
+// on thread stacks (static fields, interned strings, JS handles...).
+void visit_vm_roots(vm *vm, void (*visit)(void *arg, object *root), void *arg);
+// Calls visit with every object reachable from the roots, following references of all strengths, in address order.
+void visit_reachable_objects(vm *vm, void (*visit)(void *arg, object obj), void *arg);
+
+// Record the start of an object placed directly in the compacting space (outside of a collection).
+void record_object_start(vm *vm, object obj);
+
+static inline bool in_nursery(const vm *vm, object obj) {
+  return vm->nursery_capacity && (u8 *)obj >= vm->heap + vm->nursery_start &&
+         (u8 *)obj < vm->heap + vm->true_heap_capacity;
+}
+
+// Must be called after a reference is stored into a heap object, so that the next minor GC sees the store if the
+// object lives in the compacting space. A no-op if generational collection is disabled (nursery_start is 0).
+static inline void gc_write_barrier(vm *vm, object holder) {
+  size_t offset = (u8 *)holder - vm->heap;
+  if (offset < vm->nursery_start)
+    vm->card_table[offset / CARD_BYTES] = 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
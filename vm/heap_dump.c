@@ -0,0 +1,445 @@
+// Heap dumps in the HPROF format. See https://github.com/openjdk/jdk/blob/master/src/hotspot/share/services/heapDumper.cpp
+// for a description of the records.
+
+#include "heap_dump.h"
+
+#include "analysis.h"
+#include "arrays.h"
+#include "gc.h"
+#include "objects.h"
+
+#include <stdio.h>
+
+// Top-level record tags
+enum {
+  HPROF_UTF8 = 0x01,
+  HPROF_LOAD_CLASS = 0x02,
+  HPROF_FRAME = 0x04,
+  HPROF_TRACE = 0x05,
+  HPROF_HEAP_DUMP_SEGMENT = 0x1C,
+  HPROF_HEAP_DUMP_END = 0x2C,
+};
+
+// Sub-record tags within a heap dump segment
+enum {
+  HPROF_GC_ROOT_UNKNOWN = 0xFF,
+  HPROF_GC_ROOT_JNI_LOCAL = 0x02,
+  HPROF_GC_ROOT_JAVA_FRAME = 0x03,
+  HPROF_GC_ROOT_THREAD_OBJ = 0x08,
+  HPROF_GC_CLASS_DUMP = 0x20,
+  HPROF_GC_INSTANCE_DUMP = 0x21,
+  HPROF_GC_OBJ_ARRAY_DUMP = 0x22,
+  HPROF_GC_PRIM_ARRAY_DUMP = 0x23,
+};
+
+static const u8 hprof_basic_types[] = {
+    [TYPE_KIND_BOOLEAN] = 4, [TYPE_KIND_CHAR] = 5,  [TYPE_KIND_FLOAT] = 6, [TYPE_KIND_DOUBLE] = 7,    [TYPE_KIND_BYTE] = 8,
+    [TYPE_KIND_SHORT] = 9,   [TYPE_KIND_INT] = 10,  [TYPE_KIND_LONG] = 11, [TYPE_KIND_REFERENCE] = 2,
+};
+
+// Record lengths are 32 bits, so the heap dump is split into segments of about this size
+#define SEGMENT_BYTES (1 << 30)
+
+// Allocation sites aren't tracked, so objects and classes all get this empty stack trace. Thread i has serial number
+// i + 1, and the trace of its stack has serial number i + 2.
+#define UNKNOWN_TRACE 1
+
+typedef struct {
+  vm *vm;
+  u8 *out;             // stb_ds array
+  size_t record_start; // offset of the record being written
+  bool in_heap_dump;
+
+  // IDs of UTF8 records and stack frames
+  u64 next_id;
+  string_hash_table strings;
+
+  // Serial numbers of the classes to dump, and the classes in order of serial number (starting at 1)
+  struct {
+    classdesc *key;
+    u32 value;
+  } *class_serials;
+  classdesc **classes;
+
+  // Reachable objects in address order
+  object *objects;
+} hprof_writer;
+
+static void put_u1(hprof_writer *w, u8 value) { arrput(w->out, value); }
+
+static void put_u2(hprof_writer *w, u16 value) {
+  put_u1(w, value >> 8);
+  put_u1(w, value);
+}
+
+static void put_u4(hprof_writer *w, u32 value) {
+  put_u2(w, value >> 16);
+  put_u2(w, value);
+}
+
+static void put_u8(hprof_writer *w, u64 value) {
+  put_u4(w, value >> 32);
+  put_u4(w, value);
+}
+
+// IDs are the size of a pointer. Objects are identified by their address, and classes by their classdesc.
+static void put_id(hprof_writer *w, uintptr_t id) {
+  if (sizeof(id) == 8)
+    put_u8(w, id);
+  else
+    put_u4(w, id);
+}
+
+static void put_value(hprof_writer *w, const void *value, type_kind kind) {
+  switch (sizeof_type_kind(kind)) {
+  case 1:
+    put_u1(w, *(const u8 *)value);
+    break;
+  case 2:
+    put_u2(w, *(const u16 *)value);
+    break;
+  case 4:
+    put_u4(w, *(const u32 *)value);
+    break;
+  default:
+    put_u8(w, *(const u64 *)value);
+    break;
+  }
+}
+
+static void begin_record(hprof_writer *w, u8 tag) {
+  w->record_start = arrlenu(w->out);
+  put_u1(w, tag);
+  put_u4(w, 0); // microseconds since the header's timestamp
+  put_u4(w, 0); // length, filled in by end_record
+}
+
+static void end_record(hprof_writer *w) {
+  size_t length = arrlenu(w->out) - w->record_start - 9;
+  u8 *field = w->out + w->record_start + 5;
+  for (int i = 0; i < 4; ++i) {
+    field[i] = length >> (24 - 8 * i);
+  }
+}
+
+// Returns the ID of a UTF8 record with the given contents, writing one if need be. UTF8 records can't be nested in
+// others, so this must be called before starting the record that refers to the string.
+static u64 string_id(hprof_writer *w, slice str) {
+  void *existing = hash_table_lookup(&w->strings, str.chars, (int)str.len);
+  if (existing)
+    return (uintptr_t)existing;
+  DCHECK(!w->in_heap_dump);
+  u64 id = w->next_id++;
+  (void)hash_table_insert(&w->strings, str.chars, (int)str.len, (void *)(uintptr_t)id);
+  begin_record(w, HPROF_UTF8);
+  put_id(w, id);
+  memcpy(arraddnptr(w->out, str.len), str.chars, str.len);
+  end_record(w);
+  return id;
+}
+
+static classdesc *super_of(const classdesc *desc) { return desc->super_class ? desc->super_class->classdesc : nullptr; }
+
+// Add the class and its superclasses to those to be dumped
+static void add_class(hprof_writer *w, classdesc *desc) {
+  for (; desc && hmgeti(w->class_serials, desc) < 0; desc = super_of(desc)) {
+    hmput(w->class_serials, desc, arrlen(w->classes) + 1);
+    arrput(w->classes, desc);
+  }
+}
+
+static u32 class_serial(hprof_writer *w, classdesc *desc) { return hmget(w->class_serials, desc); }
+
+static void add_object(void *arg, object obj) {
+  hprof_writer *w = arg;
+  arrput(w->objects, obj);
+  add_class(w, obj->descriptor);
+}
+
+static void write_load_class(hprof_writer *w, classdesc *desc) {
+  u64 name = string_id(w, desc->name);
+  begin_record(w, HPROF_LOAD_CLASS);
+  put_u4(w, class_serial(w, desc));
+  put_id(w, (uintptr_t)desc);
+  put_u4(w, UNKNOWN_TRACE);
+  put_id(w, name);
+  end_record(w);
+
+  for (int i = 0; i < desc->fields_count; ++i) {
+    string_id(w, desc->fields[i].name);
+  }
+}
+
+static void write_trace(hprof_writer *w, u32 serial, u32 thread_serial, const u64 *frame_ids) {
+  begin_record(w, HPROF_TRACE);
+  put_u4(w, serial);
+  put_u4(w, thread_serial);
+  put_u4(w, arrlen(frame_ids));
+  for (int i = 0; i < arrlen(frame_ids); ++i) {
+    put_id(w, frame_ids[i]);
+  }
+  end_record(w);
+}
+
+static void write_thread_trace(hprof_writer *w, int thread_index) {
+  u64 *frame_ids = nullptr;
+  for (stack_frame *frame = w->vm->active_threads[thread_index]->stack.top; frame; frame = frame->prev) {
+    cp_method *method = frame->method;
+    classdesc *desc = method->my_class;
+    u64 name = string_id(w, method->name), signature = string_id(w, method->unparsed_descriptor);
+    u64 source = desc->source_file ? string_id(w, desc->source_file->name) : 0;
+    int line = is_frame_native(frame) ? -3 : get_line_number(method->code, frame->program_counter);
+
+    u64 id = w->next_id++;
+    begin_record(w, HPROF_FRAME);
+    put_id(w, id);
+    put_id(w, name);
+    put_id(w, signature);
+    put_id(w, source);
+    put_u4(w, class_serial(w, desc));
+    put_u4(w, line);
+    end_record(w);
+    arrput(frame_ids, id);
+  }
+  write_trace(w, thread_index + 2, thread_index + 1, frame_ids);
+  arrfree(frame_ids);
+}
+
+static void write_root(hprof_writer *w, u8 tag, object obj) {
+  put_u1(w, tag);
+  put_id(w, (uintptr_t)obj);
+}
+
+static void write_unknown_root(void *arg, object *root) { write_root(arg, HPROF_GC_ROOT_UNKNOWN, *root); }
+
+// Like push_thread_roots in gc.c, but noting which frame each reference is in
+static void write_thread_roots(hprof_writer *w, int thread_index) {
+  vm_thread *thread = w->vm->active_threads[thread_index];
+  u32 serial = thread_index + 1;
+  if (thread->thread_obj) {
+    write_root(w, HPROF_GC_ROOT_THREAD_OBJ, (object)thread->thread_obj);
+    put_u4(w, serial);
+    put_u4(w, thread_index + 2);
+  }
+
+  object others[] = {thread->current_exception, thread->out_of_mem_error, thread->stack_overflow_error};
+  for (size_t i = 0; i < sizeof(others) / sizeof(others[0]); ++i) {
+    if (others[i])
+      write_root(w, HPROF_GC_ROOT_UNKNOWN, others[i]);
+  }
+
+  for (int i = 0; i < thread->handles_capacity; ++i) {
+    if (thread->handles[i].obj && in_heap(w->vm, thread->handles[i].obj)) {
+      write_root(w, HPROF_GC_ROOT_JNI_LOCAL, thread->handles[i].obj);
+      put_u4(w, serial);
+      put_u4(w, -1); // not associated with a frame
+    }
+  }
+
+  u32 depth = 0;
+  for (stack_frame *frame = thread->stack.top; frame; frame = frame->prev, ++depth) {
+    if (is_frame_native(frame))
+      continue;
+    stack_summary *ss = frame->method->code_analysis->stack_states[frame->program_counter];
+    for (int i = 0; i < ss->stack + ss->locals; ++i) {
+      if (ss->entries[i] != TYPE_KIND_REFERENCE)
+        continue;
+      object obj = i < ss->stack ? frame->stack[i].obj : frame_locals(frame)[i - ss->stack].obj;
+      if (obj && in_heap(w->vm, obj)) {
+        write_root(w, HPROF_GC_ROOT_JAVA_FRAME, obj);
+        put_u4(w, serial);
+        put_u4(w, depth);
+      }
+    }
+  }
+}
+
+static void write_class_dump(hprof_writer *w, classdesc *desc) {
+  put_u1(w, HPROF_GC_CLASS_DUMP);
+  put_id(w, (uintptr_t)desc);
+  put_u4(w, UNKNOWN_TRACE);
+  put_id(w, (uintptr_t)super_of(desc));
+  put_id(w, (uintptr_t)desc->classloader);
+  put_id(w, 0); // signers
+  put_id(w, 0); // protection domain
+  put_id(w, 0); // reserved
+  put_id(w, 0); // reserved
+  put_u4(w, desc->kind == CD_KIND_ORDINARY ? desc->instance_bytes : 0);
+  put_u2(w, 0); // constant pool entries
+
+  int statics = 0, instance_fields = 0;
+  for (int i = 0; i < desc->fields_count; ++i) {
+    if (!(desc->fields[i].access_flags & ACCESS_STATIC))
+      ++instance_fields;
+    else if (desc->static_fields) // the values are only there once the class is linked
+      ++statics;
+  }
+  put_u2(w, statics);
+  for (int i = 0; i < desc->fields_count && statics; ++i) {
+    cp_field *field = desc->fields + i;
+    if (field->access_flags & ACCESS_STATIC) {
+      type_kind kind = field->parsed_descriptor.repr_kind;
+      put_id(w, string_id(w, field->name));
+      put_u1(w, hprof_basic_types[kind]);
+      put_value(w, desc->static_fields + field->byte_offset, kind);
+    }
+  }
+  put_u2(w, instance_fields);
+  for (int i = 0; i < desc->fields_count; ++i) {
+    cp_field *field = desc->fields + i;
+    if (!(field->access_flags & ACCESS_STATIC)) {
+      put_id(w, string_id(w, field->name));
+      put_u1(w, hprof_basic_types[field->parsed_descriptor.repr_kind]);
+    }
+  }
+}
+
+// Field values are written for the object's class, then its superclass, and so on, in the same order as the fields
+// of the class dumps
+static void write_instance_dump(hprof_writer *w, object obj) {
+  u32 bytes = 0;
+  for (classdesc *desc = obj->descriptor; desc; desc = super_of(desc)) {
+    for (int i = 0; i < desc->fields_count; ++i) {
+      if (!(desc->fields[i].access_flags & ACCESS_STATIC))
+        bytes += sizeof_type_kind(desc->fields[i].parsed_descriptor.repr_kind);
+    }
+  }
+
+  put_u1(w, HPROF_GC_INSTANCE_DUMP);
+  put_id(w, (uintptr_t)obj);
+  put_u4(w, UNKNOWN_TRACE);
+  put_id(w, (uintptr_t)obj->descriptor);
+  put_u4(w, bytes);
+  for (classdesc *desc = obj->descriptor; desc; desc = super_of(desc)) {
+    for (int i = 0; i < desc->fields_count; ++i) {
+      cp_field *field = desc->fields + i;
+      if (field->access_flags & ACCESS_STATIC)
+        continue;
+      if (field->parsed_descriptor.repr_kind == TYPE_KIND_REFERENCE)
+        put_id(w, (uintptr_t)load_ref_slot((u8 *)obj + field->byte_offset, desc->compressed_fields));
+      else
+        put_value(w, (u8 *)obj + field->byte_offset, field->parsed_descriptor.repr_kind);
+    }
+  }
+}
+
+static void write_array_dump(hprof_writer *w, object array) {
+  classdesc *desc = array->descriptor;
+  int length = ArrayLength(array);
+  if (desc->kind == CD_KIND_ORDINARY_ARRAY || desc->dimensions > 1) {
+    put_u1(w, HPROF_GC_OBJ_ARRAY_DUMP);
+    put_id(w, (uintptr_t)array);
+    put_u4(w, UNKNOWN_TRACE);
+    put_u4(w, length);
+    put_id(w, (uintptr_t)desc);
+    for (int i = 0; i < length; ++i) {
+      put_id(w, (uintptr_t)ReferenceArrayLoad(array, i));
+    }
+    return;
+  }
+
+  type_kind kind = desc->primitive_component;
+  int size = sizeof_type_kind(kind);
+  put_u1(w, HPROF_GC_PRIM_ARRAY_DUMP);
+  put_id(w, (uintptr_t)array);
+  put_u4(w, UNKNOWN_TRACE);
+  put_u4(w, length);
+  put_u1(w, hprof_basic_types[kind]);
+  if (size == 1) {
+    memcpy(arraddnptr(w->out, length), ArrayData(array), length);
+    return;
+  }
+  for (int i = 0; i < length; ++i) {
+    put_value(w, (u8 *)ArrayData(array) + i * size, kind);
+  }
+}
+
+static void write_heap_dump_records(hprof_writer *w) {
+  vm *vm = w->vm;
+
+  // Header
+  const char *format = "JAVA PROFILE 1.0.2";
+  memcpy(arraddnptr(w->out, strlen(format) + 1), format, strlen(format) + 1);
+  put_u4(w, sizeof(void *));
+  put_u8(w, get_unix_us() / 1000);
+
+  // Find everything to be dumped: the reachable objects, their classes, the bootstrap classes (for their static
+  // fields) and the classes of methods on the stack
+  visit_reachable_objects(vm, add_object, w);
+  hash_table_iterator it = hash_table_get_iterator(&vm->classes);
+  char *key;
+  size_t key_len;
+  classdesc *desc;
+  while (hash_table_iterator_has_next(it, &key, &key_len, (void **)&desc)) {
+    add_class(w, desc);
+    hash_table_iterator_next(&it);
+  }
+  for (int i = 0; i < arrlen(vm->active_threads); ++i) {
+    for (stack_frame *frame = vm->active_threads[i]->stack.top; frame; frame = frame->prev) {
+      add_class(w, frame->method->my_class);
+    }
+  }
+
+  for (int i = 0; i < arrlen(w->classes); ++i) {
+    write_load_class(w, w->classes[i]);
+  }
+  write_trace(w, UNKNOWN_TRACE, 0, nullptr);
+  for (int i = 0; i < arrlen(vm->active_threads); ++i) {
+    write_thread_trace(w, i);
+  }
+
+  w->in_heap_dump = true;
+  begin_record(w, HPROF_HEAP_DUMP_SEGMENT);
+  visit_vm_roots(vm, write_unknown_root, w);
+  for (int i = 0; i < arrlen(vm->active_threads); ++i) {
+    write_thread_roots(w, i);
+  }
+  for (int i = 0; i < arrlen(w->classes); ++i) {
+    write_class_dump(w, w->classes[i]);
+  }
+  for (int i = 0; i < arrlen(w->objects); ++i) {
+    if (arrlenu(w->out) - w->record_start > SEGMENT_BYTES) {
+      end_record(w);
+      begin_record(w, HPROF_HEAP_DUMP_SEGMENT);
+    }
+    object obj = w->objects[i];
+    if (obj->descriptor->kind == CD_KIND_ORDINARY)
+      write_instance_dump(w, obj);
+    else
+      write_array_dump(w, obj);
+  }
+  end_record(w);
+  begin_record(w, HPROF_HEAP_DUMP_END);
+  end_record(w);
+}
+
+// Returns the dump as an stb_ds array
+static u8 *dump(vm *vm) {
+  hprof_writer w = {.vm = vm, .next_id = 1, .strings = make_hash_table(nullptr, 0.75, 256)};
+  write_heap_dump_records(&w);
+  free_hash_table(w.strings);
+  hmfree(w.class_serials);
+  arrfree(w.classes);
+  arrfree(w.objects);
+  return w.out;
+}
+
+u8 *heap_dump(vm *vm, size_t *length) {
+  u8 *out = dump(vm);
+  *length = arrlenu(out);
+  u8 *result = malloc(*length);
+  if (result)
+    memcpy(result, out, *length);
+  arrfree(out);
+  return result;
+}
+
+int write_heap_dump(vm *vm, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (!file)
+    return -1;
+  u8 *out = dump(vm);
+  bool ok = fwrite(out, 1, arrlenu(out), file) == arrlenu(out);
+  arrfree(out);
+  return fclose(file) == 0 && ok ? 0 : -1;
+}
@@ -0,0 +1,24 @@
+#ifndef HEAP_DUMP_H
+#define HEAP_DUMP_H
+
+#include <bjvm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Dump the reachable objects in the heap, along with the classes, GC roots and thread stacks, in the HPROF format of
+// jmap (readable by VisualVM, Eclipse MAT, etc.). Returns a buffer, to be freed with free, and writes its length to
+// *length. Must not be called during a collection.
+EMSCRIPTEN_KEEPALIVE
+u8 *heap_dump(vm *vm, size_t *length);
+
+// Write a heap dump to the given file. Returns -1 if the file couldn't be written.
+EMSCRIPTEN_KEEPALIVE
+int write_heap_dump(vm *vm, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -908,7 +908,7 @@ static s64 putstatic_Z_impl_int(ARGS_INT) {
 
 /** getfield/putfield */
 
-insn_code_kind getfield_putfield_resolved_kind(bool putfield, type_kind field_kind) {
+insn_code_kind getfield_putfield_resolved_kind(bool putfield, type_kind field_kind, bool narrow) {
   switch (field_kind) {
   case TYPE_KIND_BOOLEAN:
     return putfield ? insn_putfield_B : insn_getfield_B;
@@ -927,6 +927,8 @@ insn_code_kind getfield_putfield_resolved_kind(bool putfield, type_kind field_ki
   case TYPE_KIND_LONG:
     return putfield ? insn_putfield_J : insn_getfield_J;
   case TYPE_KIND_REFERENCE:
+    if (narrow)
+      return putfield ? insn_putfield_N : insn_getfield_N;
     return putfield ? insn_putfield_L : insn_getfield_L;
   default:
     UNREACHABLE();
@@ -959,7 +961,8 @@ DEFINE_ASYNC(resolve_getfield_putfield) {
     ASYNC_RETURN(-1);
   }
 
-  inst->kind = getfield_putfield_resolved_kind(putfield, field_info->parsed_descriptor->repr_kind);
+  inst->kind = getfield_putfield_resolved_kind(putfield, field_info->parsed_descriptor->repr_kind,
+                                               field_info->field->my_class->compressed_fields);
   inst->ic = field_info->field;
   inst->ic2 = (void *)field_info->field->byte_offset;
 
@@ -1046,6 +1049,13 @@ static s64 getfield_L_impl_int(ARGS_INT) {
   NEXT_INT(*field)
 }
 
+static s64 getfield_N_impl_int(ARGS_INT) {
+  DEBUG_CHECK();
+  NPE_ON_NULL(tos);
+  obj_header *field = load_ref((char *)tos + (size_t)insn->ic2);
+  NEXT_INT(field)
+}
+
 static s64 getfield_Z_impl_int(ARGS_INT) {
   DEBUG_CHECK();
   NPE_ON_NULL(tos);
@@ -1109,6 +1119,17 @@ static s64 putfield_L_impl_int(ARGS_INT) {
   NPE_ON_NULL(obj);
   obj_header **field = (obj_header **)((char *)obj + (size_t)insn->ic2);
   *field = (obj_header *)tos;
+  gc_write_barrier(thread->vm, obj);
+  sp -= 2;
+  STACK_POLYMORPHIC_NEXT(*(sp - 1));
+}
+
+static s64 putfield_N_impl_int(ARGS_INT) {
+  DEBUG_CHECK();
+  obj_header *obj = (sp - 2)->obj;
+  NPE_ON_NULL(obj);
+  store_ref((char *)obj + (size_t)insn->ic2, (obj_header *)tos);
+  gc_write_barrier(thread->vm, obj);
   sp -= 2;
   STACK_POLYMORPHIC_NEXT(*(sp - 1));
 }
@@ -1382,7 +1403,7 @@ static s64 aastore_impl_int(ARGS_INT) {
     raise_array_store_exception(thread, value->descriptor->name);
     return 0;
   }
-  ReferenceArrayStore(array, index, value);
+  ReferenceArrayStore(thread, array, index, value);
   sp -= 3;
   STACK_POLYMORPHIC_NEXT(*(sp - 1));
 }
@@ -1487,26 +1508,11 @@ static s64 tableswitch_impl_int(ARGS_INT) {
 
 static s64 lookupswitch_impl_int(ARGS_INT) {
   DEBUG_CHECK();
-  struct lookupswitch_data data = *insn->lookupswitch;
-
-  s32 key = (s32)tos;
-  s32 *keys = data.keys;
-  s32 *offsets = data.targets;
-  s32 n = data.keys_count;
-  s32 default_target = data.default_target;
-  // Look through keys one by one
-  for (int i = 0; i < n; i++) {
-    if (keys[i] == key) {
-      int delta = (offsets[i] - 1) - pc;
-      pc = offsets[i] - 1;
-      insns += delta;
-      sp--;
-      STACK_POLYMORPHIC_NEXT(*(sp - 1));
-    }
-  }
-  // No key found, jump to default
-  int delta = (default_target - 1) - pc;
-  pc = default_target - 1;
+  const struct lookupswitch_data *data = insn->lookupswitch;
+  int i = lookupswitch_index(data, (s32)tos);
+  int target = i < data->keys_count ? data->targets[i] : data->default_target;
+  int delta = (target - 1) - pc;
+  pc = target - 1;
   insns += delta;
   sp--;
   STACK_POLYMORPHIC_NEXT(*(sp - 1));
@@ -1650,7 +1656,7 @@ FORWARD_TO_NULLARY(new)
 static s64 new_resolved_impl_void(ARGS_VOID) {
   DEBUG_CHECK();
   SPILL_VOID
-  obj_header *obj = new_object(thread, insn->classdesc);
+  obj_header *obj = AllocateObject(thread, insn->classdesc, insn->classdesc->instance_bytes);
   if (!obj)
     return 0;
 
@@ -1667,7 +1673,16 @@ static s64 newarray_impl_int(ARGS_INT) {
     raise_negative_array_size_exception(thread, count);
     return 0;
   }
-  obj_header *array = CreatePrimitiveArray1D(thread, insn->array_type, count);
+  // The inline cache holds the array class once the slow path has created it
+  classdesc *array_desc = insn->ic;
+  obj_header *array;
+  if (likely(array_desc)) {
+    array = AllocateArray(thread, array_desc, count, sizeof_type_kind(insn->array_type));
+  } else {
+    array = CreatePrimitiveArray1D(thread, insn->array_type, count);
+    if (array)
+      insn->ic = array->descriptor;
+  }
   if (unlikely(!array)) {
     return 0; // oom
   }
@@ -1699,7 +1714,9 @@ static s64 anewarray_resolved_impl_int(ARGS_INT) {
     raise_negative_array_size_exception(thread, count);
     return 0;
   }
-  obj_header *array = CreateObjectArray1D(thread, insn->classdesc, count);
+  classdesc *array_desc = insn->classdesc->array_type;
+  obj_header *array = array_desc ? AllocateArray(thread, array_desc, count, sizeof(heap_ref))
+                                 : CreateObjectArray1D(thread, insn->classdesc, count);
   if (array) {
     NEXT_INT(array)
   }
@@ -1719,15 +1736,12 @@ static s64 multianewarray_impl_int(ARGS_INT) {
 
 /** Method invocations */
 
-static int intrinsify(bytecode_insn *inst) {
-  cp_method *method = inst->ic;
-  if (utf8_equals(method->my_class->name, "java/lang/Math")) {
-    if (utf8_equals(method->name, "sqrt")) {
-      inst->kind = insn_sqrt;
-      return 1;
-    }
-  }
-  return 0;
+// Replace a resolved call with the intrinsic instruction for the called method, if it has one
+static int intrinsify(bytecode_insn *inst, const cp_method *method) {
+  if (method->intrinsic == insn_nop)
+    return 0;
+  inst->kind = method->intrinsic;
+  return 1;
 }
 
 DEFINE_ASYNC(resolve_invokestatic) {
@@ -1753,7 +1767,7 @@ __attribute__((noinline)) static s64 invokestatic_impl_void(ARGS_VOID) {
   if (thread->current_exception)
     return 0;
 
-  if (intrinsify(insn)) {
+  if (intrinsify(insn, insn->ic)) {
     STACK_POLYMORPHIC_JMP(*(sp - 1));
   }
 
@@ -1823,6 +1837,125 @@ void attempt_jit(cp_method *method) {
     method->call_count += 15;                                                                                          \
   }
 
+// Execute a method recognized by classify_trivial_method without pushing a frame, writing any result over the first
+// argument. The receiver, if any, must already have been checked to be non-null. Returns false if the method has to be
+// invoked normally after all, e.g. because the field it accesses hasn't been resolved yet (resolution may throw, and
+// the exception's stack trace should include the method), or because we're single stepping through it.
+static bool invoke_trivial(vm_thread *thread, const cp_method *method, stack_value *args) {
+  if (unlikely(thread->is_single_stepping))
+    return false;
+  const bytecode_insn *code = method->code->code;
+  switch (method->trivial) {
+  case TRIVIAL_METHOD_EMPTY:
+    return true;
+  case TRIVIAL_METHOD_CONSTANT:
+    switch (code[0].kind) {
+    case insn_iconst:
+      args[0].i = (int)code[0].integer_imm;
+      return true;
+    case insn_lconst:
+      args[0].l = code[0].integer_imm;
+      return true;
+    case insn_fconst:
+      args[0].f = code[0].f_imm;
+      return true;
+    case insn_dconst:
+      args[0].d = code[0].d_imm;
+      return true;
+    case insn_aconst_null:
+      args[0].obj = nullptr;
+      return true;
+    default:
+      return false;
+    }
+  case TRIVIAL_METHOD_GETTER: {
+    const bytecode_insn *get = &code[1];
+    char *field = (char *)args[0].obj + (size_t)get->ic2;
+    switch (get->kind) {
+    case insn_getfield_B:
+    case insn_getfield_Z:
+      args[0].i = *(s8 *)field;
+      return true;
+    case insn_getfield_C:
+      args[0].i = *(u16 *)field;
+      return true;
+    case insn_getfield_S:
+      args[0].i = *(s16 *)field;
+      return true;
+    case insn_getfield_I:
+      args[0].i = *(int *)field;
+      return true;
+    case insn_getfield_J:
+      args[0].l = *(s64 *)field;
+      return true;
+    case insn_getfield_F:
+      args[0].f = *(float *)field;
+      return true;
+    case insn_getfield_D:
+      args[0].d = *(double *)field;
+      return true;
+    case insn_getfield_L:
+      args[0].obj = *(obj_header **)field;
+      return true;
+    case insn_getfield_N:
+      args[0].obj = load_ref(field);
+      return true;
+    default:
+      return false;
+    }
+  }
+  case TRIVIAL_METHOD_SETTER: {
+    const bytecode_insn *put = &code[2];
+    obj_header *obj = args[0].obj;
+    char *field = (char *)obj + (size_t)put->ic2;
+    switch (put->kind) {
+    case insn_putfield_B:
+    case insn_putfield_Z:
+      *(s8 *)field = (s8)args[1].i;
+      return true;
+    case insn_putfield_C:
+      *(u16 *)field = (u16)args[1].i;
+      return true;
+    case insn_putfield_S:
+      *(s16 *)field = (s16)args[1].i;
+      return true;
+    case insn_putfield_I:
+      *(int *)field = args[1].i;
+      return true;
+    case insn_putfield_J:
+      *(s64 *)field = args[1].l;
+      return true;
+    case insn_putfield_F:
+      *(float *)field = args[1].f;
+      return true;
+    case insn_putfield_D:
+      *(double *)field = args[1].d;
+      return true;
+    case insn_putfield_L:
+      *(obj_header **)field = args[1].obj;
+      gc_write_barrier(thread->vm, obj);
+      return true;
+    case insn_putfield_N:
+      store_ref(field, args[1].obj);
+      gc_write_barrier(thread->vm, obj);
+      return true;
+    default:
+      return false;
+    }
+  }
+  default:
+    return false;
+  }
+}
+
+// Expects sp, insn and returns to be in scope
+#define ConsiderTrivialInvoke(thread, method)                                                                          \
+  if ((method)->trivial != TRIVIAL_METHOD_NONE && invoke_trivial(thread, method, sp - insn->args)) {                   \
+    sp -= insn->args;                                                                                                  \
+    sp += returns;                                                                                                     \
+    STACK_POLYMORPHIC_NEXT(*(sp - 1))                                                                                  \
+  }
+
 static s64 invokestatic_resolved_impl_void(ARGS_VOID) {
   DEBUG_CHECK();
   cp_method *method = insn->ic;
@@ -1832,6 +1965,7 @@ static s64 invokestatic_resolved_impl_void(ARGS_VOID) {
   if (method->is_signature_polymorphic) {
     invoked_frame = push_native_frame(thread, method, insn->cp->methodref.descriptor, sp - insn->args, insn->args);
   } else {
+    ConsiderTrivialInvoke(thread, method)
     ConsiderJitEntry(thread, method, sp - insn->args)
     invoked_frame = push_frame(thread, method, sp - insn->args, insn->args);
   }
@@ -1903,9 +2037,26 @@ __attribute__((noinline)) static s64 invokevirtual_impl_void(ARGS_VOID) {
     JMP_VOID
   }
 
+  // Intrinsics called virtually (e.g. Object.getClass) can't be overridden
+  if ((method_info->resolved->access_flags & ACCESS_FINAL) && intrinsify(insn, method_info->resolved)) {
+    STACK_POLYMORPHIC_JMP(*(sp - 1));
+  }
+
+  // If no loaded class overrides the method, call it directly (see mark_overridden)
+  bool needs_dependency;
+  if (can_devirtualize(method_info->resolved, receiver->descriptor, &needs_dependency)) {
+    insn->kind = insn_invokevirtual_direct;
+    insn->ic = method_info->resolved;
+    if (needs_dependency)
+      arrput(method_info->resolved->devirtualized_calls, insn);
+    note_cached_class(thread->vm, frame->method->my_class, method_info->resolved->my_class);
+    JMP_VOID
+  }
+
   insn->kind = insn_invokevtable_monomorphic;
   insn->ic = vtable_lookup(receiver->descriptor, method_info->resolved->vtable_index);
   insn->ic2 = receiver->descriptor;
+  note_cached_class(thread->vm, frame->method->my_class, receiver->descriptor);
   JMP_VOID
 }
 FORWARD_TO_NULLARY(invokevirtual)
@@ -1982,6 +2133,7 @@ static s64 invokespecial_resolved_impl_void(ARGS_VOID) {
   NPE_ON_NULL(receiver);
 
   cp_method *receiver_method = insn->ic;
+  ConsiderTrivialInvoke(thread, receiver_method);
   ConsiderJitEntry(thread, receiver_method, sp - insn->args);
 
   stack_frame *invoked_frame = push_frame(thread, receiver_method, sp - insn->args, insn->args);
@@ -2043,26 +2195,51 @@ __attribute__((noinline)) static s64 invokeinterface_impl_void(ARGS_VOID) {
   insn->ic = method;
   insn->ic2 = receiver->descriptor;
   insn->kind = insn_invokeitable_monomorphic;
+  note_cached_class(thread->vm, frame->method->my_class, receiver->descriptor);
   mark_insn_returns(insn);
   JMP_VOID
 }
 FORWARD_TO_NULLARY(invokeinterface)
 
 __attribute__((noinline)) void make_invokevtable_polymorphic_(bytecode_insn *inst) {
-  DCHECK(inst->kind == insn_invokevtable_monomorphic);
-  cp_method *method = inst->ic;
+  DCHECK(inst->kind == insn_invokevtable_monomorphic || inst->kind == insn_invokevtable_pic);
+  cp_method *method = inst->kind == insn_invokevtable_monomorphic ? inst->ic : inst->cp->methodref.resolved;
   DCHECK(method);
   inst->kind = insn_invokevtable_polymorphic;
   inst->ic2 = (void *)method->vtable_index;
 }
 
 __attribute__((noinline)) void make_invokeitable_polymorphic_(bytecode_insn *inst) {
-  DCHECK(inst->kind == insn_invokeitable_monomorphic);
+  DCHECK(inst->kind == insn_invokeitable_monomorphic || inst->kind == insn_invokeitable_pic);
   inst->kind = insn_invokeitable_polymorphic;
   inst->ic = (void *)inst->cp->methodref.resolved->my_class;
   inst->ic2 = (void *)inst->cp->methodref.resolved->itable_index;
 }
 
+__attribute__((noinline)) void make_invoke_polymorphic(bytecode_insn *inst) {
+  if (inst->kind == insn_invokevtable_monomorphic || inst->kind == insn_invokevtable_pic)
+    make_invokevtable_polymorphic_(inst);
+  else
+    make_invokeitable_polymorphic_(inst);
+}
+
+// Turn a monomorphic inline cache which missed into a polymorphic inline cache, starting with the class it cached. The
+// cache comes from those given up by calls in the same class where possible, so that the arena doesn't grow each time
+// a call site cycles through the states.
+__attribute__((noinline)) static void make_invoke_pic(stack_frame *frame, bytecode_insn *inst) {
+  DCHECK(inst->kind == insn_invokevtable_monomorphic || inst->kind == insn_invokeitable_monomorphic);
+  classdesc *caller = frame->method->my_class;
+  polymorphic_ic *pic = caller->unused_pics;
+  if (pic)
+    caller->unused_pics = pic->next_unused;
+  else
+    pic = arena_alloc(&caller->arena, 1, sizeof(polymorphic_ic));
+  *pic = (polymorphic_ic){.receivers = {inst->ic2}, .methods = {inst->ic}, .count = 1};
+  inst->kind = inst->kind == insn_invokevtable_monomorphic ? insn_invokevtable_pic : insn_invokeitable_pic;
+  inst->ic = pic;
+  inst->ic2 = nullptr;
+}
+
 static s64 invokeitable_vtable_monomorphic_impl_void(ARGS_VOID) {
   DEBUG_CHECK();
   obj_header *receiver = (sp - insn->args)->obj;
@@ -2070,13 +2247,11 @@ static s64 invokeitable_vtable_monomorphic_impl_void(ARGS_VOID) {
   SPILL_VOID
   NPE_ON_NULL(receiver);
   if (unlikely(receiver->descriptor != insn->ic2)) {
-    if (insn->kind == insn_invokevtable_monomorphic)
-      make_invokevtable_polymorphic_(insn);
-    else
-      make_invokeitable_polymorphic_(insn);
+    make_invoke_pic(frame, insn);
     JMP_VOID
   }
 
+  ConsiderTrivialInvoke(thread, ((cp_method *)insn->ic));
   ConsiderJitEntry(thread, ((cp_method *)insn->ic), sp - insn->args);
   stack_frame *invoked_frame = push_frame(thread, insn->ic, sp - insn->args, insn->args);
   if (!invoked_frame)
@@ -2096,6 +2271,72 @@ static s64 invokeitable_vtable_monomorphic_impl_void(ARGS_VOID) {
 }
 FORWARD_TO_NULLARY(invokeitable_vtable_monomorphic)
 
+// Look up the method for a receiver class missing from a polymorphic inline cache, and add it if there's room. Returns
+// null if the call should go megamorphic instead (including when the lookup fails, so that the megamorphic path raises
+// the error).
+__attribute__((noinline)) static cp_method *polymorphic_ic_miss(vm_thread *thread, stack_frame *frame,
+                                                                bytecode_insn *inst, classdesc *receiver_class) {
+  polymorphic_ic *pic = inst->ic;
+  pic->misses++;
+  if (pic->count == POLYMORPHIC_IC_WAYS)
+    return nullptr;
+  cp_method *resolved = inst->cp->methodref.resolved;
+  cp_method *method = inst->kind == insn_invokevtable_pic
+                          ? vtable_lookup(receiver_class, resolved->vtable_index)
+                          : itable_lookup(receiver_class, resolved->my_class, resolved->itable_index);
+  if (!method)
+    return nullptr;
+  pic->receivers[pic->count] = receiver_class;
+  pic->methods[pic->count] = method;
+  pic->count++;
+  note_cached_class(thread->vm, frame->method->my_class, receiver_class);
+  return method;
+}
+
+static s64 invokeitable_vtable_pic_impl_void(ARGS_VOID) {
+  DEBUG_CHECK();
+  obj_header *receiver = (sp - insn->args)->obj;
+  bool returns = insn->returns;
+  SPILL_VOID
+  NPE_ON_NULL(receiver);
+
+  polymorphic_ic *pic = insn->ic;
+  cp_method *receiver_method = nullptr;
+  for (int i = 0; i < pic->count; ++i) {
+    if (pic->receivers[i] == receiver->descriptor) {
+      receiver_method = pic->methods[i];
+      break;
+    }
+  }
+  if (likely(receiver_method)) {
+    pic->hits++;
+  } else if (!(receiver_method = polymorphic_ic_miss(thread, frame, insn, receiver->descriptor))) {
+    make_invoke_polymorphic(insn);
+    pic->next_unused = frame->method->my_class->unused_pics;
+    frame->method->my_class->unused_pics = pic;
+    JMP_VOID
+  }
+
+  ConsiderTrivialInvoke(thread, receiver_method);
+  ConsiderJitEntry(thread, receiver_method, sp - insn->args);
+  stack_frame *invoked_frame = push_frame(thread, receiver_method, sp - insn->args, insn->args);
+  if (!invoked_frame)
+    return 0;
+
+  stack_value result = AttemptInvoke(thread, invoked_frame, insn->args, returns);
+  if (thread->current_exception) {
+    return 0;
+  }
+
+  if (returns) {
+    *(sp - insn->args) = result;
+  }
+  sp -= insn->args;
+  sp += returns;
+  STACK_POLYMORPHIC_NEXT(*(sp - 1))
+}
+FORWARD_TO_NULLARY(invokeitable_vtable_pic)
+
 __attribute__((noinline)) static s64 invokesigpoly_impl_void(ARGS_VOID) {
   DEBUG_CHECK();
   obj_header *receiver = (sp - insn->args)->obj;
@@ -2140,6 +2381,7 @@ static s64 invokeitable_polymorphic_impl_void(ARGS_VOID) {
   }
   DCHECK(receiver_method);
 
+  ConsiderTrivialInvoke(thread, receiver_method);
   ConsiderJitEntry(thread, receiver_method, sp - insn->args);
 
   stack_frame *invoked_frame = push_frame(thread, receiver_method, sp - insn->args, insn->args);
@@ -2169,6 +2411,7 @@ static s64 invokevtable_polymorphic_impl_void(ARGS_VOID) {
   cp_method *receiver_method = vtable_lookup(receiver->descriptor, (size_t)insn->ic2);
   DCHECK(receiver_method);
 
+  ConsiderTrivialInvoke(thread, receiver_method);
   ConsiderJitEntry(thread, receiver_method, sp - insn->args);
 
   stack_frame *invoked_frame = push_frame(thread, receiver_method, sp - insn->args, insn->args);
@@ -2691,6 +2934,201 @@ static s64 sqrt_impl_float(ARGS_FLOAT) {
   NEXT_FLOAT(sqrt(tos))
 }
 
+// Math.min and Math.max on floating-point values return NaN if either argument is NaN, and order -0.0 below 0.0
+#define JAVA_FP_MIN(a, b) ((a) != (a) ? (a) : (a) == 0 && (b) == 0 ? (signbit(a) ? (a) : (b)) : (a) <= (b) ? (a) : (b))
+#define JAVA_FP_MAX(a, b) ((a) != (a) ? (a) : (a) == 0 && (b) == 0 ? (signbit(a) ? (b) : (a)) : (a) >= (b) ? (a) : (b))
+
+#define INTRINSIC_UN_OP(which, tos_kind, type, eval, NEXT)                                                             \
+  static s64 which##_impl_##tos_kind(ARGS_##type) {                                                                    \
+    DEBUG_CHECK();                                                                                                     \
+    NEXT(eval)                                                                                                         \
+  }
+
+#define INTRINSIC_BIN_OP(which, tos_kind, type, field, eval, NEXT)                                                     \
+  static s64 which##_impl_##tos_kind(ARGS_##type) {                                                                    \
+    DEBUG_CHECK();                                                                                                     \
+    auto a = (sp - 2)->field;                                                                                          \
+    auto b = tos;                                                                                                      \
+    sp--;                                                                                                              \
+    NEXT(eval)                                                                                                         \
+  }
+
+INTRINSIC_UN_OP(iabs, int, INT, (s32)tos < 0 ? (s32)(-(u32)tos) : (s32)tos, NEXT_INT)
+INTRINSIC_UN_OP(labs, int, INT, tos < 0 ? (s64)(-(u64)tos) : tos, NEXT_INT)
+INTRINSIC_UN_OP(fabs, float, FLOAT, fabsf(tos), NEXT_FLOAT)
+INTRINSIC_UN_OP(dabs, double, DOUBLE, fabs(tos), NEXT_DOUBLE)
+INTRINSIC_UN_OP(floor, double, DOUBLE, floor(tos), NEXT_DOUBLE)
+INTRINSIC_UN_OP(ceil, double, DOUBLE, ceil(tos), NEXT_DOUBLE)
+INTRINSIC_UN_OP(iclz, int, INT, (u32)tos ? __builtin_clz((u32)tos) : 32, NEXT_INT)
+INTRINSIC_UN_OP(lclz, int, INT, tos ? __builtin_clzll((u64)tos) : 64, NEXT_INT)
+INTRINSIC_UN_OP(ipopcount, int, INT, __builtin_popcount((u32)tos), NEXT_INT)
+INTRINSIC_UN_OP(lpopcount, int, INT, __builtin_popcountll((u64)tos), NEXT_INT)
+INTRINSIC_UN_OP(ibswap, int, INT, (s32)__builtin_bswap32((u32)tos), NEXT_INT)
+INTRINSIC_UN_OP(lbswap, int, INT, (s64)__builtin_bswap64((u64)tos), NEXT_INT)
+INTRINSIC_UN_OP(float_to_raw_int_bits, float, FLOAT, ((union { float f; s32 i; }){.f = tos}).i, NEXT_INT)
+INTRINSIC_UN_OP(int_bits_to_float, int, INT, ((union { s32 i; float f; }){.i = (s32)tos}).f, NEXT_FLOAT)
+INTRINSIC_UN_OP(double_to_raw_long_bits, double, DOUBLE, ((union { double d; s64 l; }){.d = tos}).l, NEXT_INT)
+INTRINSIC_UN_OP(long_bits_to_double, int, INT, ((union { s64 l; double d; }){.l = tos}).d, NEXT_DOUBLE)
+
+INTRINSIC_BIN_OP(imin, int, INT, i, (s32)b < a ? (s32)b : a, NEXT_INT)
+INTRINSIC_BIN_OP(imax, int, INT, i, (s32)b > a ? (s32)b : a, NEXT_INT)
+INTRINSIC_BIN_OP(lmin, int, INT, l, b < a ? b : a, NEXT_INT)
+INTRINSIC_BIN_OP(lmax, int, INT, l, b > a ? b : a, NEXT_INT)
+INTRINSIC_BIN_OP(fmin, float, FLOAT, f, JAVA_FP_MIN(a, b), NEXT_FLOAT)
+INTRINSIC_BIN_OP(fmax, float, FLOAT, f, JAVA_FP_MAX(a, b), NEXT_FLOAT)
+INTRINSIC_BIN_OP(dmin, double, DOUBLE, d, JAVA_FP_MIN(a, b), NEXT_DOUBLE)
+INTRINSIC_BIN_OP(dmax, double, DOUBLE, d, JAVA_FP_MAX(a, b), NEXT_DOUBLE)
+
+#undef INTRINSIC_UN_OP
+#undef INTRINSIC_BIN_OP
+#undef JAVA_FP_MIN
+#undef JAVA_FP_MAX
+
+static s64 ffma_impl_float(ARGS_FLOAT) {
+  DEBUG_CHECK();
+  float a = (sp - 3)->f, b = (sp - 2)->f;
+  sp -= 2;
+  NEXT_FLOAT(fmaf(a, b, tos))
+}
+
+static s64 dfma_impl_double(ARGS_DOUBLE) {
+  DEBUG_CHECK();
+  double a = (sp - 3)->d, b = (sp - 2)->d;
+  sp -= 2;
+  NEXT_DOUBLE(fma(a, b, tos))
+}
+
+static s64 get_class_impl_int(ARGS_INT) {
+  DEBUG_CHECK();
+  obj_header *obj = (obj_header *)tos;
+  NPE_ON_NULL(obj);
+  if (likely(obj->descriptor->mirror)) {
+    NEXT_INT(obj->descriptor->mirror)
+  }
+  SPILL(tos)
+  struct native_Class *mirror = get_class_mirror(thread, obj->descriptor); // may allocate
+  if (thread->current_exception)
+    return 0;
+  NEXT_INT(mirror)
+}
+
+static s64 current_thread_impl_void(ARGS_VOID) {
+  DEBUG_CHECK();
+  sp++;
+  NEXT_INT(thread->thread_obj)
+}
+FORWARD_TO_NULLARY(current_thread)
+
+static s64 identity_hash_code_impl_int(ARGS_INT) {
+  DEBUG_CHECK();
+  obj_header *obj = (obj_header *)tos;
+  NEXT_INT(obj ? get_object_hash_code(thread->vm, obj) : 0)
+}
+
+/** Superinstructions (see fuse_superinstructions in analysis.c). The fused instructions following the head are left in
+ * place, so any slow path can just execute the head's own instruction and continue into them. */
+
+// Advance past the instructions consumed by a superinstruction, other than the last one (which NEXT_* advances past)
+#define SKIP_FUSED(n)                                                                                                  \
+  insns += (n);                                                                                                        \
+  pc += (n);
+
+static_assert(insn_aload_getfield_N - insn_aload_getfield_B == insn_getfield_N - insn_getfield_B);
+
+static s64 aload_getfield_impl_void(ARGS_VOID) {
+  DEBUG_CHECK();
+  int kind = insn[1].kind;
+  if (kind >= insn_getfield_B && kind <= insn_getfield_N) {
+    insn->kind = insn_aload_getfield_B + (kind - insn_getfield_B);
+    JMP_VOID
+  }
+  // The getfield hasn't been resolved yet, so just act as an aload
+  sp++;
+  NEXT_INT(get_local(frame, insn)->obj)
+}
+FORWARD_TO_NULLARY(aload_getfield)
+
+#define MAKE_ALOAD_GETFIELD(which, NEXT, value)                                                                        \
+  static s64 aload_getfield_##which##_impl_void(ARGS_VOID) {                                                           \
+    DEBUG_CHECK();                                                                                                     \
+    obj_header *obj = get_local(frame, insn)->obj;                                                                     \
+    sp++;                                                                                                              \
+    if (unlikely(!obj)) {                                                                                              \
+      NEXT_INT(obj) /* let the getfield raise the NPE */                                                               \
+    }                                                                                                                  \
+    SKIP_FUSED(1)                                                                                                      \
+    char *field = (char *)obj + (size_t)insn->ic2;                                                                     \
+    NEXT(value)                                                                                                        \
+  }                                                                                                                    \
+  FORWARD_TO_NULLARY(aload_getfield_##which)
+
+MAKE_ALOAD_GETFIELD(B, NEXT_INT, (s64) * (s8 *)field)
+MAKE_ALOAD_GETFIELD(C, NEXT_INT, (s64) * (u16 *)field)
+MAKE_ALOAD_GETFIELD(S, NEXT_INT, (s64) * (s16 *)field)
+MAKE_ALOAD_GETFIELD(I, NEXT_INT, (s64) * (int *)field)
+MAKE_ALOAD_GETFIELD(J, NEXT_INT, *(s64 *)field)
+MAKE_ALOAD_GETFIELD(F, NEXT_FLOAT, *(float *)field)
+MAKE_ALOAD_GETFIELD(D, NEXT_DOUBLE, *(double *)field)
+MAKE_ALOAD_GETFIELD(Z, NEXT_INT, (s64) * (s8 *)field)
+MAKE_ALOAD_GETFIELD(L, NEXT_INT, *(obj_header **)field)
+MAKE_ALOAD_GETFIELD(N, NEXT_INT, load_ref(field))
+
+static s64 aload_arraylength_impl_void(ARGS_VOID) {
+  DEBUG_CHECK();
+  obj_header *array = get_local(frame, insn)->obj;
+  sp++;
+  if (unlikely(!array)) {
+    NEXT_INT(array) // let the arraylength raise the NPE
+  }
+  SKIP_FUSED(1)
+  NEXT_INT(ArrayLength(array))
+}
+FORWARD_TO_NULLARY(aload_arraylength)
+
+#define MAKE_ILOAD_ILOAD_BIN_OP(which, op)                                                                             \
+  static s64 iload_iload_##which##_impl_void(ARGS_VOID) {                                                              \
+    DEBUG_CHECK();                                                                                                     \
+    u32 a = (u32)get_local(frame, insn)->i, b = (u32)get_local(frame, insn + 1)->i;                                    \
+    sp++;                                                                                                              \
+    SKIP_FUSED(2)                                                                                                      \
+    NEXT_INT((s32)(a op b))                                                                                            \
+  }                                                                                                                    \
+  FORWARD_TO_NULLARY(iload_iload_##which)
+
+MAKE_ILOAD_ILOAD_BIN_OP(iadd, +)
+MAKE_ILOAD_ILOAD_BIN_OP(isub, -)
+
+#define MAKE_ILOAD_ICONST_BRANCH(which, op)                                                                            \
+  static s64 iload_iconst_##which##_impl_void(ARGS_VOID) {                                                             \
+    DEBUG_CHECK();                                                                                                     \
+    FUEL_CHECK_VOID                                                                                                    \
+    s32 a = get_local(frame, insn)->i, b = (s32)insn[1].integer_imm;                                                   \
+    s32 old_pc = pc;                                                                                                   \
+    pc = a op b ? ((s32)insn[2].index - 1) : pc + 2;                                                                   \
+    insns += (s32)pc - old_pc;                                                                                         \
+    STACK_POLYMORPHIC_NEXT(*(sp - 1));                                                                                 \
+  }                                                                                                                    \
+  FORWARD_TO_NULLARY(iload_iconst_##which)
+
+MAKE_ILOAD_ICONST_BRANCH(if_icmpeq, ==)
+MAKE_ILOAD_ICONST_BRANCH(if_icmpne, !=)
+MAKE_ILOAD_ICONST_BRANCH(if_icmplt, <)
+MAKE_ILOAD_ICONST_BRANCH(if_icmpge, >=)
+MAKE_ILOAD_ICONST_BRANCH(if_icmpgt, >)
+MAKE_ILOAD_ICONST_BRANCH(if_icmple, <=)
+
+static s64 iinc_goto_impl_void(ARGS_VOID) {
+  DEBUG_CHECK();
+  FUEL_CHECK_VOID // before the increment, since we resume at the iinc
+  int *a = &frame_locals(frame)[insn->iinc.index].i;
+  __builtin_add_overflow(*a, insn->iinc.const_, a);
+  s32 target = (s32)insn[1].index;
+  insns += target - (s32)pc;
+  pc = target;
+  STACK_POLYMORPHIC_JMP(*(sp - 1));
+}
+FORWARD_TO_NULLARY(iinc_goto)
+
 static s64 frem_impl_float(ARGS_FLOAT) {
   DEBUG_CHECK();
   float a = (sp - 2)->f, b = tos;
@@ -2882,7 +3320,7 @@ static s64 async_resume_impl_void(ARGS_VOID) {
     bytecode_insn *in = cont.ctx.resolve_insn.args.inst;
     int fail = cont.ctx.resolve_insn._result;
     if (!fail && in->kind == insn_invokestatic && fut.status == FUTURE_READY) {
-      needs_polymorphic_jump = intrinsify(in);
+      needs_polymorphic_jump = intrinsify(in, in->ic);
     }
     break;
 
@@ -3128,7 +3566,11 @@ PAGE_ALIGN static s64 (*jmp_table_void[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_invokevtable_polymorphic] = invokevtable_polymorphic_impl_void,
     [insn_invokeitable_monomorphic] = invokeitable_vtable_monomorphic_impl_void,
     [insn_invokeitable_polymorphic] = invokeitable_polymorphic_impl_void,
+    [insn_invokevtable_pic] = invokeitable_vtable_pic_impl_void,
+    [insn_invokeitable_pic] = invokeitable_vtable_pic_impl_void,
     [insn_invokespecial_resolved] = invokespecial_resolved_impl_void,
+    [insn_invokevirtual_direct] = invokespecial_resolved_impl_void,
+    [insn_current_thread] = current_thread_impl_void,
     [insn_invokestatic_resolved] = invokestatic_resolved_impl_void,
     [insn_invokecallsite] = invokecallsite_impl_void,
     [insn_invokesigpoly] = invokesigpoly_impl_void,
@@ -3141,7 +3583,27 @@ PAGE_ALIGN static s64 (*jmp_table_void[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_getstatic_D] = getstatic_D_impl_void,
     [insn_getstatic_Z] = getstatic_Z_impl_void,
     [insn_getstatic_L] = getstatic_L_impl_void,
-};
+    [insn_aload_getfield] = aload_getfield_impl_void,
+    [insn_aload_getfield_B] = aload_getfield_B_impl_void,
+    [insn_aload_getfield_C] = aload_getfield_C_impl_void,
+    [insn_aload_getfield_S] = aload_getfield_S_impl_void,
+    [insn_aload_getfield_I] = aload_getfield_I_impl_void,
+    [insn_aload_getfield_J] = aload_getfield_J_impl_void,
+    [insn_aload_getfield_F] = aload_getfield_F_impl_void,
+    [insn_aload_getfield_D] = aload_getfield_D_impl_void,
+    [insn_aload_getfield_Z] = aload_getfield_Z_impl_void,
+    [insn_aload_getfield_L] = aload_getfield_L_impl_void,
+    [insn_aload_getfield_N] = aload_getfield_N_impl_void,
+    [insn_aload_arraylength] = aload_arraylength_impl_void,
+    [insn_iload_iload_iadd] = iload_iload_iadd_impl_void,
+    [insn_iload_iload_isub] = iload_iload_isub_impl_void,
+    [insn_iload_iconst_if_icmpeq] = iload_iconst_if_icmpeq_impl_void,
+    [insn_iload_iconst_if_icmpne] = iload_iconst_if_icmpne_impl_void,
+    [insn_iload_iconst_if_icmplt] = iload_iconst_if_icmplt_impl_void,
+    [insn_iload_iconst_if_icmpge] = iload_iconst_if_icmpge_impl_void,
+    [insn_iload_iconst_if_icmpgt] = iload_iconst_if_icmpgt_impl_void,
+    [insn_iload_iconst_if_icmple] = iload_iconst_if_icmple_impl_void,
+    [insn_iinc_goto] = iinc_goto_impl_void};
 
 PAGE_ALIGN static s64 (*jmp_table_double[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_nop] = nop_impl_double,
@@ -3196,7 +3658,18 @@ PAGE_ALIGN static s64 (*jmp_table_double[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_invokevtable_polymorphic] = invokevtable_polymorphic_impl_double,
     [insn_invokeitable_monomorphic] = invokeitable_vtable_monomorphic_impl_double,
     [insn_invokeitable_polymorphic] = invokeitable_polymorphic_impl_double,
+    [insn_invokevtable_pic] = invokeitable_vtable_pic_impl_double,
+    [insn_invokeitable_pic] = invokeitable_vtable_pic_impl_double,
     [insn_invokespecial_resolved] = invokespecial_resolved_impl_double,
+    [insn_invokevirtual_direct] = invokespecial_resolved_impl_double,
+    [insn_dabs] = dabs_impl_double,
+    [insn_dmin] = dmin_impl_double,
+    [insn_dmax] = dmax_impl_double,
+    [insn_dfma] = dfma_impl_double,
+    [insn_floor] = floor_impl_double,
+    [insn_ceil] = ceil_impl_double,
+    [insn_double_to_raw_long_bits] = double_to_raw_long_bits_impl_double,
+    [insn_current_thread] = current_thread_impl_double,
     [insn_invokestatic_resolved] = invokestatic_resolved_impl_double,
     [insn_invokecallsite] = invokecallsite_impl_double,
     [insn_invokesigpoly] = invokesigpoly_impl_double,
@@ -3212,7 +3685,28 @@ PAGE_ALIGN static s64 (*jmp_table_double[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_getstatic_L] = getstatic_L_impl_double,
     [insn_putstatic_D] = putstatic_D_impl_double,
     [insn_drem] = drem_impl_double,
-    [insn_sqrt] = sqrt_impl_double};
+    [insn_sqrt] = sqrt_impl_double,
+    [insn_aload_getfield] = aload_getfield_impl_double,
+    [insn_aload_getfield_B] = aload_getfield_B_impl_double,
+    [insn_aload_getfield_C] = aload_getfield_C_impl_double,
+    [insn_aload_getfield_S] = aload_getfield_S_impl_double,
+    [insn_aload_getfield_I] = aload_getfield_I_impl_double,
+    [insn_aload_getfield_J] = aload_getfield_J_impl_double,
+    [insn_aload_getfield_F] = aload_getfield_F_impl_double,
+    [insn_aload_getfield_D] = aload_getfield_D_impl_double,
+    [insn_aload_getfield_Z] = aload_getfield_Z_impl_double,
+    [insn_aload_getfield_L] = aload_getfield_L_impl_double,
+    [insn_aload_getfield_N] = aload_getfield_N_impl_double,
+    [insn_aload_arraylength] = aload_arraylength_impl_double,
+    [insn_iload_iload_iadd] = iload_iload_iadd_impl_double,
+    [insn_iload_iload_isub] = iload_iload_isub_impl_double,
+    [insn_iload_iconst_if_icmpeq] = iload_iconst_if_icmpeq_impl_double,
+    [insn_iload_iconst_if_icmpne] = iload_iconst_if_icmpne_impl_double,
+    [insn_iload_iconst_if_icmplt] = iload_iconst_if_icmplt_impl_double,
+    [insn_iload_iconst_if_icmpge] = iload_iconst_if_icmpge_impl_double,
+    [insn_iload_iconst_if_icmpgt] = iload_iconst_if_icmpgt_impl_double,
+    [insn_iload_iconst_if_icmple] = iload_iconst_if_icmple_impl_double,
+    [insn_iinc_goto] = iinc_goto_impl_double};
 
 PAGE_ALIGN static s64 (*jmp_table_int[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_nop] = nop_impl_int,
@@ -3339,7 +3833,27 @@ PAGE_ALIGN static s64 (*jmp_table_int[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_invokevtable_polymorphic] = invokevtable_polymorphic_impl_int,
     [insn_invokeitable_monomorphic] = invokeitable_vtable_monomorphic_impl_int,
     [insn_invokeitable_polymorphic] = invokeitable_polymorphic_impl_int,
+    [insn_invokevtable_pic] = invokeitable_vtable_pic_impl_int,
+    [insn_invokeitable_pic] = invokeitable_vtable_pic_impl_int,
     [insn_invokespecial_resolved] = invokespecial_resolved_impl_int,
+    [insn_invokevirtual_direct] = invokespecial_resolved_impl_int,
+    [insn_iabs] = iabs_impl_int,
+    [insn_labs] = labs_impl_int,
+    [insn_imin] = imin_impl_int,
+    [insn_imax] = imax_impl_int,
+    [insn_lmin] = lmin_impl_int,
+    [insn_lmax] = lmax_impl_int,
+    [insn_iclz] = iclz_impl_int,
+    [insn_lclz] = lclz_impl_int,
+    [insn_ipopcount] = ipopcount_impl_int,
+    [insn_lpopcount] = lpopcount_impl_int,
+    [insn_ibswap] = ibswap_impl_int,
+    [insn_lbswap] = lbswap_impl_int,
+    [insn_int_bits_to_float] = int_bits_to_float_impl_int,
+    [insn_long_bits_to_double] = long_bits_to_double_impl_int,
+    [insn_get_class] = get_class_impl_int,
+    [insn_identity_hash_code] = identity_hash_code_impl_int,
+    [insn_current_thread] = current_thread_impl_int,
     [insn_invokestatic_resolved] = invokestatic_resolved_impl_int,
     [insn_invokecallsite] = invokecallsite_impl_int,
     [insn_invokesigpoly] = invokesigpoly_impl_int,
@@ -3352,6 +3866,7 @@ PAGE_ALIGN static s64 (*jmp_table_int[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_getfield_D] = getfield_D_impl_int,
     [insn_getfield_Z] = getfield_Z_impl_int,
     [insn_getfield_L] = getfield_L_impl_int,
+    [insn_getfield_N] = getfield_N_impl_int,
     [insn_putfield_B] = putfield_B_impl_int,
     [insn_putfield_C] = putfield_C_impl_int,
     [insn_putfield_S] = putfield_S_impl_int,
@@ -3359,6 +3874,7 @@ PAGE_ALIGN static s64 (*jmp_table_int[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_putfield_J] = putfield_J_impl_int,
     [insn_putfield_Z] = putfield_Z_impl_int,
     [insn_putfield_L] = putfield_L_impl_int,
+    [insn_putfield_N] = putfield_N_impl_int,
     [insn_getstatic_B] = getstatic_B_impl_int,
     [insn_getstatic_C] = getstatic_C_impl_int,
     [insn_getstatic_S] = getstatic_S_impl_int,
@@ -3375,7 +3891,27 @@ PAGE_ALIGN static s64 (*jmp_table_int[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_putstatic_J] = putstatic_J_impl_int,
     [insn_putstatic_Z] = putstatic_Z_impl_int,
     [insn_putstatic_L] = putstatic_L_impl_int,
-};
+    [insn_aload_getfield] = aload_getfield_impl_int,
+    [insn_aload_getfield_B] = aload_getfield_B_impl_int,
+    [insn_aload_getfield_C] = aload_getfield_C_impl_int,
+    [insn_aload_getfield_S] = aload_getfield_S_impl_int,
+    [insn_aload_getfield_I] = aload_getfield_I_impl_int,
+    [insn_aload_getfield_J] = aload_getfield_J_impl_int,
+    [insn_aload_getfield_F] = aload_getfield_F_impl_int,
+    [insn_aload_getfield_D] = aload_getfield_D_impl_int,
+    [insn_aload_getfield_Z] = aload_getfield_Z_impl_int,
+    [insn_aload_getfield_L] = aload_getfield_L_impl_int,
+    [insn_aload_getfield_N] = aload_getfield_N_impl_int,
+    [insn_aload_arraylength] = aload_arraylength_impl_int,
+    [insn_iload_iload_iadd] = iload_iload_iadd_impl_int,
+    [insn_iload_iload_isub] = iload_iload_isub_impl_int,
+    [insn_iload_iconst_if_icmpeq] = iload_iconst_if_icmpeq_impl_int,
+    [insn_iload_iconst_if_icmpne] = iload_iconst_if_icmpne_impl_int,
+    [insn_iload_iconst_if_icmplt] = iload_iconst_if_icmplt_impl_int,
+    [insn_iload_iconst_if_icmpge] = iload_iconst_if_icmpge_impl_int,
+    [insn_iload_iconst_if_icmpgt] = iload_iconst_if_icmpgt_impl_int,
+    [insn_iload_iconst_if_icmple] = iload_iconst_if_icmple_impl_int,
+    [insn_iinc_goto] = iinc_goto_impl_int};
 
 PAGE_ALIGN static s64 (*jmp_table_float[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_nop] = nop_impl_float,
@@ -3430,7 +3966,16 @@ PAGE_ALIGN static s64 (*jmp_table_float[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_invokevtable_polymorphic] = invokevtable_polymorphic_impl_float,
     [insn_invokeitable_monomorphic] = invokeitable_vtable_monomorphic_impl_float,
     [insn_invokeitable_polymorphic] = invokeitable_polymorphic_impl_float,
+    [insn_invokevtable_pic] = invokeitable_vtable_pic_impl_float,
+    [insn_invokeitable_pic] = invokeitable_vtable_pic_impl_float,
     [insn_invokespecial_resolved] = invokespecial_resolved_impl_float,
+    [insn_invokevirtual_direct] = invokespecial_resolved_impl_float,
+    [insn_fabs] = fabs_impl_float,
+    [insn_fmin] = fmin_impl_float,
+    [insn_fmax] = fmax_impl_float,
+    [insn_ffma] = ffma_impl_float,
+    [insn_float_to_raw_int_bits] = float_to_raw_int_bits_impl_float,
+    [insn_current_thread] = current_thread_impl_float,
     [insn_invokestatic_resolved] = invokestatic_resolved_impl_float,
     [insn_invokecallsite] = invokecallsite_impl_float,
     [insn_invokesigpoly] = invokesigpoly_impl_float,
@@ -3446,4 +3991,25 @@ PAGE_ALIGN static s64 (*jmp_table_float[MAX_INSN_KIND])(ARGS_VOID) = {
     [insn_getstatic_L] = getstatic_L_impl_float,
     [insn_putstatic_F] = putstatic_F_impl_float,
     [insn_frem] = frem_impl_float,
-    [insn_sqrt] = sqrt_impl_float};
\ No newline at end of file
+    [insn_sqrt] = sqrt_impl_float,
+    [insn_aload_getfield] = aload_getfield_impl_float,
+    [insn_aload_getfield_B] = aload_getfield_B_impl_float,
+    [insn_aload_getfield_C] = aload_getfield_C_impl_float,
+    [insn_aload_getfield_S] = aload_getfield_S_impl_float,
+    [insn_aload_getfield_I] = aload_getfield_I_impl_float,
+    [insn_aload_getfield_J] = aload_getfield_J_impl_float,
+    [insn_aload_getfield_F] = aload_getfield_F_impl_float,
+    [insn_aload_getfield_D] = aload_getfield_D_impl_float,
+    [insn_aload_getfield_Z] = aload_getfield_Z_impl_float,
+    [insn_aload_getfield_L] = aload_getfield_L_impl_float,
+    [insn_aload_getfield_N] = aload_getfield_N_impl_float,
+    [insn_aload_arraylength] = aload_arraylength_impl_float,
+    [insn_iload_iload_iadd] = iload_iload_iadd_impl_float,
+    [insn_iload_iload_isub] = iload_iload_isub_impl_float,
+    [insn_iload_iconst_if_icmpeq] = iload_iconst_if_icmpeq_impl_float,
+    [insn_iload_iconst_if_icmpne] = iload_iconst_if_icmpne_impl_float,
+    [insn_iload_iconst_if_icmplt] = iload_iconst_if_icmplt_impl_float,
+    [insn_iload_iconst_if_icmpge] = iload_iconst_if_icmpge_impl_float,
+    [insn_iload_iconst_if_icmpgt] = iload_iconst_if_icmpgt_impl_float,
+    [insn_iload_iconst_if_icmple] = iload_iconst_if_icmple_impl_float,
+    [insn_iinc_goto] = iinc_goto_impl_float};
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include <analysis.h>
 #include <classfile.h>
+#include <gc.h>
 #include <vtable.h>
 
 #include <bjvm.h>
@@ -11,8 +12,11 @@
 // Credit: https://stackoverflow.com/a/77159291/13458117
 #define SIZEOF_POINTER (UINTPTR_MAX / 255 % 255)
 
-static size_t allocate_field(size_t *current, type_kind kind) {
+// Storage for a field of the given kind. A narrow field is a compressed reference (see heap_ref).
+static size_t allocate_field(size_t *current, type_kind kind, bool narrow) {
   size_t result;
+  if (narrow)
+    kind = TYPE_KIND_INT; // same size and alignment
   switch (kind) {
   case TYPE_KIND_BOOLEAN:
   case TYPE_KIND_BYTE: {
@@ -98,14 +102,26 @@ static int link_array_class(vm_thread *thread, classdesc *cd) {
   return status;
 }
 
+static bool is_narrow_field(const cp_field *field, bool compressed_fields) {
+  return compressed_fields && field->parsed_descriptor.repr_kind == TYPE_KIND_REFERENCE &&
+         !(field->access_flags & ACCESS_STATIC);
+}
+
+// Superclasses of classes with native structs, whose fields are part of those structs
+static bool is_native_struct_superclass(const classdesc *cd) {
+  return !cd->classloader && (utf8_equals(cd->name, "java/lang/reflect/AccessibleObject") ||
+                              utf8_equals(cd->name, "java/lang/reflect/Executable"));
+}
+
 // Reorder fields in a class so that bigger fields are placed first.
-static int *reorder_fields_for_compactness(cp_field *fields, int fields_count) {
+static int *reorder_fields_for_compactness(cp_field *fields, int fields_count, bool compressed_fields) {
   int *order = malloc(sizeof(int) * fields_count);
   // Because there's only a few values (1, 2, 4, 8), we can just use buckets
   int *buckets[4] = {nullptr};
   for (int i = 0; i < fields_count; ++i) {
     cp_field *field = fields + i;
-    int size = sizeof_type_kind(field->parsed_descriptor.repr_kind);
+    int size = is_narrow_field(field, compressed_fields) ? (int)sizeof(heap_ref)
+                                                         : sizeof_type_kind(field->parsed_descriptor.repr_kind);
     DCHECK(size == 1 || size == 2 || size == 4 || size == 8);
     arrput(buckets[__builtin_ctz(size)], i);
   }
@@ -119,6 +135,59 @@ static int *reorder_fields_for_compactness(cp_field *fields, int fields_count) {
   return order;
 }
 
+// JDK methods which the interpreter (and JIT) execute as a single instruction instead of calling them
+static const struct {
+  const char *class_name, *name, *descriptor;
+  insn_code_kind kind;
+} intrinsics[] = {
+    {"java/lang/Math", "sqrt", "(D)D", insn_sqrt},
+    {"java/lang/Math", "abs", "(I)I", insn_iabs},
+    {"java/lang/Math", "abs", "(J)J", insn_labs},
+    {"java/lang/Math", "abs", "(F)F", insn_fabs},
+    {"java/lang/Math", "abs", "(D)D", insn_dabs},
+    {"java/lang/Math", "min", "(II)I", insn_imin},
+    {"java/lang/Math", "max", "(II)I", insn_imax},
+    {"java/lang/Math", "min", "(JJ)J", insn_lmin},
+    {"java/lang/Math", "max", "(JJ)J", insn_lmax},
+    {"java/lang/Math", "min", "(FF)F", insn_fmin},
+    {"java/lang/Math", "max", "(FF)F", insn_fmax},
+    {"java/lang/Math", "min", "(DD)D", insn_dmin},
+    {"java/lang/Math", "max", "(DD)D", insn_dmax},
+    {"java/lang/Math", "fma", "(FFF)F", insn_ffma},
+    {"java/lang/Math", "fma", "(DDD)D", insn_dfma},
+    {"java/lang/Math", "floor", "(D)D", insn_floor},
+    {"java/lang/Math", "ceil", "(D)D", insn_ceil},
+    {"java/lang/Integer", "numberOfLeadingZeros", "(I)I", insn_iclz},
+    {"java/lang/Long", "numberOfLeadingZeros", "(J)I", insn_lclz},
+    {"java/lang/Integer", "bitCount", "(I)I", insn_ipopcount},
+    {"java/lang/Long", "bitCount", "(J)I", insn_lpopcount},
+    {"java/lang/Integer", "reverseBytes", "(I)I", insn_ibswap},
+    {"java/lang/Long", "reverseBytes", "(J)J", insn_lbswap},
+    {"java/lang/Float", "floatToRawIntBits", "(F)I", insn_float_to_raw_int_bits},
+    {"java/lang/Float", "intBitsToFloat", "(I)F", insn_int_bits_to_float},
+    {"java/lang/Double", "doubleToRawLongBits", "(D)J", insn_double_to_raw_long_bits},
+    {"java/lang/Double", "longBitsToDouble", "(J)D", insn_long_bits_to_double},
+    {"java/lang/Object", "getClass", "()Ljava/lang/Class;", insn_get_class},
+    {"java/lang/Thread", "currentThread", "()Ljava/lang/Thread;", insn_current_thread},
+    {"java/lang/System", "identityHashCode", "(Ljava/lang/Object;)I", insn_identity_hash_code},
+};
+
+// Mark the methods of a bootstrap class which are in the intrinsics table
+static void find_intrinsics(classdesc *cd) {
+  for (size_t i = 0; i < sizeof(intrinsics) / sizeof(intrinsics[0]); ++i) {
+    if (!utf8_equals(cd->name, intrinsics[i].class_name))
+      continue;
+    for (int method_i = 0; method_i < cd->methods_count; ++method_i) {
+      cp_method *method = cd->methods + method_i;
+      if (utf8_equals(method->name, intrinsics[i].name) &&
+          utf8_equals(method->unparsed_descriptor, intrinsics[i].descriptor)) {
+        method->intrinsic = intrinsics[i].kind;
+        break;
+      }
+    }
+  }
+}
+
 // Link the class.
 int link_class(vm_thread *thread, classdesc *cd) {
   if (cd->state != CD_STATE_LOADED) {
@@ -170,26 +239,46 @@ int link_class(vm_thread *thread, classdesc *cd) {
       }
     }
   }
+  if (!cd->classloader)
+    find_intrinsics(cd);
 
   // Padding for VM fields (e.g., internal fields used for Reflection)
   int padding = (int)(uintptr_t)hash_table_lookup(&thread->vm->class_padding, cd->name.chars, cd->name.len);
 
   // Assign memory locations to all static/non-static fields
   classdesc *super = cd->super_class ? cd->super_class->classdesc : nullptr;
+  cd->reference_kind = super ? super->reference_kind : REFERENCE_KIND_NONE;
+  if (!cd->classloader) {
+    if (utf8_equals(cd->name, "java/lang/ref/SoftReference"))
+      cd->reference_kind = REFERENCE_KIND_SOFT;
+    else if (utf8_equals(cd->name, "java/lang/ref/WeakReference"))
+      cd->reference_kind = REFERENCE_KIND_WEAK;
+    else if (utf8_equals(cd->name, "java/lang/ref/FinalReference"))
+      cd->reference_kind = REFERENCE_KIND_FINAL;
+    else if (utf8_equals(cd->name, "java/lang/ref/PhantomReference"))
+      cd->reference_kind = REFERENCE_KIND_PHANTOM;
+  }
   size_t static_offset = 0, nonstatic_offset = super ? super->instance_bytes : sizeof(obj_header);
   nonstatic_offset += padding;
 
   bool must_have_C_layout = hash_table_contains(&thread->vm->class_padding, cd->name.chars, cd->name.len);
+  // Native code reads the fields of these classes through the structs in natives_gen.h, so their references (and
+  // those of subclasses, which share the layout) stay pointer-sized
+  cd->compressed_fields = COMPRESSED_REFS && !must_have_C_layout && !is_native_struct_superclass(cd) &&
+                          (!super || super->compressed_fields);
+  DCHECK(!must_have_C_layout || !super || !super->compressed_fields || !super->instance_references->count,
+         "Native struct for %.*s has compressed superclass fields", fmt_slice(cd->name));
   int *order = nullptr;
   if (!must_have_C_layout)
-    order = reorder_fields_for_compactness(cd->fields, cd->fields_count);
+    order = reorder_fields_for_compactness(cd->fields, cd->fields_count, cd->compressed_fields);
   u32 static_refs_c = 0, nonstatic_refs_c = super ? super->instance_references->count : 0;
   u32 super_refs_c = nonstatic_refs_c;
   for (int field_i = 0; field_i < cd->fields_count; ++field_i) {
     cp_field *field = cd->fields + (must_have_C_layout ? field_i : order[field_i]);
     type_kind kind = field->parsed_descriptor.repr_kind;
-    field->byte_offset = field->access_flags & ACCESS_STATIC ? allocate_field(&static_offset, kind)
-                                                             : allocate_field(&nonstatic_offset, kind);
+    field->byte_offset = field->access_flags & ACCESS_STATIC
+                             ? allocate_field(&static_offset, kind, false)
+                             : allocate_field(&nonstatic_offset, kind, is_narrow_field(field, cd->compressed_fields));
     // printf("Allocating field %.*s for class %.*s at %zu\n", fmt_slice(field->name), fmt_slice(cd->name),
     //         field->byte_offset);
     if (kind == TYPE_KIND_REFERENCE) {
@@ -218,14 +307,24 @@ int link_class(vm_thread *thread, classdesc *cd) {
     if (field->parsed_descriptor.repr_kind == TYPE_KIND_REFERENCE) {
       bool is_static = field->access_flags & ACCESS_STATIC;
       u16 *slots = is_static ? cd->static_references->slots_unscaled : cd->instance_references->slots_unscaled;
-      slots[is_static ? static_refs_c : nonstatic_refs_c] = field->byte_offset / sizeof(void *);
+      size_t slot_size = is_narrow_field(field, cd->compressed_fields) ? sizeof(heap_ref) : sizeof(void *);
+      slots[is_static ? static_refs_c : nonstatic_refs_c] = field->byte_offset / slot_size;
       nonstatic_refs_c += !is_static;
       static_refs_c += is_static;
     }
   }
 
   // Create static field memory, initializing all to 0
+#if COMPRESSED_REFS
+  // Unsafe uses it as the base object of static fields, so it must be addressable by a heap_ref
+  cd->static_fields = allocate_static_fields(thread->vm, static_offset);
+  if (!cd->static_fields) {
+    out_of_memory(thread);
+    return -1;
+  }
+#else
   cd->static_fields = arena_alloc(&cd->arena, static_offset, sizeof(u8));
+#endif
   cd->instance_bytes = nonstatic_offset;
 
   // Set up vtable and itables
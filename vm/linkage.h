@@ -3,7 +3,15 @@
 
 #include <bjvm.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 int link_class(vm_thread *thread, classdesc *classdesc);
 void setup_super_hierarchy(classdesc *classdesc);
 
-#endif
\ No newline at end of file
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,51 +7,261 @@
 
 #define NOT_HELD_TID (-1)
 
-DEFINE_ASYNC(monitor_acquire) {
-  // since this is a single-threaded vm, we don't need atomic operations
-  self->handle = make_handle(args->thread, args->obj);
-  monitor_data *allocated_data = nullptr; // lazily allocated
+// Inflated monitors are kept off the Java heap, in chunks of slots which each take up a cache line so that threads
+// contending for different monitors don't contend for the same line. Free slots are kept in a list threaded through
+// them.
+#define CACHE_LINE_BYTES 64
+#define MONITORS_PER_CHUNK 256
+
+typedef struct monitor_slot {
+  _Alignas(CACHE_LINE_BYTES) monitor_data data; // first, so a monitor_data * is a monitor_slot *
+  struct monitor_slot *next_free;
+  bool in_use;
+  // Set by retain_or_deflate_monitor for the monitors of live objects, and cleared by sweep_monitors
+  bool retained;
+} monitor_slot;
+
+static_assert(sizeof(monitor_slot) == CACHE_LINE_BYTES);
+
+monitor_data *allocate_monitor(vm *vm) {
+  if (!vm->free_monitors) {
+    monitor_slot *chunk = aligned_alloc(CACHE_LINE_BYTES, MONITORS_PER_CHUNK * sizeof(monitor_slot));
+    if (!chunk)
+      return nullptr;
+    memset(chunk, 0, MONITORS_PER_CHUNK * sizeof(monitor_slot));
+    for (int i = MONITORS_PER_CHUNK - 1; i >= 0; --i) {
+      chunk[i].next_free = vm->free_monitors;
+      vm->free_monitors = chunk + i;
+    }
+    arrput(vm->monitor_chunks, chunk);
+  }
+  monitor_slot *slot = vm->free_monitors;
+  vm->free_monitors = slot->next_free;
+  slot->in_use = true;
+  return &slot->data;
+}
 
-#define shared_header &self->handle->obj->header_word
-  assert((uintptr_t)shared_header % 8 == 0); // should be aligned due to how bump_allocate works
+void free_monitor(vm *vm, monitor_data *monitor) {
+  monitor_slot *slot = (monitor_slot *)monitor;
+  DCHECK(slot->in_use);
+  slot->in_use = slot->retained = false;
+  slot->next_free = vm->free_monitors;
+  vm->free_monitors = slot;
+}
+
+void free_monitor_pool(vm *vm) {
+  for (int i = 0; i < arrlen(vm->monitor_chunks); ++i) {
+    free(vm->monitor_chunks[i]);
+  }
+  arrfree(vm->monitor_chunks);
+  vm->free_monitors = nullptr;
+}
+
+void retain_or_deflate_monitor(vm *vm, obj_header *obj) {
+  monitor_data *monitor = inspect_monitor(&obj->header_word);
+  if (!monitor)
+    return;
+  if (monitor->tid == NOT_HELD_TID && monitor->hold_count == 0) {
+    // Nobody holds it, and nobody keeps a pointer to it across a yield (they reinflate if need be), so put the mark
+    // word (and any identity hash code in it) back in the object
+    obj->header_word.mark_word = monitor->mark_word;
+    free_monitor(vm, monitor);
+  } else {
+    ((monitor_slot *)monitor)->retained = true;
+  }
+}
+
+void sweep_monitors(vm *vm) {
+  for (int i = 0; i < arrlen(vm->monitor_chunks); ++i) {
+    monitor_slot *chunk = vm->monitor_chunks[i];
+    for (int j = 0; j < MONITORS_PER_CHUNK; ++j) {
+      if (chunk[j].in_use && !chunk[j].retained)
+        free_monitor(vm, &chunk[j].data);
+      chunk[j].retained = false;
+    }
+  }
+}
+
+// Uncontended locks are "thin": the owner and recursion count live in the flags half of the mark word, next to the
+// IS_MARK_WORD and IS_REACHABLE bits, so that locking an object no one else is after is a single CAS on its header.
+// The identity hash code is kept in the other half, so unlike HotSpot it never forces inflation. A thin lock is
+// inflated once another thread contends for it, or once the recursion count or the owner's tid doesn't fit; waiting
+// and notification don't need a monitor, since waiters are tracked by the scheduler.
+#define THIN_LOCK_COUNT_SHIFT 2
+#define THIN_LOCK_COUNT_BITS 8
+#define THIN_LOCK_OWNER_SHIFT (THIN_LOCK_COUNT_SHIFT + THIN_LOCK_COUNT_BITS)
+#define THIN_LOCK_MAX_COUNT ((1u << THIN_LOCK_COUNT_BITS) - 1)
+#define THIN_LOCK_MAX_OWNER ((1u << (32 - THIN_LOCK_OWNER_SHIFT)) - 1)
+#define THIN_LOCK_MASK (~0u << THIN_LOCK_COUNT_SHIFT)
+
+// The owner is stored as tid + 1, so that 0 means unlocked
+static u32 thin_lock_owner(header_word header) { return header.mark_word.data[0] >> THIN_LOCK_OWNER_SHIFT; }
+static u32 thin_lock_count(header_word header) {
+  return header.mark_word.data[0] >> THIN_LOCK_COUNT_SHIFT & THIN_LOCK_MAX_COUNT;
+}
+
+static header_word with_thin_lock(header_word header, u32 owner, u32 count) {
+  header.mark_word.data[0] = (header.mark_word.data[0] & ~THIN_LOCK_MASK) | owner << THIN_LOCK_OWNER_SHIFT |
+                             count << THIN_LOCK_COUNT_SHIFT;
+  return header;
+}
 
+// Try to take (or, if hold_count is 0, re-enter) a thin lock on the object. Returns false if the object must be
+// locked through its monitor instead.
+static bool try_thin_lock(vm_thread *thread, obj_header *obj, u32 hold_count) {
+  u32 self = (u32)thread->tid + 1;
+  if (unlikely(self > THIN_LOCK_MAX_OWNER))
+    return false;
   header_word fetched_header;
+  __atomic_load(&obj->header_word, &fetched_header, __ATOMIC_ACQUIRE);
+  for (;;) {
+    if (has_expanded_data(&fetched_header))
+      return false;
+    u32 owner = thin_lock_owner(fetched_header), count = thin_lock_count(fetched_header);
+    header_word proposed_header;
+    if (owner == 0) {
+      proposed_header = with_thin_lock(fetched_header, self, hold_count ? hold_count : 1);
+    } else if (owner == self && hold_count == 0 && count < THIN_LOCK_MAX_COUNT) {
+      proposed_header = with_thin_lock(fetched_header, self, count + 1);
+    } else {
+      return false;
+    }
+    if (__atomic_compare_exchange(&obj->header_word, &fetched_header, &proposed_header, false, __ATOMIC_ACQ_REL,
+                                  __ATOMIC_ACQUIRE))
+      return true;
+  }
+}
+
+typedef enum { THIN_RELEASED, THIN_NOT_HELD, THIN_INFLATED } thin_release_result;
+
+// Release one hold (or all of them) on a thin lock held by this thread. Since a thin lock is inflated as soon as
+// another thread contends for it, no one can be waiting to enter.
+static thin_release_result thin_unlock(vm_thread *thread, obj_header *obj, bool all, u32 *released) {
+  header_word fetched_header;
+  __atomic_load(&obj->header_word, &fetched_header, __ATOMIC_ACQUIRE);
+  for (;;) {
+    if (has_expanded_data(&fetched_header))
+      return THIN_INFLATED;
+    u32 count = thin_lock_count(fetched_header);
+    if (thin_lock_owner(fetched_header) != (u32)thread->tid + 1 || count == 0)
+      return THIN_NOT_HELD;
+    u32 remaining = all ? 0 : count - 1;
+    header_word proposed_header = with_thin_lock(fetched_header, remaining ? (u32)thread->tid + 1 : 0, remaining);
+    if (__atomic_compare_exchange(&obj->header_word, &fetched_header, &proposed_header, false, __ATOMIC_ACQ_REL,
+                                  __ATOMIC_ACQUIRE)) {
+      *released = count - remaining;
+      return THIN_RELEASED;
+    }
+  }
+}
+
+// Returns the monitor of the object, inflating it if need be, or null if out of memory. A thin lock carries over to
+// the monitor.
+static monitor_data *inflate_monitor(vm_thread *thread, obj_header *obj) {
+  header_word *shared_header = &obj->header_word;
+  assert((uintptr_t)shared_header % 8 == 0); // should be aligned due to how bump_allocate works
 
+  header_word fetched_header;
   __atomic_load(shared_header, &fetched_header, __ATOMIC_ACQUIRE);
-  monitor_data *data;
+  monitor_data *allocated_data = nullptr; // lazily allocated
   for (;;) { // loop until a monitor data is initialized
-    data = inspect_monitor(&fetched_header);
+    monitor_data *data = inspect_monitor(&fetched_header);
     if (likely(data)) {
-      break; // the monitor exists
+      if (allocated_data) // someone beat us to it
+        free_monitor(thread->vm, allocated_data);
+      return data;
     }
     // we need to allocate one ourselves
     if (!allocated_data) {
-      allocated_data = allocate_monitor_for(args->thread, self->handle->obj);
-      if (unlikely(!allocated_data)) { // oom
-        drop_handle(args->thread, self->handle);
-        out_of_memory(args->thread);
-        ASYNC_RETURN(-1);
-      }
+      allocated_data = allocate_monitor_for(thread, obj);
+      if (unlikely(!allocated_data))
+        return nullptr;
     }
 
-    allocated_data->mark_word = fetched_header.mark_word;
-    allocated_data->tid = NOT_HELD_TID; // not owned (as a microöptimisation, we could claim it here beforehand)
-    allocated_data->hold_count = 0;
+    u32 owner = thin_lock_owner(fetched_header);
+    allocated_data->mark_word = with_thin_lock(fetched_header, 0, 0).mark_word;
+    allocated_data->tid = owner ? (s32)owner - 1 : NOT_HELD_TID;
+    allocated_data->hold_count = owner ? thin_lock_count(fetched_header) : 0;
 
     header_word proposed_header = {.expanded_data = allocated_data};
 
     // try to put it in- loop again if CAS fails
     if (__atomic_compare_exchange(shared_header, &fetched_header, &proposed_header, false, __ATOMIC_ACQ_REL,
                                   __ATOMIC_ACQUIRE)) {
-      break; // success
+      return allocated_data; // success
     }
   }
+}
+
+// While the VM has only one thread, no one can observe whether an object is locked except that thread itself, so
+// instead of touching the object, monitor_acquire and friends just count its holds in vm->elided_locks. When a second
+// thread is created, the counts are turned into real locks. Locks taken before elision (re)started stay on the objects,
+// so a thread's hold count is the sum of the two. The counts are kept in the order the objects were first locked, so
+// that with properly nested locking the one being unlocked is found at, and removed from, the end.
+static struct elided_lock *find_elided_lock(vm *vm, obj_header *obj) {
+  for (int i = arrlen(vm->elided_locks) - 1; i >= 0; --i) { // most recently locked first
+    if (vm->elided_locks[i].obj == obj)
+      return vm->elided_locks + i;
+  }
+  return nullptr;
+}
+
+static void elide_lock(vm *vm, obj_header *obj, u32 hold_count) {
+  struct elided_lock *lock = find_elided_lock(vm, obj);
+  if (lock)
+    lock->hold_count += hold_count;
+  else
+    arrput(vm->elided_locks, ((struct elided_lock){.obj = obj, .hold_count = hold_count}));
+}
+
+// Returns the number of elided holds released
+static u32 elided_unlock(vm *vm, obj_header *obj, bool all) {
+  struct elided_lock *lock = find_elided_lock(vm, obj);
+  if (!lock)
+    return 0;
+  u32 released = all ? lock->hold_count : 1;
+  if ((lock->hold_count -= released) == 0)
+    arrdel(vm->elided_locks, lock - vm->elided_locks);
+  return released;
+}
+
+void stop_eliding_locks(vm *vm) {
+  DCHECK(arrlen(vm->active_threads) == 1);
+  vm_thread *owner = vm->active_threads[0];
+  for (int i = 0; i < arrlen(vm->elided_locks); ++i) {
+    obj_header *obj = vm->elided_locks[i].obj;
+    u32 hold_count = vm->elided_locks[i].hold_count;
+    if (hold_count <= THIN_LOCK_MAX_COUNT && try_thin_lock(owner, obj, hold_count))
+      continue;
+    monitor_data *monitor = inflate_monitor(owner, obj); // carries over any holds already on the object
+    CHECK(monitor && "Out of memory for monitors");
+    DCHECK(monitor->tid == owner->tid || monitor->tid == NOT_HELD_TID);
+    monitor->tid = owner->tid;
+    monitor->hold_count += hold_count;
+  }
+  arrsetlen(vm->elided_locks, 0);
+  vm->eliding_locks = false;
+}
+
+DEFINE_ASYNC(monitor_acquire) {
+  if (args->thread->vm->eliding_locks) {
+    elide_lock(args->thread->vm, args->obj, 1);
+    ASYNC_RETURN(0);
+  }
+  if (likely(try_thin_lock(args->thread, args->obj, 0)))
+    ASYNC_RETURN(0);
+
+  // since this is a single-threaded vm, we don't need atomic operations
+  self->handle = make_handle(args->thread, args->obj);
 
-  // now, a monitor is guaranteed to exist
   for (;;) {
-    monitor_data *lock = __atomic_load_n(shared_header.expanded_data, __ATOMIC_ACQUIRE); // must refetch
-    assert(!((u64)lock & IS_MARK_WORD) && "Monitor data does not exist"); // weird, because we just set it up above
-    assert(lock);
+    // must refetch, because the monitor may have been deflated by a GC while we were waiting
+    monitor_data *lock = inflate_monitor(args->thread, self->handle->obj);
+    if (unlikely(!lock)) { // oom
+      drop_handle(args->thread, self->handle);
+      out_of_memory(args->thread);
+      ASYNC_RETURN(-1);
+    }
     s32 read_tid = NOT_HELD_TID;
 
     // try to acquire mutex- loop again if CAS fails
@@ -75,26 +285,30 @@ DEFINE_ASYNC(monitor_acquire) {
   }
 
   // done acquiring the monitor
-#undef shared_header
   drop_handle(args->thread, self->handle);
   ASYNC_END(0);
 }
 
 DEFINE_ASYNC(monitor_reacquire_hold_count) {
+  if (args->thread->vm->eliding_locks && args->hold_count > 0) {
+    elide_lock(args->thread->vm, args->obj, args->hold_count);
+    ASYNC_RETURN(0);
+  }
+  if (args->hold_count > 0 && (u32)args->hold_count <= THIN_LOCK_MAX_COUNT &&
+      try_thin_lock(args->thread, args->obj, args->hold_count))
+    ASYNC_RETURN(0);
+
   // since this is a single-threaded vm, we don't need atomic operations
   self->handle = make_handle(args->thread, args->obj);
 
-  // just sanity check, can remove
-#define shared_header &self->handle->obj->header_word
-  assert((uintptr_t)shared_header % 8 == 0); // should be aligned due to how bump_allocate works
-  header_word fetched_header;
-  __atomic_load(shared_header, &fetched_header, __ATOMIC_ACQUIRE);
-  assert(inspect_monitor(&fetched_header) != nullptr);
-
-  // a monitor should be guaranteed to exist
   for (;;) {
-    monitor_data *lock = __atomic_load_n(shared_header.expanded_data, __ATOMIC_ACQUIRE); // must refetch
-    assert(lock);
+    // the monitor was released while waiting, so a GC may have deflated it
+    monitor_data *lock = inflate_monitor(args->thread, self->handle->obj);
+    if (unlikely(!lock)) { // oom
+      drop_handle(args->thread, self->handle);
+      out_of_memory(args->thread);
+      ASYNC_RETURN(-1);
+    }
     s32 read_tid = NOT_HELD_TID;
 
     // try to acquire mutex- loop again if CAS fails
@@ -119,26 +333,40 @@ DEFINE_ASYNC(monitor_reacquire_hold_count) {
   }
 
   // done acquiring the monitor
-#undef shared_header
   drop_handle(args->thread, self->handle);
   ASYNC_END(0);
 }
 
 u32 current_thread_hold_count(vm_thread *thread, obj_header *obj) {
+  struct elided_lock *elided = find_elided_lock(thread->vm, obj);
+  u32 elided_count = elided ? elided->hold_count : 0;
+
   // no handles necessary because no GC (i hope)
   header_word fetched_header;
   __atomic_load(&obj->header_word, &fetched_header, __ATOMIC_ACQUIRE);
   monitor_data *lock = inspect_monitor(&fetched_header);
-  if (unlikely(!lock))
-    return 0;
+  if (!lock)
+    return elided_count +
+           (thin_lock_owner(fetched_header) == (u32)thread->tid + 1 ? thin_lock_count(fetched_header) : 0);
 
   s32 tid = __atomic_load_n(&lock->tid, __ATOMIC_ACQUIRE);
   if (tid != thread->tid)
-    return 0;
-  return lock->hold_count;
+    return elided_count;
+  return elided_count + lock->hold_count;
 }
 
 u32 monitor_release_all_hold_count(vm_thread *thread, obj_header *obj) {
+  u32 elided_count = elided_unlock(thread->vm, obj, true);
+  u32 released;
+  switch (thin_unlock(thread, obj, true, &released)) {
+  case THIN_RELEASED:
+    return elided_count + released;
+  case THIN_NOT_HELD:
+    return elided_count;
+  case THIN_INFLATED:
+    break;
+  }
+
   // no handles necessary because no GC (i hope)
   header_word fetched_header;
   __atomic_load(&obj->header_word, &fetched_header, __ATOMIC_ACQUIRE);
@@ -146,12 +374,12 @@ u32 monitor_release_all_hold_count(vm_thread *thread, obj_header *obj) {
 
   // todo: error code enum? or just always cause an InternalError/IllegalMonitorStateException
   if (unlikely(!lock))
-    return 0;
+    return elided_count;
   s32 tid = __atomic_load_n(&lock->tid, __ATOMIC_ACQUIRE);
   if (unlikely(tid != thread->tid))
-    return 0;
+    return elided_count;
   if (unlikely(lock->hold_count == 0))
-    return 0;
+    return elided_count;
 
   u32 hold_count = lock->hold_count;
   lock->hold_count = 0;
@@ -161,10 +389,23 @@ u32 monitor_release_all_hold_count(vm_thread *thread, obj_header *obj) {
   rr_scheduler *scheduler = thread->vm->scheduler;
   assert(scheduler && "Cannot synchronize without a scheduler!");
   monitor_exit_handler(scheduler, obj);
-  return hold_count;
+  return elided_count + hold_count;
 }
 
 int monitor_release(vm_thread *thread, obj_header *obj) {
+  if (elided_unlock(thread->vm, obj, false))
+    return 0;
+
+  u32 released;
+  switch (thin_unlock(thread, obj, false, &released)) {
+  case THIN_RELEASED:
+    return 0;
+  case THIN_NOT_HELD:
+    return -1;
+  case THIN_INFLATED:
+    break;
+  }
+
   // since this is a single-threaded vm, we don't need atomic operations
   // no handles necessary because no GC (i hope)
   header_word fetched_header;
@@ -31,4 +31,19 @@ u32 monitor_release_all_hold_count(vm_thread *thread, obj_header *obj);
 
 int monitor_release(vm_thread *thread, obj_header *obj);
 
+// Inflated monitors come from an off-heap pool owned by the VM. Returns an uninitialized monitor, or null if out of
+// memory.
+monitor_data *allocate_monitor(vm *vm);
+void free_monitor(vm *vm, monitor_data *monitor);
+void free_monitor_pool(vm *vm);
+
+// Called before a second thread joins the VM: the holds counted while locking was elided are applied to the objects.
+void stop_eliding_locks(vm *vm);
+
+// Called by a major GC on every live object: the object's monitor, if it has one, is deflated back into the mark word
+// if no thread holds it, and otherwise kept by the following sweep_monitors.
+void retain_or_deflate_monitor(vm *vm, obj_header *obj);
+// Free the monitors which weren't retained since the last sweep, i.e. those of objects which died
+void sweep_monitors(vm *vm);
+
 #endif // MONITORS_H
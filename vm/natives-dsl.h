@@ -44,17 +44,18 @@ extern native_t *natives;
       [[maybe_unused]] u8 argc)
 
 #define create_init_constructor(package_path, class_name_, method_name_, method_descriptor_, modifier, async_sz,       \
-                                variant)                                                                               \
+                                variant, replaces_bytecode_)                                                           \
   __attribute__((used)) native_t NATIVE_INFO_##class_name_##_##method_name_##_##modifier =                             \
       (native_t){.class_path = STR(package_path "/" #class_name_),                                                     \
                  .method_name = STR(#method_name_),                                                                    \
                  .method_descriptor = STR(method_descriptor_),                                                         \
                  .callback = (native_callback){.async_ctx_bytes = async_sz,                                            \
-                                               .variant = &class_name_##_##method_name_##_cb##modifier}};
+                                               .variant = &class_name_##_##method_name_##_cb##modifier,                \
+                                               .replaces_bytecode = replaces_bytecode_}};
 
 #define DECLARE_NATIVE_(package_path, class_name_, method_name_, method_descriptor_, modifier)                         \
   DECLARE_NATIVE_CALLBACK(class_name_, method_name_, modifier);                                                        \
-  create_init_constructor(package_path, class_name_, method_name_, method_descriptor_, modifier, 0, sync)              \
+  create_init_constructor(package_path, class_name_, method_name_, method_descriptor_, modifier, 0, sync, false)       \
       DECLARE_NATIVE_CALLBACK(class_name_, method_name_, modifier)
 
 #define DECLARE_NATIVE(package_path, class_name_, method_name_, method_descriptor_)                                    \
@@ -63,6 +64,21 @@ extern native_t *natives;
 #define DECLARE_NATIVE_OVERLOADED(package_path, class_name_, method_name_, method_descriptor_, overload_idx)           \
   force_expand_args(DECLARE_NATIVE_, package_path, class_name_, method_name_, method_descriptor_, overload_idx)
 
+// Like DECLARE_NATIVE, but for a method which the JDK implements in bytecode: the native is called instead. This is
+// for hot loops which run much faster natively (HotSpot intrinsifies most of them), so the native must behave exactly
+// like the bytecode, including for the exceptions it throws.
+#define DECLARE_INTRINSIC_NATIVE_(package_path, class_name_, method_name_, method_descriptor_, modifier)               \
+  DECLARE_NATIVE_CALLBACK(class_name_, method_name_, modifier);                                                        \
+  create_init_constructor(package_path, class_name_, method_name_, method_descriptor_, modifier, 0, sync, true)        \
+      DECLARE_NATIVE_CALLBACK(class_name_, method_name_, modifier)
+
+#define DECLARE_INTRINSIC_NATIVE(package_path, class_name_, method_name_, method_descriptor_)                          \
+  force_expand_args(DECLARE_INTRINSIC_NATIVE_, package_path, class_name_, method_name_, method_descriptor_, 0)
+
+#define DECLARE_INTRINSIC_NATIVE_OVERLOADED(package_path, class_name_, method_name_, method_descriptor_, overload_idx) \
+  force_expand_args(DECLARE_INTRINSIC_NATIVE_, package_path, class_name_, method_name_, method_descriptor_,            \
+                    overload_idx)
+
 #ifdef __cplusplus
 #define check_field_offset(m_name, member_a, member_b)
 #else
@@ -111,7 +127,7 @@ extern native_t *natives;
                               invoked_async_methods, modifier)                                                         \
   create_async_declaration(class_name_##_##method_name_##_cb##modifier, locals, invoked_async_methods);                \
   create_init_constructor(package_path, class_name_, method_name_, method_descriptor_, modifier,                       \
-                          sizeof(struct class_name_##_##method_name_##_cb##modifier##_s), async);                      \
+                          sizeof(struct class_name_##_##method_name_##_cb##modifier##_s), async, false);               \
   DEFINE_ASYNC_(, cached_state_prelude, class_name_##_##method_name_##_cb##modifier)
 
 #define DECLARE_ASYNC_NATIVE(package_path, class_name_, method_name_, method_descriptor_, locals,                      \
@@ -80,6 +80,7 @@ obj_header *make_jstring_modified_utf8(vm_thread *thread, slice string) {
     if (!value)
       goto oom;
     S->value = value;
+    gc_write_barrier(thread->vm, str->obj);
     for (int i = 0; i < len; ++i) {
       ByteArrayStore(S->value, i, (s8)chars[i]);
     }
@@ -90,6 +91,7 @@ obj_header *make_jstring_modified_utf8(vm_thread *thread, slice string) {
     if (!value)
       goto oom;
     S->value = value;
+    gc_write_barrier(thread->vm, str->obj);
     memcpy(ArrayData(S->value), chars, len * sizeof(short));
     S->coder = STRING_CODER_UTF16; // UTF-16
     result = (void *)S;
@@ -115,6 +117,7 @@ object make_jstring_cstr(vm_thread *thread, char const *cstr) {
 
   object value = CreatePrimitiveArray1D(thread, TYPE_KIND_BYTE, len);
   S->value = value;
+  gc_write_barrier(thread->vm, str->obj);
   if (!S->value)
     goto oom;
   ByteArrayStoreBlock(S->value, 0, len, (u8 *)cstr);
@@ -126,22 +129,66 @@ oom:
   return result;
 }
 
-static object lookup_interned_jstring(vm_thread *thread, object s) {
-  object raw = RawStringData(thread, s);
+// Strings with the same contents have the same coder, as long as the library only makes UTF-16 strings of what can't
+// be Latin-1, but the coder is compared anyway.
+static u32 interned_string_hash(object raw, s32 coder) {
+  return fxhash_string((char const *)ArrayData(raw), ArrayLength(raw)) ^ coder;
+}
 
-  u8 *data = ArrayData(raw);
-  s32 len = ArrayLength(raw);
+static u32 interned_string_index(const intern_table *table, u32 hash) {
+  return (hash ^ hash >> 16) & (table->capacity - 1);
+}
 
-  return hash_table_lookup(&thread->vm->interned_strings, (char const *)data, len);
+static bool same_string_contents(vm_thread *thread, object a, object b) {
+  object raw_a = RawStringData(thread, a), raw_b = RawStringData(thread, b);
+  return ((struct native_String *)a)->coder == ((struct native_String *)b)->coder &&
+         ArrayLength(raw_a) == ArrayLength(raw_b) && !memcmp(ArrayData(raw_a), ArrayData(raw_b), ArrayLength(raw_a));
 }
 
-static void insert_interned_jstring(vm_thread *thread, object s) {
-  object raw = RawStringData(thread, s);
+static object lookup_interned_jstring(vm_thread *thread, object s) {
+  intern_table *table = &thread->vm->interned_strings;
+  if (!table->capacity)
+    return nullptr;
+  u32 hash = interned_string_hash(RawStringData(thread, s), ((struct native_String *)s)->coder);
+  for (u32 i = interned_string_index(table, hash);; i = (i + 1) & (table->capacity - 1)) {
+    struct interned_string *entry = table->entries + i;
+    if (!entry->string)
+      return nullptr;
+    if (entry->string != INTERNED_TOMBSTONE && entry->hash == hash && same_string_contents(thread, entry->string, s))
+      return entry->string;
+  }
+}
 
-  u8 *data = ArrayData(raw);
-  s32 len = ArrayLength(raw);
+// Put a string which isn't in the table into a free slot, which there must be
+static void place_interned_jstring(intern_table *table, object s, u32 hash) {
+  u32 i = interned_string_index(table, hash);
+  while (table->entries[i].string && table->entries[i].string != INTERNED_TOMBSTONE)
+    i = (i + 1) & (table->capacity - 1);
+  if (!table->entries[i].string)
+    table->used++;
+  table->entries[i] = (struct interned_string){.string = s, .hash = hash};
+}
 
-  (void)hash_table_insert(&thread->vm->interned_strings, (char const *)data, len, s);
+static void insert_interned_jstring(vm_thread *thread, object s) {
+  intern_table *table = &thread->vm->interned_strings;
+  if ((table->used + 1) * 4 >= table->capacity * 3) {
+    // Rehash, dropping the tombstones left by the GC, into a table at most half full
+    u32 live = 0;
+    for (u32 i = 0; i < table->capacity; ++i)
+      live += table->entries[i].string && table->entries[i].string != INTERNED_TOMBSTONE;
+    intern_table new_table = {.capacity = 16};
+    while ((live + 1) * 2 >= new_table.capacity)
+      new_table.capacity *= 2;
+    new_table.entries = calloc(new_table.capacity, sizeof(struct interned_string));
+    for (u32 i = 0; i < table->capacity; ++i) {
+      struct interned_string *entry = table->entries + i;
+      if (entry->string && entry->string != INTERNED_TOMBSTONE)
+        place_interned_jstring(&new_table, entry->string, entry->hash);
+    }
+    free(table->entries);
+    *table = new_table;
+  }
+  place_interned_jstring(table, s, interned_string_hash(RawStringData(thread, s), ((struct native_String *)s)->coder));
 }
 
 object MakeJStringFromModifiedUTF8(vm_thread *thread, slice data, bool intern) {
@@ -189,6 +236,7 @@ obj_header *MakeJStringFromData(vm_thread *thread, slice data, string_coder_kind
 
   object value = CreatePrimitiveArray1D(thread, TYPE_KIND_BYTE, len);
   S->value = value;
+  gc_write_barrier(thread->vm, str->obj);
   if (!S->value)
     goto oom;
   ByteArrayStoreBlock(S->value, 0, len, (u8 const *)data.chars);
@@ -205,12 +253,7 @@ obj_header *InternJString(vm_thread *thread, object s) {
   if (lookup_result)
     return lookup_result;
 
-  object raw = RawStringData(thread, s);
-
-  u8 *data = ArrayData(raw);
-  s32 len = ArrayLength(raw);
-
-  (void)hash_table_insert(&thread->vm->interned_strings, (char const *)data, len, s);
+  insert_interned_jstring(thread, s);
   return s;
 }
 
@@ -2,6 +2,7 @@
 #include "cached_classdescs.h"
 
 #include <gc.h>
+#include <instrumentation.h>
 
 #ifndef OBJECTS_H
 #define OBJECTS_H
@@ -40,11 +41,12 @@ static inline obj_header *RawStringData([[maybe_unused]] vm_thread const *thread
 static inline object AllocateObject(vm_thread *thread, classdesc *descriptor, size_t allocation_size) {
   DCHECK(descriptor);
   DCHECK(descriptor->state >= CD_STATE_LINKED); // important to know the size
-  object obj = (object)bump_allocate(thread, allocation_size);
+  object obj = (object)bump_allocate(thread, descriptor, allocation_size);
   if (obj) {
     obj->header_word.expanded_data = (monitor_data *)(uintptr_t)IS_MARK_WORD;
     obj->descriptor = descriptor;
     DCHECK(size_of_object(obj) <= allocation_size);
+    InstrumentObjectAlloc(thread, descriptor, allocation_size);
   }
   return obj;
 }
@@ -52,11 +54,12 @@ static inline object AllocateObject(vm_thread *thread, classdesc *descriptor, si
 // Get the hash code of the object, computing it if it is not already computed.
 s32 get_object_hash_code(vm *vm, object o);
 
-[[maybe_unused]] static void __obj_store_field(obj_header *thing, slice field_name, stack_value value, slice desc) {
+[[maybe_unused]] static void __obj_store_field(vm_thread *thread, obj_header *thing, slice field_name,
+                                               stack_value value, slice desc) {
   cp_field *field = field_lookup(thing->descriptor, field_name, desc);
   DCHECK(field);
   DCHECK(!(field->access_flags & ACCESS_STATIC));
-  set_field(thing, field, value);
+  set_field(thread, thing, field, value);
 }
 
 [[maybe_unused]] static stack_value __obj_load_field(obj_header *thing, slice field_name, slice desc) {
@@ -70,8 +73,9 @@ s32 get_object_hash_code(vm *vm, object o);
   return __obj_load_field(thing, name, desc).obj;
 }
 
-[[maybe_unused]] static void __StoreFieldObject(obj_header *thing, slice desc, slice name, object value) {
-  __obj_store_field(thing, name, (stack_value){.obj = value}, desc);
+[[maybe_unused]] static void __StoreFieldObject(vm_thread *thread, obj_header *thing, slice desc, slice name,
+                                                object value) {
+  __obj_store_field(thread, thing, name, (stack_value){.obj = value}, desc);
 }
 
 [[maybe_unused]] static void __StoreStaticFieldObject(classdesc *clazz, slice desc, slice name, object value) {
@@ -81,14 +85,15 @@ s32 get_object_hash_code(vm *vm, object o);
   set_static_field(field, (stack_value){.obj = value});
 }
 
-#define StoreFieldObject(obj, type, name, value) __StoreFieldObject(obj, STR("L" type ";"), STR(name), value)
+#define StoreFieldObject(thread, obj, type, name, value)                                                               \
+  __StoreFieldObject(thread, obj, STR("L" type ";"), STR(name), value)
 #define StoreStaticFieldObject(obj, type, name, value)                                                                 \
   __StoreStaticFieldObject(obj, STR("L" type ";"), STR(name), value)
 #define LoadFieldObject(obj, type, name) __LoadFieldObject(obj, STR("L" type ";"), STR(name))
 
 #define GeneratePrimitiveStoreField(type_cap, type, stack_field, desc, modifier)                                       \
-  [[maybe_unused]] static void __StoreField##type_cap(obj_header *thing, slice name, type value) {                     \
-    __obj_store_field(thing, name, (stack_value){.stack_field = value modifier}, STR(#desc));                          \
+  [[maybe_unused]] static void __StoreField##type_cap(vm_thread *thread, obj_header *thing, slice name, type value) { \
+    __obj_store_field(thread, thing, name, (stack_value){.stack_field = value modifier}, STR(#desc));                  \
   }
 
 #define GeneratePrimitiveLoadField(type_cap, type, stack_field, desc)                                                  \
@@ -112,13 +117,13 @@ GeneratePrimitiveLoadField(Float, jfloat, f, F);
 GeneratePrimitiveLoadField(Double, jdouble, d, D);
 GeneratePrimitiveLoadField(Boolean, jboolean, i, Z);
 
-#define StoreFieldByte(obj, name, value) __StoreFieldByte(obj, STR(name), value)
-#define StoreFieldChar(obj, name, value) __StoreFieldChar(obj, STR(name), value)
-#define StoreFieldInt(obj, name, value) __StoreFieldInt(obj, STR(name), value)
-#define StoreFieldLong(obj, name, value) __StoreFieldLong(obj, STR(name), value)
-#define StoreFieldFloat(obj, name, value) __StoreFieldFloat(obj, STR(name), value)
-#define StoreFieldDouble(obj, name, value) __StoreFieldDouble(obj, STR(name), value)
-#define StoreFieldBoolean(obj, name, value) __StoreFieldBoolean(obj, STR(name), value)
+#define StoreFieldByte(thread, obj, name, value) __StoreFieldByte(thread, obj, STR(name), value)
+#define StoreFieldChar(thread, obj, name, value) __StoreFieldChar(thread, obj, STR(name), value)
+#define StoreFieldInt(thread, obj, name, value) __StoreFieldInt(thread, obj, STR(name), value)
+#define StoreFieldLong(thread, obj, name, value) __StoreFieldLong(thread, obj, STR(name), value)
+#define StoreFieldFloat(thread, obj, name, value) __StoreFieldFloat(thread, obj, STR(name), value)
+#define StoreFieldDouble(thread, obj, name, value) __StoreFieldDouble(thread, obj, STR(name), value)
+#define StoreFieldBoolean(thread, obj, name, value) __StoreFieldBoolean(thread, obj, STR(name), value)
 
 #define LoadFieldByte(obj, name) __LoadFieldByte(obj, STR(name))
 #define LoadFieldChar(obj, name) __LoadFieldChar(obj, STR(name))
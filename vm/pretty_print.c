@@ -201,7 +201,10 @@ const char *insn_code_to_string(insn_code_kind code) {
     CASE(invokevtable_polymorphic)
     CASE(invokeitable_monomorphic)
     CASE(invokeitable_polymorphic)
+    CASE(invokevtable_pic)
+    CASE(invokeitable_pic)
     CASE(invokespecial_resolved)
+    CASE(invokevirtual_direct)
     CASE(invokestatic_resolved)
     CASE(invokecallsite)
     CASE(getfield_B)
@@ -212,6 +215,7 @@ const char *insn_code_to_string(insn_code_kind code) {
     CASE(getfield_F)
     CASE(getfield_D)
     CASE(getfield_L)
+    CASE(getfield_N)
     CASE(getfield_Z)
     CASE(putfield_B)
     CASE(putfield_C)
@@ -221,6 +225,7 @@ const char *insn_code_to_string(insn_code_kind code) {
     CASE(putfield_F)
     CASE(putfield_D)
     CASE(putfield_L)
+    CASE(putfield_N)
     CASE(putfield_Z)
     CASE(getstatic_B)
     CASE(getstatic_C)
@@ -242,6 +247,56 @@ const char *insn_code_to_string(insn_code_kind code) {
     CASE(putstatic_Z)
     CASE(invokesigpoly)
     CASE(sqrt)
+    CASE(iabs)
+    CASE(labs)
+    CASE(fabs)
+    CASE(dabs)
+    CASE(imin)
+    CASE(imax)
+    CASE(lmin)
+    CASE(lmax)
+    CASE(fmin)
+    CASE(fmax)
+    CASE(dmin)
+    CASE(dmax)
+    CASE(ffma)
+    CASE(dfma)
+    CASE(floor)
+    CASE(ceil)
+    CASE(iclz)
+    CASE(lclz)
+    CASE(ipopcount)
+    CASE(lpopcount)
+    CASE(ibswap)
+    CASE(lbswap)
+    CASE(float_to_raw_int_bits)
+    CASE(int_bits_to_float)
+    CASE(double_to_raw_long_bits)
+    CASE(long_bits_to_double)
+    CASE(get_class)
+    CASE(current_thread)
+    CASE(identity_hash_code)
+    CASE(aload_getfield)
+    CASE(aload_getfield_B)
+    CASE(aload_getfield_C)
+    CASE(aload_getfield_S)
+    CASE(aload_getfield_I)
+    CASE(aload_getfield_J)
+    CASE(aload_getfield_F)
+    CASE(aload_getfield_D)
+    CASE(aload_getfield_Z)
+    CASE(aload_getfield_L)
+    CASE(aload_getfield_N)
+    CASE(aload_arraylength)
+    CASE(iload_iload_iadd)
+    CASE(iload_iload_isub)
+    CASE(iload_iconst_if_icmpeq)
+    CASE(iload_iconst_if_icmpne)
+    CASE(iload_iconst_if_icmplt)
+    CASE(iload_iconst_if_icmpge)
+    CASE(iload_iconst_if_icmpgt)
+    CASE(iload_iconst_if_icmple)
+    CASE(iinc_goto)
   }
   printf("Unknown code: %d\n", code);
   UNREACHABLE();
@@ -392,6 +447,9 @@ heap_string insn_to_string(const bytecode_insn *insn, int insn_index) {
   } else if (insn->kind <= insn_ifnull) {
     // indexes into the instruction array
     build_str(&result, write, "inst %d", insn->index);
+  } else if (insn->kind >= insn_aload_getfield && insn->kind <= insn_iload_iconst_if_icmple) {
+    // superinstructions starting with a local variable load
+    build_str(&result, write, "#%d", insn->index);
   } else if (insn->kind == insn_lconst || insn->kind == insn_iconst) {
     build_str(&result, write, "%" PRId64, insn->integer_imm);
   } else if (insn->kind == insn_dconst || insn->kind == insn_fconst) {
@@ -408,6 +466,10 @@ heap_string insn_to_string(const bytecode_insn *insn, int insn_index) {
       write = build_str(&result, write, ", %d -> %d", insn->lookupswitch->keys[i], insn->lookupswitch->targets[i]);
     }
     build_str(&result, write, " ]");
+  } else if (insn->kind == insn_invokevtable_pic || insn->kind == insn_invokeitable_pic) {
+    const polymorphic_ic *pic = insn->ic;
+    build_str(&result, write, "[ %d receivers, %" PRIu64 " hits, %" PRIu64 " misses ]", pic->count, pic->hits,
+              pic->misses);
   } else {
     // TODO
     build_str(&result, write, "<unimplemented>");
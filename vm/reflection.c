@@ -22,12 +22,15 @@ void reflect_initialize_field(vm_thread *thread, classdesc *cd, cp_field *field)
   if (!name)
     goto oom;
   F->name = name;
+  gc_write_barrier(thread->vm, field_mirror->obj);
   object mirror = (void *)get_class_mirror(thread, cd);
   if (!mirror)
     goto oom;
   F->clazz = mirror;
+  gc_write_barrier(thread->vm, field_mirror->obj);
   mirror = (void *)get_class_mirror(thread, load_class_of_field_descriptor(thread, field->descriptor));
   F->type = mirror;
+  gc_write_barrier(thread->vm, field_mirror->obj);
   F->modifiers = field->access_flags;
 
   // Find runtimevisibleannotations attribute and signature attribute
@@ -36,11 +39,13 @@ void reflect_initialize_field(vm_thread *thread, classdesc *cd, cp_field *field)
       const attribute_runtime_visible_annotations a = field->attributes[i].annotations;
       object annotations = CreatePrimitiveArray1D(thread, TYPE_KIND_BYTE, a.length);
       F->annotations = annotations;
+      gc_write_barrier(thread->vm, field_mirror->obj);
       memcpy(ArrayData(F->annotations), a.data, field->attributes[i].length);
     } else if (field->attributes[i].kind == ATTRIBUTE_KIND_SIGNATURE) {
       const attribute_signature a = field->attributes[i].signature;
       object signature = MakeJStringFromModifiedUTF8(thread, a.utf8, true);
       F->signature = signature;
+      gc_write_barrier(thread->vm, field_mirror->obj);
     }
   }
 #undef F
@@ -60,19 +65,22 @@ void reflect_initialize_constructor(vm_thread *thread, classdesc *cd, cp_method
   C->reflected_ctor = method;
   object mirror = (void *)get_class_mirror(thread, cd);
   C->clazz = mirror;
+  gc_write_barrier(thread->vm, result->obj);
   C->modifiers = method->access_flags;
   object parameterTypes =
       CreateObjectArray1D(thread, cached_classes(thread->vm)->klass, method->descriptor->args_count);
   C->parameterTypes = parameterTypes;
+  gc_write_barrier(thread->vm, result->obj);
   object exceptionTypes = CreateObjectArray1D(thread, bootstrap_lookup_class(thread, STR("java/lang/Class")), 0);
   C->exceptionTypes = exceptionTypes;
+  gc_write_barrier(thread->vm, result->obj);
   C->slot = (s32)method->my_index;
   // TODO parse these ^^
 
   for (int i = 0; i < method->descriptor->args_count; ++i) {
     slice desc = method->descriptor->args[i].unparsed;
     struct native_Class *type = (void *)get_class_mirror(thread, load_class_of_field_descriptor(thread, desc));
-    ((struct native_Class **)ArrayData(C->parameterTypes))[i] = type;
+    ReferenceArrayStore(thread, C->parameterTypes, i, (void *)type);
   }
 
 #undef C
@@ -94,10 +102,12 @@ void reflect_initialize_method(vm_thread *thread, classdesc *cd, cp_method *meth
   if (!name)
     goto oom;
   M->name = name;
+  gc_write_barrier(thread->vm, result->obj);
   object mirror = (void *)get_class_mirror(thread, cd);
   if (!mirror)
     goto oom;
   M->clazz = mirror;
+  gc_write_barrier(thread->vm, result->obj);
 
   for (int i = 0; i < method->attributes_count; ++i) {
     const attribute *attr = method->attributes + i;
@@ -106,18 +116,22 @@ void reflect_initialize_method(vm_thread *thread, classdesc *cd, cp_method *meth
     case ATTRIBUTE_KIND_RUNTIME_VISIBLE_ANNOTATIONS:
       obj = CreateByteArray(thread, attr->annotations.data, attr->annotations.length);
       M->annotations = obj;
+      gc_write_barrier(thread->vm, result->obj);
       break;
     case ATTRIBUTE_KIND_RUNTIME_VISIBLE_PARAMETER_ANNOTATIONS:
       obj = CreateByteArray(thread, attr->parameter_annotations.data, attr->parameter_annotations.length);
       M->parameterAnnotations = obj;
+      gc_write_barrier(thread->vm, result->obj);
       break;
     case ATTRIBUTE_KIND_ANNOTATION_DEFAULT:
       obj = CreateByteArray(thread, attr->annotation_default.data, attr->annotation_default.length);
       M->annotationDefault = obj;
+      gc_write_barrier(thread->vm, result->obj);
       break;
     case ATTRIBUTE_KIND_SIGNATURE:
       obj = MakeJStringFromModifiedUTF8(thread, attr->signature.utf8, true);
       M->signature = obj;
+      gc_write_barrier(thread->vm, result->obj);
       break;
     default:
       break;
@@ -129,17 +143,20 @@ void reflect_initialize_method(vm_thread *thread, classdesc *cd, cp_method *meth
   object parameterTypes = CreateObjectArray1D(thread, bootstrap_lookup_class(thread, STR("java/lang/Class")),
                                               method->descriptor->args_count);
   M->parameterTypes = parameterTypes;
+  gc_write_barrier(thread->vm, result->obj);
   for (int i = 0; i < method->descriptor->args_count; ++i) {
     slice desc = method->descriptor->args[i].unparsed;
     object mirror = (void *)get_class_mirror(thread, load_class_of_field_descriptor(thread, desc));
-    ((void **)ArrayData(M->parameterTypes))[i] = mirror;
+    ReferenceArrayStore(thread, M->parameterTypes, i, mirror);
   }
 
   slice ret_desc = method->descriptor->return_type.unparsed;
   mirror = (void *)get_class_mirror(thread, load_class_of_field_descriptor(thread, ret_desc));
   M->returnType = mirror;
+  gc_write_barrier(thread->vm, result->obj);
   object exceptionTypes = CreateObjectArray1D(thread, bootstrap_lookup_class(thread, STR("java/lang/Class")), 0);
   M->exceptionTypes = exceptionTypes;
+  gc_write_barrier(thread->vm, result->obj);
   M->slot = (s32)method->my_index;
   // TODO parse these ^^
 
@@ -168,15 +185,17 @@ static obj_header *get_method_parameters_impl(vm_thread *thread, cp_method *meth
       goto oom;
     object name = MakeJStringFromModifiedUTF8(thread, mparams.params[j].name, true);
     P->name = name;
+    gc_write_barrier(thread->vm, parameter->obj);
     if (!P->name)
       goto oom;
     P->executable = method->reflection_method ? (void *)method->reflection_method : (void *)method->reflection_ctor;
     DCHECK(P->executable); // we should have already initialised the method
+    gc_write_barrier(thread->vm, parameter->obj);
 
     P->index = j;
     P->modifiers = mparams.params[j].access_flags;
 
-    ReferenceArrayStore(params->obj, j, parameter->obj);
+    ReferenceArrayStore(thread, params->obj, j, parameter->obj);
   }
 
   result = params->obj; // Success!
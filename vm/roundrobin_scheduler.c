@@ -3,6 +3,7 @@
 #include "roundrobin_scheduler.h"
 
 #include "exceptions.h"
+#include "gc.h"
 
 typedef struct {
   call_interpreter_t call;
@@ -109,7 +110,8 @@ static bool is_sleeping(thread_info *info, u64 time) {
   if (info->wakeup_info->kind == RR_WAKEUP_SLEEP
       || (info->wakeup_info->kind == RR_THREAD_PARK && !query_unpark_permit(info->thread))
       || (info->wakeup_info->kind == RR_MONITOR_WAIT && !info->wakeup_info->monitor_wakeup.ready)
-      || (info->wakeup_info->kind == RR_MONITOR_ENTER_WAITING && !info->wakeup_info->monitor_wakeup.ready)) {
+      || (info->wakeup_info->kind == RR_MONITOR_ENTER_WAITING && !info->wakeup_info->monitor_wakeup.ready)
+      || (info->wakeup_info->kind == RR_REFERENCE_PENDING && !info->thread->vm->reference_pending_list)) {
     u64 wakeup = info->wakeup_info->wakeup_us;
     // montitor enter is non-interruptible by Java language spec
     bool interrupted = info->thread->thread_obj->interrupted && info->wakeup_info->kind != RR_MONITOR_ENTER_WAITING;
@@ -210,6 +212,10 @@ scheduler_status_t rr_scheduler_step(rr_scheduler *scheduler) {
   if (arrlen(impl->round_robin) == 0 || only_daemons_running(impl->round_robin))
     return SCHEDULER_RESULT_DONE;
 
+  // Give an incremental major GC its slice before running the next thread
+  if (scheduler->vm->incremental_mark)
+    incremental_gc_step(scheduler->vm);
+
   u64 time = get_unix_us();
   thread_info *info = get_next_thr(impl);
   if (!info) // returned nullptr; no threads are available to run
@@ -317,7 +323,7 @@ bool is_nth_arg_reference(cp_method *method, int i) {
   return i == 0 || method->descriptor->args[i - 1].repr_kind == TYPE_KIND_REFERENCE;
 }
 
-void rr_scheduler_enumerate_gc_roots(rr_scheduler *scheduler, object **stbds_vector) {
+void rr_scheduler_enumerate_gc_roots(rr_scheduler *scheduler, object ***stbds_vector) {
   // Iterate through all pending_calls and add object arguments as roots
   impl *I = scheduler->_impl;
   for (int i = 0; i < arrlen(I->round_robin); i++) {
@@ -326,7 +332,7 @@ void rr_scheduler_enumerate_gc_roots(rr_scheduler *scheduler, object **stbds_vec
       pending_call *call = &info->call_queue[j];
       for (int k = 0; k < method_argc(call->call.args.method); k++) {
         if (is_nth_arg_reference(call->call.args.method, k)) {
-          arrput(stbds_vector, &call->call.args.args[k].obj);
+          arrput(*stbds_vector, &call->call.args.args[k].obj);
         }
       }
     }
@@ -48,6 +48,7 @@ typedef enum {
   RR_THREAD_PARK,           // Unsafe.park
   RR_MONITOR_ENTER_WAITING, // wants to acquire mutex, but it's contended
   RR_MONITOR_WAIT,          // isn't holding, but is waiting for notify
+  RR_REFERENCE_PENDING,     // ReferenceHandler waiting for the GC to clear some references
 } rr_wakeup_kind;
 
 typedef struct {
@@ -63,7 +64,7 @@ typedef struct {
 
 execution_record *rr_scheduler_run(rr_scheduler *scheduler, call_interpreter_t call);
 void free_execution_record(execution_record *record);
-void rr_scheduler_enumerate_gc_roots(rr_scheduler *scheduler, object **stbds_vector);
+void rr_scheduler_enumerate_gc_roots(rr_scheduler *scheduler, object ***stbds_vector);
 
 void monitor_notify_one(rr_scheduler *scheduler, obj_header *monitor);
 void monitor_notify_all(rr_scheduler *scheduler, obj_header *monitor);
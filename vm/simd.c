@@ -0,0 +1,291 @@
+#include "simd.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SIMD_WASM 1
+#endif
+
+// Powers of 31, for combining several elements of a polynomial hash at once (u32 arithmetic wraps like Java's int)
+#define P31_2 (31u * 31u)
+#define P31_3 (P31_2 * 31u)
+#define P31_4 (P31_2 * P31_2)
+#define P31_5 (P31_4 * 31u)
+#define P31_6 (P31_4 * P31_2)
+#define P31_7 (P31_4 * P31_3)
+#define P31_8 (P31_4 * P31_4)
+
+#if SIMD_X86
+// SSE2 is part of the x86-64 baseline, but AVX2 isn't, so the AVX2 kernels are compiled for it separately and only
+// called if the CPU has it.
+#define AVX2 __attribute__((target("avx2")))
+
+static bool has_avx2() {
+#ifdef __AVX2__
+  return true;
+#else
+  static int cached = -1;
+  if (cached < 0)
+    cached = __builtin_cpu_supports("avx2") != 0;
+  return cached;
+#endif
+}
+
+// The vector loops below stop at the first block which needs a closer look (or at the last whole block), and return
+// where they stopped; the scalar loops then finish the job.
+
+AVX2 static size_t mismatch_avx2(const u8 *a, const u8 *b, size_t len) {
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                   _mm256_loadu_si256((const __m256i *)(b + i)));
+    if ((u32)_mm256_movemask_epi8(eq) != 0xFFFFFFFF)
+      break;
+  }
+  return i;
+}
+
+static size_t mismatch_sse2(const u8 *a, const u8 *b, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+    if (_mm_movemask_epi8(eq) != 0xFFFF)
+      break;
+  }
+  return i;
+}
+
+AVX2 static size_t index_of_byte_avx2(const u8 *p, u8 c, size_t len) {
+  __m256i needle = _mm256_set1_epi8((char)c);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), needle)))
+      break;
+  }
+  return i;
+}
+
+static size_t index_of_byte_sse2(const u8 *p, u8 c, size_t len) {
+  __m128i needle = _mm_set1_epi8((char)c);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), needle)))
+      break;
+  }
+  return i;
+}
+
+// Eight lanes, each accumulating every eighth element: per block of eight, acc = acc * 31^8 + block. At the end,
+// lane k is weighted by 31^(7 - k), as though followed by the rest of its block.
+#define HASH_AVX2(name, type, load)                                                                                    \
+  AVX2 static size_t hash_##name##_avx2(u32 *h, const type *p, size_t len) {                                           \
+    __m256i acc = _mm256_setzero_si256(), block_mul = _mm256_set1_epi32((int)P31_8);                                   \
+    u32 hh = *h;                                                                                                       \
+    size_t i = 0;                                                                                                      \
+    for (; i + 8 <= len; i += 8) {                                                                                     \
+      acc = _mm256_add_epi32(_mm256_mullo_epi32(acc, block_mul), load);                                                \
+      hh *= P31_8;                                                                                                     \
+    }                                                                                                                  \
+    __m256i weights =                                                                                                  \
+        _mm256_setr_epi32((int)P31_7, (int)P31_6, (int)P31_5, (int)P31_4, (int)P31_3, (int)P31_2, 31, 1);              \
+    u32 lanes[8];                                                                                                      \
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_mullo_epi32(acc, weights));                                           \
+    for (int k = 0; k < 8; ++k)                                                                                        \
+      hh += lanes[k];                                                                                                  \
+    *h = hh;                                                                                                           \
+    return i;                                                                                                          \
+  }
+
+HASH_AVX2(u8, u8, _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(p + i))))
+HASH_AVX2(s8, s8, _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(p + i))))
+HASH_AVX2(u16, u16, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p + i))))
+HASH_AVX2(s16, s16, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(p + i))))
+HASH_AVX2(s32, s32, _mm256_loadu_si256((const __m256i *)(p + i)))
+
+#define HASH_VECTOR(name, h, p, len) (has_avx2() ? hash_##name##_avx2(h, p, len) : 0)
+
+#elif SIMD_WASM
+
+#define HASH_WASM(name, type, load)                                                                                    \
+  static size_t hash_##name##_wasm(u32 *h, const type *p, size_t len) {                                                \
+    v128_t acc = wasm_i32x4_splat(0), block_mul = wasm_i32x4_splat((s32)P31_4);                                        \
+    u32 hh = *h;                                                                                                       \
+    size_t i = 0;                                                                                                      \
+    for (; i + 4 <= len; i += 4) {                                                                                     \
+      acc = wasm_i32x4_add(wasm_i32x4_mul(acc, block_mul), load);                                                      \
+      hh *= P31_4;                                                                                                     \
+    }                                                                                                                  \
+    acc = wasm_i32x4_mul(acc, wasm_i32x4_make((s32)P31_3, (s32)P31_2, 31, 1));                                         \
+    hh += (u32)wasm_i32x4_extract_lane(acc, 0) + (u32)wasm_i32x4_extract_lane(acc, 1) +                              \
+          (u32)wasm_i32x4_extract_lane(acc, 2) + (u32)wasm_i32x4_extract_lane(acc, 3);                                 \
+    *h = hh;                                                                                                           \
+    return i;                                                                                                          \
+  }
+
+HASH_WASM(u8, u8, wasm_u32x4_extend_low_u16x8(wasm_u16x8_extend_low_u8x16(wasm_v128_load32_zero(p + i))))
+HASH_WASM(s8, s8, wasm_i32x4_extend_low_i16x8(wasm_i16x8_extend_low_i8x16(wasm_v128_load32_zero(p + i))))
+HASH_WASM(u16, u16, wasm_u32x4_extend_low_u16x8(wasm_v128_load64_zero(p + i)))
+HASH_WASM(s16, s16, wasm_i32x4_extend_low_i16x8(wasm_v128_load64_zero(p + i)))
+HASH_WASM(s32, s32, wasm_v128_load(p + i))
+
+#define HASH_VECTOR(name, h, p, len) hash_##name##_wasm(h, p, len)
+
+#else
+#define HASH_VECTOR(name, h, p, len) 0
+#endif
+
+ptrdiff_t simd_mismatch(const void *a_, const void *b_, size_t len) {
+  const u8 *a = a_, *b = b_;
+  size_t i = 0;
+#if SIMD_X86
+  i = has_avx2() ? mismatch_avx2(a, b, len) : mismatch_sse2(a, b, len);
+#elif SIMD_WASM
+  for (; i + 16 <= len; i += 16) {
+    if (!wasm_i8x16_all_true(wasm_i8x16_eq(wasm_v128_load(a + i), wasm_v128_load(b + i))))
+      break;
+  }
+#endif
+  for (; i < len; ++i) {
+    if (a[i] != b[i])
+      return (ptrdiff_t)i;
+  }
+  return -1;
+}
+
+ptrdiff_t simd_index_of_byte(const u8 *p, u8 c, size_t len) {
+  size_t i = 0;
+#if SIMD_X86
+  i = has_avx2() ? index_of_byte_avx2(p, c, len) : index_of_byte_sse2(p, c, len);
+#elif SIMD_WASM
+  v128_t needle = wasm_i8x16_splat((s8)c);
+  for (; i + 16 <= len; i += 16) {
+    if (wasm_v128_any_true(wasm_i8x16_eq(wasm_v128_load(p + i), needle)))
+      break;
+  }
+#endif
+  for (; i < len; ++i) {
+    if (p[i] == c)
+      return (ptrdiff_t)i;
+  }
+  return -1;
+}
+
+#define DEFINE_HASH(name, type)                                                                                        \
+  s32 simd_hash_##name(s32 h_, const type *p, size_t len) {                                                            \
+    u32 h = (u32)h_;                                                                                                   \
+    size_t i = HASH_VECTOR(name, &h, p, len);                                                                          \
+    for (; i + 4 <= len; i += 4)                                                                                       \
+      h = h * P31_4 + (u32)p[i] * P31_3 + (u32)p[i + 1] * P31_2 + (u32)p[i + 2] * 31u + (u32)p[i + 3];                 \
+    for (; i < len; ++i)                                                                                               \
+      h = 31u * h + (u32)p[i];                                                                                         \
+    return (s32)h;                                                                                                     \
+  }
+
+DEFINE_HASH(u8, u8)
+DEFINE_HASH(s8, s8)
+DEFINE_HASH(u16, u16)
+DEFINE_HASH(s16, s16)
+DEFINE_HASH(s32, s32)
+
+void simd_inflate_latin1(u16 *dst, const u8 *src, size_t len) {
+  size_t i = 0;
+#if SIMD_X86
+  __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128((__m128i *)(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+  }
+#elif SIMD_WASM
+  for (; i + 16 <= len; i += 16) {
+    v128_t v = wasm_v128_load(src + i);
+    wasm_v128_store(dst + i, wasm_u16x8_extend_low_u8x16(v));
+    wasm_v128_store(dst + i + 8, wasm_u16x8_extend_high_u8x16(v));
+  }
+#endif
+  for (; i < len; ++i)
+    dst[i] = src[i];
+}
+
+size_t simd_compress_utf16(u8 *dst, const u16 *src, size_t len) {
+  size_t i = 0;
+  // Nothing is stored for a block containing a code unit above 0xFF; the scalar loop stores up to it instead
+#if SIMD_X86
+  __m128i high_byte = _mm_set1_epi16((short)0xFF00), zero = _mm_setzero_si128();
+  for (; i + 16 <= len; i += 16) {
+    __m128i lo = _mm_loadu_si128((const __m128i *)(src + i)), hi = _mm_loadu_si128((const __m128i *)(src + i + 8));
+    __m128i high_bits = _mm_and_si128(_mm_or_si128(lo, hi), high_byte);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(high_bits, zero)) != 0xFFFF)
+      break;
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+  }
+#elif SIMD_WASM
+  v128_t high_byte = wasm_i16x8_splat((s16)0xFF00);
+  for (; i + 16 <= len; i += 16) {
+    v128_t lo = wasm_v128_load(src + i), hi = wasm_v128_load(src + i + 8);
+    if (wasm_v128_any_true(wasm_v128_and(wasm_v128_or(lo, hi), high_byte)))
+      break;
+    wasm_v128_store(dst + i, wasm_u8x16_narrow_i16x8(lo, hi));
+  }
+#endif
+  for (; i < len; ++i) {
+    if (src[i] > 0xFF)
+      return i;
+    dst[i] = (u8)src[i];
+  }
+  return len;
+}
+
+#if SIMD_X86
+#define FILL_LOOP(dst, len, lanes, splat)                                                                              \
+  {                                                                                                                    \
+    __m128i v = splat;                                                                                                 \
+    for (; i + lanes <= len; i += lanes)                                                                               \
+      _mm_storeu_si128((__m128i *)(dst + i), v);                                                                       \
+  }
+#elif SIMD_WASM
+#define FILL_LOOP(dst, len, lanes, splat)                                                                              \
+  {                                                                                                                    \
+    v128_t v = splat;                                                                                                  \
+    for (; i + lanes <= len; i += lanes)                                                                               \
+      wasm_v128_store(dst + i, v);                                                                                     \
+  }
+#else
+#define FILL_LOOP(dst, len, lanes, splat)
+#endif
+
+#if SIMD_X86
+#define SPLAT_16(value) _mm_set1_epi16((short)value)
+#define SPLAT_32(value) _mm_set1_epi32((int)value)
+#define SPLAT_64(value) _mm_set1_epi64x((long long)value)
+#elif SIMD_WASM
+#define SPLAT_16(value) wasm_i16x8_splat((s16)value)
+#define SPLAT_32(value) wasm_i32x4_splat((s32)value)
+#define SPLAT_64(value) wasm_i64x2_splat((s64)value)
+#endif
+
+void simd_fill_16(u16 *dst, u16 value, size_t len) {
+  size_t i = 0;
+  FILL_LOOP(dst, len, 8, SPLAT_16(value))
+  for (; i < len; ++i)
+    dst[i] = value;
+}
+
+void simd_fill_32(u32 *dst, u32 value, size_t len) {
+  size_t i = 0;
+  FILL_LOOP(dst, len, 4, SPLAT_32(value))
+  for (; i < len; ++i)
+    dst[i] = value;
+}
+
+void simd_fill_64(u64 *dst, u64 value, size_t len) {
+  size_t i = 0;
+  FILL_LOOP(dst, len, 2, SPLAT_64(value))
+  for (; i < len; ++i)
+    dst[i] = value;
+}
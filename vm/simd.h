@@ -0,0 +1,43 @@
+// Vectorized kernels for the hot loops of the JDK's array and string code (ArraysSupport, StringLatin1, StringUTF16,
+// Arrays), which the natives in natives/share use in place of the bytecode. Each has an SSE2/AVX2 implementation on
+// x86-64, a SIMD128 implementation on WebAssembly and a scalar fallback everywhere else.
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+#include <types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Index of the first byte at which a and b differ, or -1 if the first len bytes are equal
+ptrdiff_t simd_mismatch(const void *a, const void *b, size_t len);
+
+// Index of the first occurrence of c in the first len bytes of p, or -1
+ptrdiff_t simd_index_of_byte(const u8 *p, u8 c, size_t len);
+
+// Java's polymorphic hash (h = 31 * h + element) over len elements, starting from h
+s32 simd_hash_u8(s32 h, const u8 *p, size_t len);
+s32 simd_hash_s8(s32 h, const s8 *p, size_t len);
+s32 simd_hash_u16(s32 h, const u16 *p, size_t len);
+s32 simd_hash_s16(s32 h, const s16 *p, size_t len);
+s32 simd_hash_s32(s32 h, const s32 *p, size_t len);
+
+// Zero-extend len Latin-1 bytes to UTF-16 code units
+void simd_inflate_latin1(u16 *dst, const u8 *src, size_t len);
+
+// Narrow UTF-16 code units to Latin-1 bytes, stopping at the first one above 0xFF. Returns the number converted.
+size_t simd_compress_utf16(u8 *dst, const u16 *src, size_t len);
+
+// Store len copies of value
+void simd_fill_16(u16 *dst, u16 value, size_t len);
+void simd_fill_32(u32 *dst, u32 value, size_t len);
+void simd_fill_64(u64 *dst, u64 value, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
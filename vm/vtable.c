@@ -188,6 +188,64 @@ static void setup_itables(classdesc *super, classdesc *cd) {
   free_hash_table(ambiguous);
 }
 
+// Build the hash table from interfaces to their itables, kept at most half full
+static void index_itables(itables *itables) {
+  int count = arrlen(itables->interfaces);
+  if (count == 0)
+    return;
+  u32 capacity = 4;
+  while (capacity < 2 * (u32)count)
+    capacity *= 2;
+  itables->slots = calloc(capacity, sizeof(u16));
+  itables->slots_mask = capacity - 1;
+  for (int i = 0; i < count; ++i) {
+    u32 slot = itable_home_slot(itables, itables->interfaces[i]);
+    while (itables->slots[slot])
+      slot = (slot + 1) & itables->slots_mask;
+    itables->slots[slot] = (u16)(i + 1);
+  }
+}
+
+int itable_find(classdesc const *cd, classdesc const *interface) {
+  const itables *itables = &cd->itables;
+  if (!itables->slots)
+    return -1;
+  u32 slot = itable_home_slot(itables, interface);
+  u16 entry;
+  while ((entry = itables->slots[slot])) {
+    if (itables->interfaces[entry - 1] == interface)
+      return entry - 1;
+    slot = (slot + 1) & itables->slots_mask;
+  }
+  return -1;
+}
+
+bool can_devirtualize(cp_method const *method, classdesc const *receiver_class, bool *needs_dependency) {
+  if (method->access_flags & ACCESS_ABSTRACT)
+    return false;
+  // Private methods aren't in the vtable at all
+  if (method->access_flags & ACCESS_PRIVATE) {
+    *needs_dependency = false;
+    return true;
+  }
+  if (method->overridden || vtable_lookup(receiver_class, method->vtable_index) != method)
+    return false;
+  *needs_dependency = !(method->access_flags & ACCESS_FINAL) && !(method->my_class->access_flags & ACCESS_FINAL);
+  return true;
+}
+
+// Class hierarchy analysis: the method now has an overrider, so calls which were devirtualized on the assumption that
+// it had none go back to being ordinary invokevirtuals, and will be quickened again when next executed.
+static void mark_overridden(cp_method *method) {
+  method->overridden = true;
+  for (int i = 0; i < arrlen(method->devirtualized_calls); ++i) {
+    bytecode_insn *insn = method->devirtualized_calls[i];
+    DCHECK(insn->kind == insn_invokevirtual_direct && insn->ic == method);
+    insn->kind = insn_invokevirtual;
+  }
+  arrfree(method->devirtualized_calls);
+}
+
 // TODO consider optimizing final methods out of the tables?
 void set_up_function_tables(classdesc *cd) {
   vtable *vtable = &cd->vtable;
@@ -203,6 +261,7 @@ void set_up_function_tables(classdesc *cd) {
       if (method_overrides(replacement, method)) {
         replacement->vtable_index = method->vtable_index;
         DCHECK(method->vtable_index == i);
+        mark_overridden(method);
         method = replacement;
         replacement->overrides = true;
       }
@@ -238,6 +297,8 @@ void set_up_function_tables(classdesc *cd) {
       arrpush(vtable->methods, method);
     }
   }
+
+  index_itables(&cd->itables);
 }
 
 void free_function_tables(classdesc *classdesc) {
@@ -247,6 +308,8 @@ void free_function_tables(classdesc *classdesc) {
   }
   arrfree(classdesc->itables.interfaces);
   arrfree(classdesc->itables.entries);
+  free(classdesc->itables.slots);
+  classdesc->itables.slots = nullptr;
 }
 
 cp_method *vtable_lookup(classdesc const *classdesc, size_t index) {
@@ -255,17 +318,15 @@ cp_method *vtable_lookup(classdesc const *classdesc, size_t index) {
 }
 
 cp_method *itable_lookup(classdesc const *cd, classdesc const *interface, size_t index) {
-  for (int i = 0; i < arrlen(cd->itables.interfaces); ++i) {
-    if (cd->itables.interfaces[i] == interface) {
-      itable itable = cd->itables.entries[i];
-      DCHECK(index < arrlenu(itable.methods) && "itable index out of range");
-      itable_method_t m = itable.methods[index];
-      if (m & ITABLE_METHOD_BIT_INVALID) {
-        return nullptr;
-      }
-      cp_method *method = (cp_method *)m;
-      return method;
-    }
+  int i = itable_find(cd, interface);
+  if (i < 0)
+    return nullptr;
+  itable itable = cd->itables.entries[i];
+  DCHECK(index < arrlenu(itable.methods) && "itable index out of range");
+  itable_method_t m = itable.methods[index];
+  if (m & ITABLE_METHOD_BIT_INVALID) {
+    return nullptr;
   }
-  return nullptr;
+  cp_method *method = (cp_method *)m;
+  return method;
 }
\ No newline at end of file
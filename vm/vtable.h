@@ -52,12 +52,21 @@ typedef struct {
 } itable;
 
 typedef struct {
-  // Scan this vector for the interface in question ...
+  // Find the interface in question in this vector ...
   classdesc **interfaces;
   // ... and look for the matching itable here
   itable *entries;
+  // Open-addressed hash table from an interface to one plus its index in the vectors above (0 for an empty slot), so
+  // that finding an interface takes constant time however many the class implements. Null if there are no interfaces.
+  u16 *slots;
+  u32 slots_mask;
 } itables;
 
+// Slot of the hash table at which the search for the interface starts
+static inline u32 itable_home_slot(const itables *itables, classdesc const *interface) {
+  return (u32)(((u64)(uintptr_t)interface * 0x9E3779B97F4A7C15ull) >> 32) & itables->slots_mask;
+}
+
 // Set up a class descriptor's itables and vtable, assuming all of its
 // superinterfaces and its superclass have already been linked (and their
 // itables/vtable set up).
@@ -69,6 +78,14 @@ void free_function_tables(classdesc *classdesc);
 // Look up a method in the vtable. No ranges are checked.
 cp_method *vtable_lookup(classdesc const *classdesc, size_t index);
 
+// Whether an invokevirtual which resolved to the given method, and is executing with a receiver of the given class,
+// can call the method directly because no loaded class overrides it. If so, sets *needs_dependency to whether the call
+// must be added to the method's devirtualized_calls, to be undone if a class overriding the method is loaded later.
+bool can_devirtualize(cp_method const *method, classdesc const *receiver_class, bool *needs_dependency);
+
+// Find the index of the interface's itable in the class's itables, or -1 if the class doesn't implement it.
+int itable_find(classdesc const *cd, classdesc const *interface);
+
 // Look up a method in the itables. No ranges are checked, but nullptr is
 // returned if the object does not actually implement the method, or if there
 // are multiple methods that could be called.
@@ -692,6 +692,18 @@ wasm_expression *wasm_br(wasm_module *module, wasm_expression *condition, wasm_e
   return result;
 }
 
+wasm_expression *wasm_br_table(wasm_module *module, wasm_expression *condition, wasm_expression **exprs,
+                               int expr_count, wasm_expression *dflt) {
+  wasm_expression *result = module_expr(module, WASM_EXPR_KIND_BR_TABLE);
+  result->br_table = (wasm_br_table_expression){
+      .condition = condition,
+      .exprs = module_copy(module, exprs, sizeof(wasm_expression *) * expr_count),
+      .expr_count = expr_count,
+      .dflt = dflt,
+  };
+  return result;
+}
+
 wasm_expression *wasm_call(wasm_module *module, wasm_function *fn, wasm_expression **args, int arg_count) {
   wasm_expression *result = module_expr(module, WASM_EXPR_KIND_CALL);
   wasm_expression **cpy = module_copy(module, args, sizeof(wasm_expression *) * arg_count);
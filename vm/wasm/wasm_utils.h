@@ -470,6 +470,8 @@ wasm_expression *wasm_block(wasm_module *module, wasm_expression **exprs, int ex
 wasm_expression *wasm_update_block(wasm_module *module, wasm_expression *existing_block, wasm_expression **exprs,
                                    int expr_count, wasm_type type, bool is_loop);
 wasm_expression *wasm_br(wasm_module *module, wasm_expression *condition, wasm_expression *break_to);
+wasm_expression *wasm_br_table(wasm_module *module, wasm_expression *condition, wasm_expression **exprs,
+                               int expr_count, wasm_expression *dflt);
 wasm_expression *wasm_call(wasm_module *module, wasm_function *fn, wasm_expression **args, int arg_count);
 wasm_expression *wasm_call_indirect(wasm_module *module, int table_index, wasm_expression *index,
                                     wasm_expression **args, int arg_count, u32 functype);